@@ -0,0 +1,146 @@
+#ifndef ASYNC_FILE_READER_H
+#define ASYNC_FILE_READER_H
+
+#include <Tokenizer.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace sob {
+
+class IoUring;
+
+/**
+ *  @brief  How the replay tools read a text stream: memory-mapped ( MappedFile + TokenReader ),
+ *              or in blocks by an AsyncTokenReader, through io_uring or through pread
+ */
+enum class ReadMode
+{
+    Mmap,
+    IoUring,
+    Pread
+}; // enum class ReadMode
+
+inline std::optional<ReadMode> toReadMode( std::string_view name )
+{
+    if ( name == "mmap" ) {
+        return ReadMode::Mmap;
+    } else if ( name == "io_uring" ) {
+        return ReadMode::IoUring;
+    } else if ( name == "pread" ) {
+        return ReadMode::Pread;
+    }
+    return std::nullopt;
+}
+
+/**
+ *  @brief  Reads a file front to back in blocks, keeping up to depth reads in flight through io_uring
+ *          The blocks are read straight into buffers registered with the ring ( IORING_OP_READ_FIXED )
+ *              and handed out in file order without any copy; a buffer goes back into flight, for the next
+ *              block, as soon as the caller asks for the following one
+ *  @NOTE   Falls back to a plain pread per block when io_uring is unavailable ( old kernel, seccomp, ... )
+ *              or not wanted, the blocks are the same either way
+ *  @NOTE   Throws std::runtime_error if the file cannot be opened or a read fails
+ */
+class AsyncFileReader
+{
+private:
+    struct Slot
+    {
+        char* data{ nullptr };
+        uint64_t offset{ 0 };
+        size_t len{ 0 };            // bytes requested
+        size_t filled{ 0 };         // bytes read so far
+        bool pending{ false };      // holds a block that has not been handed out yet
+        bool done{ false };
+    }; // struct Slot
+
+    int mFd{ -1 };
+    uint64_t mSize{ 0 };
+    const size_t mBlockSize;
+    std::vector<Slot> mSlots;
+    std::unique_ptr<char, void(*)( void* )> mBuffers;
+    std::unique_ptr<IoUring> mRing;
+
+    uint64_t mNextOffset{ 0 };      // where the next block to submit starts
+    size_t mHead{ 0 };              // the slot holding the next block in file order
+    bool mHeld{ false };            // mHead was handed out by the last next()
+
+    void submit( const size_t slot_idx );
+    void submitRemainder( const size_t slot_idx );
+    void reapOne();
+
+public:
+    static constexpr size_t DefaultBlockSize = 4u << 20;
+    static constexpr size_t DefaultDepth = 4;
+
+    AsyncFileReader( const std::string& path, const bool use_io_uring = true,
+                     const size_t block_size = DefaultBlockSize, const size_t depth = DefaultDepth );
+    ~AsyncFileReader();
+
+    AsyncFileReader( const AsyncFileReader& ) = delete;
+    AsyncFileReader& operator=( const AsyncFileReader& ) = delete;
+
+    bool usingIoUring() const
+    {
+        return mRing != nullptr;
+    }
+
+    uint64_t size() const
+    {
+        return mSize;
+    }
+
+    // the next block in file order, false at the end of the file; the view is valid until the next call
+    bool next( std::string_view& block );
+}; // class AsyncFileReader
+
+
+/**
+ *  @brief  Hands out the lines of a .stream text file a batch at a time, like TokenReader, read by an AsyncFileReader
+ *          The lines inside a block are tokenised in place, only a line cut by a block boundary is stitched
+ *              together in a small side buffer
+ *  @NOTE   The batch stays valid until the next call to next()
+ */
+class AsyncTokenReader
+{
+private:
+    AsyncFileReader mFile;
+    const size_t mBatchLines;
+    const SimdLevel mLevel;
+
+    std::string_view mBlock;
+    size_t mPos{ 0 };               // next byte of mBlock to tokenise
+    size_t mEnd{ 0 };               // one past the last '\n' of mBlock, what follows is an incomplete line
+    bool mHasBlock{ false };
+    std::string mCarry;             // the incomplete line at the end of the previous block(s)
+    std::string mStitch;            // a line put back together from mCarry and the start of a block
+
+public:
+    explicit AsyncTokenReader( const std::string& path, const bool use_io_uring = true,
+                               const size_t batch_lines = 1024, const SimdLevel level = BestSimdLevel,
+                               const size_t block_size = AsyncFileReader::DefaultBlockSize,
+                               const size_t depth = AsyncFileReader::DefaultDepth )
+    : mFile{ path, use_io_uring, block_size, depth }
+    , mBatchLines{ batch_lines }
+    , mLevel{ level }
+    {}
+
+    bool usingIoUring() const
+    {
+        return mFile.usingIoUring();
+    }
+
+    // false once the file is exhausted, otherwise batch holds at least one line
+    bool next( TokenBatch& batch );
+}; // class AsyncTokenReader
+
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,429 @@
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <Order.h>
+#include <OrderBook.h>
+#include <Trade.h>
+#include <MsgParser.h>
+#include <Message.h>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <string_view>
+
+
+namespace sob {
+
+/**
+ *  @brief  Fixed-layout binary encoding of the order, trade and snapshot streams
+ *
+ *          file   := FileHeader record*
+ *          record := RecordHeader body
+ *
+ *          body per tag:
+ *              'N' OrderBody
+ *              'C' OrderBody int32 oldId
+ *              'R' OrderBody int32 oldId, int64 oldPx, int32 oldSz
+ *              'T' TradeBody LevelBody[lvlCnt]
+ *              'S' SnapShotBody LevelBody[bidDepth] LevelBody[askDepth]
+ *
+ *          Prices are integer ticks of 1 / FileHeader::pxScale, sizes are integers
+ *  @NOTE   All fields are packed and little-endian, the decoder reads them straight out of the (mapped) buffer
+ */
+namespace bin {
+
+constexpr char Magic[4] = { 'S', 'O', 'B', 'B' };
+constexpr uint16_t Version = 1;
+constexpr uint32_t DefaultPxScale = 10000;
+
+#pragma pack(push, 1)
+struct FileHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t pxScale;
+    uint32_t reserved;
+}; // struct FileHeader
+
+struct RecordHeader
+{
+    uint8_t tag;
+    uint8_t reserved;
+    uint16_t bodyLen;
+}; // struct RecordHeader
+
+struct OrderBody
+{
+    int32_t orderId;
+    int32_t size;
+    int64_t price;
+    uint8_t isSell;
+}; // struct OrderBody
+
+struct CancelBody
+{
+    OrderBody order;
+    int32_t oldId;
+}; // struct CancelBody
+
+struct RepriceBody
+{
+    OrderBody order;
+    int32_t oldId;
+    int64_t oldPx;
+    int32_t oldSz;
+}; // struct RepriceBody
+
+struct TradeBody
+{
+    uint8_t isSell;
+    uint8_t reserved;
+    uint16_t lvlCnt;
+}; // struct TradeBody
+
+struct SnapShotBody
+{
+    uint16_t bidDepth;
+    uint16_t askDepth;
+}; // struct SnapShotBody
+
+struct LevelBody
+{
+    int64_t price;
+    int32_t quantity;
+}; // struct LevelBody
+#pragma pack(pop)
+
+static_assert( sizeof( FileHeader ) == 16 );
+static_assert( sizeof( RecordHeader ) == 4 );
+static_assert( sizeof( OrderBody ) == 17 );
+static_assert( sizeof( LevelBody ) == 12 );
+
+// the largest body a record can describe, bounds the depth of a snapshot
+constexpr size_t MaxBodyLen = UINT16_MAX;
+
+template <typename T>
+T load( const char* src )
+{
+    T out;
+    std::memcpy( &out, src, sizeof( T ) );
+    return out;
+}
+
+inline bool isBinaryStream( std::string_view data )
+{
+    return data.size() >= sizeof( FileHeader ) && std::memcmp( data.data(), Magic, sizeof( Magic ) ) == 0;
+}
+
+
+/**
+ *  @brief  A record as it sits in the buffer, nothing is copied
+ */
+struct RecordView
+{
+    char tag;
+    std::string_view body;
+
+    bool isOrder() const
+    {
+        return tag == 'N' || tag == 'C' || tag == 'R';
+    }
+}; // struct RecordView
+
+
+/**
+ *  @brief  Walks the records of a binary stream held in memory, usually a MappedFile
+ *          decode() fills the same Order / Trade / L2Book the text parsers produce, errors are reported through ParseError
+ */
+class Reader
+{
+private:
+    std::string_view mData;
+    size_t mPos{ 0 };
+    uint32_t mPxScale{ DefaultPxScale };
+
+    Price toPx( const int64_t ticks ) const
+    {
+        return Price::fromScaled( ticks, mPxScale );
+    }
+
+    void decodeOrderBody( const OrderBody& body, Order& out ) const
+    {
+        out.orderId = body.orderId;
+        out.isSell = body.isSell != 0;
+        out.size = body.size;
+        out.price = toPx( body.price );
+        out.bIsCancel = false;
+        out.bIsReprice = false;
+        out.oldId.reset();
+        out.oldPx.reset();
+        out.oldSz.reset();
+    }
+
+    template <typename Comparator>
+    void decodeSide( const char* src, const int depth, OneSideBook<L2PriceLevel, Comparator>& side ) const
+    {
+        for ( int i = 0; i < depth; i++ ) {
+            const auto lvl = load<LevelBody>( src + i * sizeof( LevelBody ) );
+            const Price px = toPx( lvl.price );
+            side[px] = L2PriceLevel{ px, lvl.quantity };
+        }
+    }
+
+public:
+    // throws std::runtime_error if data does not start with a valid FileHeader
+    explicit Reader( std::string_view data )
+    : mData{ data }
+    {
+        if ( !isBinaryStream( data ) ) {
+            throw std::runtime_error( "[bin::Reader::Reader] not a binary stream" );
+        }
+        const auto header = load<FileHeader>( data.data() );
+        if ( header.version != Version || header.pxScale == 0 || header.headerSize < sizeof( FileHeader ) ) {
+            throw std::runtime_error( "[bin::Reader::Reader] unsupported binary stream header" );
+        }
+        mPxScale = header.pxScale;
+        mPos = header.headerSize;
+    }
+
+    uint32_t pxScale() const
+    {
+        return mPxScale;
+    }
+
+    // byte offset of the next record, what a StreamIndex records
+    size_t position() const
+    {
+        return mPos;
+    }
+
+    // continue from a record boundary obtained through position(), e.g. from a StreamIndex
+    void seek( const size_t pos )
+    {
+        mPos = pos;
+    }
+
+    // false at the end of the stream or on a truncated record
+    bool next( RecordView& rec )
+    {
+        if ( mPos + sizeof( RecordHeader ) > mData.size() ) {
+            return false;
+        }
+        const auto header = load<RecordHeader>( mData.data() + mPos );
+        const size_t body_pos = mPos + sizeof( RecordHeader );
+        if ( body_pos + header.bodyLen > mData.size() ) {
+            return false;
+        }
+        rec.tag = static_cast<char>( header.tag );
+        rec.body = mData.substr( body_pos, header.bodyLen );
+        mPos = body_pos + header.bodyLen;
+        return true;
+    }
+
+    ParseError decode( const RecordView& rec, Order& out ) const
+    {
+        const char* src = rec.body.data();
+        switch ( rec.tag )
+        {
+            case 'N': {
+                if ( rec.body.size() != sizeof( OrderBody ) ) {
+                    return ParseError::MissingField;
+                }
+                decodeOrderBody( load<OrderBody>( src ), out );
+                return ParseError::Ok;
+            }
+            case 'C': {
+                if ( rec.body.size() != sizeof( CancelBody ) ) {
+                    return ParseError::MissingField;
+                }
+                const auto body = load<CancelBody>( src );
+                decodeOrderBody( body.order, out );
+                out.bIsCancel = true;
+                out.oldId = body.oldId;
+                return ParseError::Ok;
+            }
+            case 'R': {
+                if ( rec.body.size() != sizeof( RepriceBody ) ) {
+                    return ParseError::MissingField;
+                }
+                const auto body = load<RepriceBody>( src );
+                decodeOrderBody( body.order, out );
+                out.bIsReprice = true;
+                out.oldId = body.oldId;
+                out.oldPx = toPx( body.oldPx );
+                out.oldSz = body.oldSz;
+                return ParseError::Ok;
+            }
+            default:
+                return ParseError::UnknownType;
+        }
+    }
+
+    ParseError decode( const RecordView& rec, Trade& out ) const
+    {
+        if ( rec.tag != 'T' ) {
+            return ParseError::UnknownType;
+        }
+        if ( rec.body.size() < sizeof( TradeBody ) ) {
+            return ParseError::MissingField;
+        }
+        const auto body = load<TradeBody>( rec.body.data() );
+        // a trade crosses at least one level, as in Trade::parse
+        if ( body.lvlCnt == 0 || rec.body.size() != sizeof( TradeBody ) + body.lvlCnt * sizeof( LevelBody ) ) {
+            return ParseError::MissingField;
+        }
+
+        out.isSell = body.isSell != 0;
+        out.price.clear();
+        out.volume.clear();
+        const char* src = rec.body.data() + sizeof( TradeBody );
+        for ( int i = 0; i < body.lvlCnt; i++ ) {
+            const auto lvl = load<LevelBody>( src + i * sizeof( LevelBody ) );
+            out.price.push_back( toPx( lvl.price ) );
+            out.volume.push_back( lvl.quantity );
+        }
+        return ParseError::Ok;
+    }
+
+    ParseError decode( const RecordView& rec, L2Book& out ) const
+    {
+        if ( rec.tag != 'S' ) {
+            return ParseError::UnknownType;
+        }
+        if ( rec.body.size() < sizeof( SnapShotBody ) ) {
+            return ParseError::MissingField;
+        }
+        const auto body = load<SnapShotBody>( rec.body.data() );
+        const int depth = body.bidDepth + body.askDepth;
+        if ( rec.body.size() != sizeof( SnapShotBody ) + depth * sizeof( LevelBody ) ) {
+            return ParseError::MissingField;
+        }
+
+        out.clear();
+        const char* src = rec.body.data() + sizeof( SnapShotBody );
+        decodeSide( src, body.bidDepth, out.getBidSide() );
+        decodeSide( src + body.bidDepth * sizeof( LevelBody ), body.askDepth, out.getAskSide() );
+        return ParseError::Ok;
+    }
+    // decode any record, the alternative held by msg is reused when it already matches the tag
+    ParseError decode( const RecordView& rec, Message& msg ) const
+    {
+        if ( rec.isOrder() ) {
+            if ( !std::holds_alternative<Order>( msg ) ) {
+                msg.emplace<Order>();
+            }
+            return decode( rec, std::get<Order>( msg ) );
+        } else if ( rec.tag == 'T' ) {
+            if ( !std::holds_alternative<Trade>( msg ) ) {
+                msg.emplace<Trade>();
+            }
+            return decode( rec, std::get<Trade>( msg ) );
+        } else if ( rec.tag == 'S' ) {
+            if ( !std::holds_alternative<L2Book>( msg ) ) {
+                msg.emplace<L2Book>();
+            }
+            return decode( rec, std::get<L2Book>( msg ) );
+        }
+        return ParseError::UnknownType;
+    }
+}; // class Reader
+
+
+/**
+ *  @brief  Appends binary records to a std::string, the FileHeader is written on construction
+ *  @NOTE   Prices are rounded to the nearest tick of 1 / pxScale
+ */
+class Writer
+{
+private:
+    std::string& mOut;
+    uint32_t mPxScale;
+
+    int64_t toTicks( const Price px ) const
+    {
+        return px.toScaled( mPxScale );
+    }
+
+    template <typename T>
+    void append( const T& val )
+    {
+        mOut.append( reinterpret_cast<const char*>( &val ), sizeof( T ) );
+    }
+
+    void appendHeader( const char tag, const size_t body_len )
+    {
+        if ( body_len > MaxBodyLen ) {
+            throw std::runtime_error( "[bin::Writer] message too large for one binary record" );
+        }
+        append( RecordHeader{ static_cast<uint8_t>( tag ), 0, static_cast<uint16_t>( body_len ) } );
+    }
+
+    OrderBody toOrderBody( const Order& order ) const
+    {
+        return OrderBody{ order.orderId, order.size, toTicks( order.price ), static_cast<uint8_t>( order.isSell ? 1 : 0 ) };
+    }
+
+    template <typename Comparator>
+    void appendSide( const OneSideBook<L2PriceLevel, Comparator>& side )
+    {
+        for ( const auto& [px, lvl]: side ) {
+            append( LevelBody{ toTicks( px ), lvl.quantity } );
+        }
+    }
+
+public:
+    explicit Writer( std::string& out, const uint32_t pxScale = DefaultPxScale )
+    : mOut{ out }
+    , mPxScale{ pxScale }
+    {
+        FileHeader header{};
+        std::memcpy( header.magic, Magic, sizeof( Magic ) );
+        header.version = Version;
+        header.headerSize = sizeof( FileHeader );
+        header.pxScale = pxScale;
+        append( header );
+    }
+
+    void write( const Order& order )
+    {
+        if ( order.isCancel() ) {
+            appendHeader( 'C', sizeof( CancelBody ) );
+            append( CancelBody{ toOrderBody( order ), *order.oldId } );
+        } else if ( order.isReprice() ) {
+            appendHeader( 'R', sizeof( RepriceBody ) );
+            append( RepriceBody{ toOrderBody( order ), *order.oldId, toTicks( *order.oldPx ), *order.oldSz } );
+        } else {
+            appendHeader( 'N', sizeof( OrderBody ) );
+            append( toOrderBody( order ) );
+        }
+    }
+
+    void write( const Trade& trade )
+    {
+        const auto lvl_cnt = trade.price.size();
+        appendHeader( 'T', sizeof( TradeBody ) + lvl_cnt * sizeof( LevelBody ) );
+        append( TradeBody{ static_cast<uint8_t>( trade.isSell ? 1 : 0 ), 0, static_cast<uint16_t>( lvl_cnt ) } );
+        for ( size_t i = 0; i < lvl_cnt; i++ ) {
+            append( LevelBody{ toTicks( trade.price[i] ), trade.volume[i] } );
+        }
+    }
+
+    void write( L2Book& snapshot )
+    {
+        const auto bid_depth = snapshot.getBidSideDepth();
+        const auto ask_depth = snapshot.getAskSideDepth();
+        appendHeader( 'S', sizeof( SnapShotBody ) + ( bid_depth + ask_depth ) * sizeof( LevelBody ) );
+        append( SnapShotBody{ static_cast<uint16_t>( bid_depth ), static_cast<uint16_t>( ask_depth ) } );
+        appendSide( snapshot.getBidSide() );
+        appendSide( snapshot.getAskSide() );
+    }
+}; // class Writer
+
+} // namespace bin
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef BOOK_MIRROR_H
+#define BOOK_MIRROR_H
+
+#include <SmartOrderBook.h>
+#include <GuessOverlay.h>
+#include <Message.h>
+#include <SpscQueue.h>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+
+namespace sob {
+
+/**
+ *  @brief  Copies of the leader book of a SmartOrderBook for the threads other than the one updating it, made on a
+ *              helper thread so that the updating one never pays for them
+ *          The updating thread hands every message over with push(), before applying it itself; the helper applies it
+ *              to a SmartOrderBook of its own and, once it runs out of messages or every MaxBatch of them, brings
+ *              the back one of two copies in line and swaps it in for the front one, the one latest() hands out
+ *  @NOTE   push() copies the message into a slot of an SPSC ring, the book itself is never copied there. A slot keeps
+ *              an Order, a Trade and an L2Book of its own, copying one in reuses the vectors and the map nodes the last
+ *              of its kind left there: a trade or a snapshot deeper than any the slot held before is the only thing
+ *              that allocates on the updating thread
+ *          the copies are synced through L3Book::syncTo, in the levels touched over the last two rounds
+ *  @NOTE   a copy some reader still holds when its turn comes is left to it, a new one takes its place
+ *              and gets a full copy; push() and close() from one thread only, latest() from any
+ */
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
+class BookMirror
+{
+public:
+    using Book = L3Book<BuffType, SideType, Alloc>;
+    using GuessBook = GuessOverlay<Book>;
+
+    static constexpr size_t DefaultCapacity = 4096;
+    static constexpr size_t MaxBatch = 1024;
+
+    /**
+     *  @brief  one published copy, never updated once handed out
+     */
+    class Copy
+    {
+    private:
+        Book mBook;
+        GuessBook mGuess{ mBook };
+        size_t mMessages{ 0 };
+
+        friend class BookMirror;
+
+    public:
+        Copy() = default;
+        Copy( const Copy& ) = delete;
+        Copy& operator=( const Copy& ) = delete;
+
+        // as SmartOrderBook::getLeaderView
+        const GuessBook& leader() const
+        {
+            return mGuess;
+        }
+
+        const Book& groundTruth() const
+        {
+            return mBook;
+        }
+
+        // how many of the messages pushed it is up to
+        size_t messages() const
+        {
+            return mMessages;
+        }
+    }; // class Copy
+
+private:
+    // a message of each kind, kind telling which one was pushed, as the index of its type in Message
+    struct Slot
+    {
+        std::tuple<Order, Trade, L2Book> msgs;
+        size_t kind{ 0 };
+    }; // struct Slot
+
+    template <typename Msg>
+    static constexpr size_t KindOf = std::is_same_v<Msg, Order> ? 0 : ( std::is_same_v<Msg, Trade> ? 1 : 2 );
+
+    SmartOrderBook<BuffType, SideType, Alloc> mReplica;     // the helper's alone
+    SpscQueue<Slot> mQueue;
+
+    std::shared_ptr<Copy> mFront;       // through std::atomic_load / std::atomic_exchange only
+    std::shared_ptr<Copy> mBack;        // the helper's
+
+    std::atomic<bool> mStopped{ false };
+    std::exception_ptr mError;
+    std::thread mWorker;                // last, started once the rest is in place
+
+    /**
+     *  @brief  whether no reader holds the back copy any longer, it has been out of latest() since the last swap
+     *  @NOTE   use_count() alone does not order the last reads of the readers before what is written next,
+     *              dropping a reference of our own does: that decrement synchronises with theirs
+     */
+    bool backUnshared()
+    {
+        if ( mBack.use_count() > 1 ) {
+            return false;
+        }
+        std::shared_ptr<Copy>{ mBack }.reset();
+        return true;
+    }
+
+    void publish( const size_t applied )
+    {
+        if ( !backUnshared() ) {
+            mBack = std::make_shared<Copy>();
+        }
+        mReplica.syncGroundTruthTo( mBack->mBook );
+        mBack->mGuess.assign( mReplica.getLeaderView() );
+        mBack->mMessages = applied;
+        mBack = std::atomic_exchange( &mFront, std::move( mBack ) );
+    }
+
+    void apply( Slot& slot )
+    {
+        switch ( slot.kind ) {
+            case KindOf<Order>:
+                mReplica.applyMessage( std::get<Order>( slot.msgs ) );
+                return;
+            case KindOf<Trade>:
+                mReplica.applyMessage( std::get<Trade>( slot.msgs ) );
+                return;
+            default:
+                mReplica.applyMessage( std::get<L2Book>( slot.msgs ) );
+                return;
+        }
+    }
+
+    void run()
+    {
+        try {
+            size_t applied = 0;
+            size_t unpublished = 0;
+            while ( true ) {
+                Slot* slot = mQueue.front();
+                if ( slot == nullptr ) {
+                    if ( unpublished > 0 ) {
+                        publish( applied );
+                        unpublished = 0;
+                    }
+                    if ( mQueue.drained() ) {
+                        break;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+                apply( *slot );
+                mQueue.pop();
+                applied++;
+                if ( ++unpublished == MaxBatch ) {
+                    publish( applied );
+                    unpublished = 0;
+                }
+            }
+        } catch ( ... ) {
+            mError = std::current_exception();
+        }
+        mStopped.store( true, std::memory_order_release );
+    }
+
+public:
+    explicit BookMirror( const size_t capacity = DefaultCapacity )
+    : mQueue{ capacity }
+    , mFront{ std::make_shared<Copy>() }
+    , mBack{ std::make_shared<Copy>() }
+    , mWorker{ [this]() { run(); } }
+    {}
+
+    BookMirror( const BookMirror& ) = delete;
+    BookMirror& operator=( const BookMirror& ) = delete;
+
+    ~BookMirror()
+    {
+        if ( mWorker.joinable() ) {
+            mQueue.close();
+            mWorker.join();
+        }
+    }
+
+    /**
+     *  @brief  hand a message over, an Order, a Trade or an L2Book, copied onto the one of its kind in the next slot;
+     *              waits while the ring is full
+     *  @NOTE   the books update the orders they are given in place, push before applying
+     */
+    template <typename Msg>
+    void push( const Msg& msg )
+    {
+        static_assert( std::is_same_v<Msg, Order> || std::is_same_v<Msg, Trade> || std::is_same_v<Msg, L2Book> );
+        Slot* slot = mQueue.acquire();
+        while ( slot == nullptr ) {
+            if ( mStopped.load( std::memory_order_acquire ) ) {
+                throw std::runtime_error( "[BookMirror::push] the mirror has stopped" );
+            }
+            std::this_thread::yield();
+            slot = mQueue.acquire();
+        }
+        std::get<Msg>( slot->msgs ) = msg;
+        slot->kind = KindOf<Msg>;
+        mQueue.publish();
+    }
+
+    // whichever the Message holds
+    void push( const Message& msg )
+    {
+        std::visit( [this]( const auto& m ) { push( m ); }, msg );
+    }
+
+    /**
+     *  @brief  no more messages: waits for the helper to apply and publish those pushed so far
+     *  @NOTE   rethrows what stopped the helper, if anything did
+     */
+    void close()
+    {
+        if ( mWorker.joinable() ) {
+            mQueue.close();
+            mWorker.join();
+        }
+        if ( mError ) {
+            std::rethrow_exception( mError );
+        }
+    }
+
+    // the latest copy, which the helper leaves alone as long as it is held
+    std::shared_ptr<const Copy> latest() const
+    {
+        return std::atomic_load( &mFront );
+    }
+}; // class BookMirror
+
+} // namespace sob
+
+
+#endif
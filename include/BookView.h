@@ -0,0 +1,174 @@
+#ifndef BOOK_VIEW_H
+#define BOOK_VIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <Order.h>
+
+
+namespace sob {
+
+/**
+ *  @brief  The live orders of a level in time priority, a non-owning range over its buffer
+ *          The canceled orders a circular_buffer level still holds are stepped over, see L3PriceLevel::cancel
+ *  @NOTE   Valid until the level is next updated, as the iterators of its buffer are
+ */
+template <typename It>
+class LiveOrders
+{
+public:
+    class iterator
+    {
+    private:
+        It mIt{};
+        It mEnd{};
+
+        friend class LiveOrders;
+        iterator( It it, It end ): mIt( it ), mEnd( end )
+        {
+            skip();
+        }
+
+        void skip()
+        {
+            while ( mIt != mEnd && mIt->dead ) {
+                ++mIt;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RestingOrder;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const RestingOrder*;
+        using reference = const RestingOrder&;
+
+        iterator() = default;
+
+        reference operator*() const
+        {
+            return *mIt;
+        }
+
+        pointer operator->() const
+        {
+            return &*mIt;
+        }
+
+        iterator& operator++()
+        {
+            ++mIt;
+            skip();
+            return *this;
+        }
+
+        iterator operator++( int )
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==( const iterator& lhs, const iterator& rhs )
+        {
+            return lhs.mIt == rhs.mIt;
+        }
+
+        friend bool operator!=( const iterator& lhs, const iterator& rhs )
+        {
+            return lhs.mIt != rhs.mIt;
+        }
+    }; // class iterator
+
+private:
+    It mBegin{};
+    It mEnd{};
+
+public:
+    LiveOrders() = default;
+
+    LiveOrders( It begin, It end ): mBegin( begin ), mEnd( end )
+    {}
+
+    iterator begin() const
+    {
+        return iterator( mBegin, mEnd );
+    }
+
+    iterator end() const
+    {
+        return iterator( mEnd, mEnd );
+    }
+
+    bool empty() const
+    {
+        return begin() == end();
+    }
+}; // class LiveOrders
+
+
+/**
+ *  @brief  A read-only handle on one level of an L3Book, nothing is copied: what it reads is the level itself
+ *          Empty, and false, when the side it was taken from has no level
+ *  @NOTE   Valid until the book is next updated, a level may go with any order applied
+ */
+template <typename Level>
+class LevelView
+{
+private:
+    const Level* mLevel{ nullptr };
+
+public:
+    using OrderRange = LiveOrders<typename Level::OrderIt>;
+
+    LevelView() = default;
+
+    explicit LevelView( const Level& level ): mLevel( &level )
+    {}
+
+    explicit operator bool() const
+    {
+        return mLevel != nullptr;
+    }
+
+    Price price() const
+    {
+        return mLevel->price;
+    }
+
+    int quantity() const
+    {
+        return mLevel->quantity;
+    }
+
+    int numOrders() const
+    {
+        return mLevel->numOrders;
+    }
+
+    // the order first in the queue, a level always holds a live one there unless it is empty
+    const RestingOrder& front() const
+    {
+        return mLevel->orders.front();
+    }
+
+    OrderRange orders() const
+    {
+        return OrderRange( mLevel->orders.begin(), mLevel->orders.end() );
+    }
+
+    L2PriceLevel toL2PriceLevel() const
+    {
+        return mLevel ? mLevel->toL2PriceLevel() : L2PriceLevel{};
+    }
+
+    const Level& level() const
+    {
+        return *mLevel;
+    }
+}; // class LevelView
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef CHUNKED_DECODER_H
+#define CHUNKED_DECODER_H
+
+#include <StreamIndex.h>
+#include <BinaryFormat.h>
+#include <Message.h>
+#include <Tokenizer.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <future>
+#include <string_view>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  Decodes a stream chunk by chunk on worker threads, the chunks are cut on StreamIndex entries
+ *          The decoded chunks are handed to on_chunk( Message* msgs, size_t cnt ) on the calling thread,
+ *              strictly in stream order, so whatever consumes them sees exactly the serial sequence
+ *  @NOTE   Two waves of chunks are in flight: the workers decode wave n + 1 while wave n is being consumed
+ *  @NOTE   Malformed messages are skipped with a warning, empty lines silently
+ */
+class ChunkedDecoder
+{
+private:
+    std::string_view mData;
+    const StreamIndex& mIndex;
+    const size_t mThreads;
+    const size_t mEntriesPerChunk;
+    const bool mIsBinary;
+
+    struct Chunk
+    {
+        std::vector<Message> msgs;      // grows to the largest chunk, the Messages are decoded in place
+        size_t cnt{ 0 };
+        TokenBatch batch;
+
+        Message& nextSlot()
+        {
+            if ( cnt == msgs.size() ) {
+                msgs.emplace_back();
+            }
+            return msgs[cnt];
+        }
+    }; // struct Chunk
+
+    void decodeText( std::string_view bytes, Chunk& chunk ) const
+    {
+        size_t pos{ 0 };
+        while ( pos < bytes.size() ) {
+            pos += Tokenizer::tokenize( bytes.substr( pos ), TokenReader::DefaultBatchLines, chunk.batch );
+            for ( size_t i = 0; i < chunk.batch.lines(); i++ ) {
+                const auto err = decodeMessage( chunk.batch, i, chunk.nextSlot() );
+                if ( err == ParseError::Ok ) {
+                    chunk.cnt++;
+                } else if ( err != ParseError::Empty ) {
+                    spdlog::warn( "[ChunkedDecoder::decodeText] skipping line \"{}\", the error: {}",
+                                  chunk.batch.line( i ), toString( err ) );
+                }
+            }
+        }
+    }
+
+    void decodeBinary( const size_t begin, const size_t end, Chunk& chunk ) const
+    {
+        // the reader checks the file header, the records are then taken from [begin, end) only
+        bin::Reader reader{ mData.substr( 0, end ) };
+        reader.seek( begin );
+        bin::RecordView rec;
+        while ( reader.next( rec ) ) {
+            const auto err = reader.decode( rec, chunk.nextSlot() );
+            if ( err == ParseError::Ok ) {
+                chunk.cnt++;
+            } else {
+                spdlog::warn( "[ChunkedDecoder::decodeBinary] skipping record with tag '{}', the error: {}",
+                              rec.tag, toString( err ) );
+            }
+        }
+    }
+
+    // the chunk starting at index entry first_entry, or at byte begin if that is further in
+    void decode( const size_t first_entry, size_t begin, Chunk& chunk ) const
+    {
+        chunk.cnt = 0;
+        begin = std::max<size_t>( begin, mIndex.offset( first_entry ) );
+        const size_t end = mIndex.offset( std::min( first_entry + mEntriesPerChunk, mIndex.entries() ) );
+        if ( mIsBinary ) {
+            decodeBinary( begin, end, chunk );
+        } else {
+            decodeText( mData.substr( begin, end - begin ), chunk );
+        }
+    }
+
+public:
+    static constexpr size_t DefaultEntriesPerChunk = 16;
+
+    ChunkedDecoder( std::string_view data, const StreamIndex& index, const size_t threads,
+                    const size_t entries_per_chunk = DefaultEntriesPerChunk )
+    : mData{ data }
+    , mIndex{ index }
+    , mThreads{ std::max<size_t>( threads, 1 ) }
+    , mEntriesPerChunk{ std::max<size_t>( entries_per_chunk, 1 ) }
+    , mIsBinary{ bin::isBinaryStream( data ) }
+    {}
+
+    // decode from message start_msg to the end of the stream
+    template <typename OnChunk>
+    void run( OnChunk&& on_chunk, const uint64_t start_msg = 0 )
+    {
+        std::vector<Chunk> chunks( 2 * mThreads );
+        std::vector<std::future<void>> pending( 2 * mThreads );
+        size_t next_entry = mIndex.entryFor( start_msg );
+        const size_t start = mIndex.offsetOf( mData, start_msg );
+
+        // wave w uses the chunks [ ( w % 2 ) * mThreads, ( w % 2 + 1 ) * mThreads )
+        const auto launch = [&]( const size_t wave ) {
+            for ( size_t i = 0; i < mThreads && next_entry < mIndex.entries(); i++ ) {
+                auto& chunk = chunks[ ( wave % 2 ) * mThreads + i ];
+                pending[ ( wave % 2 ) * mThreads + i ] = std::async( std::launch::async,
+                    [this, &chunk, start, entry = next_entry]() { decode( entry, start, chunk ); } );
+                next_entry += mEntriesPerChunk;
+            }
+        };
+
+        launch( 0 );
+        for ( size_t wave = 0; ; wave++ ) {
+            const size_t base = ( wave % 2 ) * mThreads;
+            if ( !pending[base].valid() ) {
+                break;
+            }
+            launch( wave + 1 );
+            for ( size_t i = 0; i < mThreads && pending[base + i].valid(); i++ ) {
+                pending[base + i].get();
+                on_chunk( chunks[base + i].msgs.data(), chunks[base + i].cnt );
+            }
+        }
+    }
+}; // class ChunkedDecoder
+
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,605 @@
+#ifndef COLUMNAR_FORMAT_H
+#define COLUMNAR_FORMAT_H
+
+#include <BinaryFormat.h>
+#include <Order.h>
+#include <OrderBook.h>
+#include <Trade.h>
+#include <Message.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  Columnar archive of the order, trade and snapshot streams, for long-term storage and research replays
+ *
+ *          file  := FileHeader block*
+ *          block := BlockHeader column[ColumnCount]
+ *
+ *          A block holds up to blockMsgs messages, every field kind goes to its own column:
+ *              Tags    4 bits per message, the index of the tag in Tags, packed low nibble first
+ *              Sides   one bit per order and trade, packed LSB first
+ *              Ids     orderId, then oldId for 'C' / 'R'; zigzag varint of the delta to the previous id
+ *              Sizes   size, then oldSz for 'R', then the level quantities of 'T' / 'S';
+ *                          zigzag varint, in units of the block's szStep
+ *              Prices  price, then oldPx for 'R', then the level prices of 'T' / 'S';
+ *                          zigzag varint of the delta to the previous price, in units of the block's pxStep ticks
+ *              Counts  lvlCnt for 'T', bidDepth askDepth for 'S'; varint
+ *
+ *          szStep and pxStep are the greatest common divisors of the block's sizes and prices, the lot size and
+ *              the tick size in practice, so a move of one tick costs one byte whatever pxScale is
+ *          The deltas restart from 0 at every block, so a block decodes on its own, and the BlockHeader carries
+ *              the message count and the length of every column, so whole blocks are skipped without decoding
+ *  @NOTE   The FileHeader is the one of the binary format, with its own magic
+ */
+namespace col {
+
+constexpr char Magic[4] = { 'S', 'O', 'B', 'C' };
+constexpr uint16_t Version = 1;
+constexpr size_t DefaultBlockMsgs = 4096;
+constexpr char Tags[] = { 'N', 'C', 'R', 'T', 'S' };
+
+enum Column : uint8_t
+{
+    TagCol,
+    Sides,
+    Ids,
+    Sizes,
+    Prices,
+    Counts,
+    ColumnCount
+}; // enum Column
+
+using FileHeader = bin::FileHeader;
+
+#pragma pack(push, 1)
+struct BlockHeader
+{
+    uint32_t msgCnt;
+    uint32_t szStep;
+    uint64_t pxStep;
+    uint32_t colLen[ColumnCount];
+
+    size_t bodyLen() const
+    {
+        size_t res{ 0 };
+        for ( const auto len: colLen ) {
+            res += len;
+        }
+        return res;
+    }
+}; // struct BlockHeader
+#pragma pack(pop)
+
+static_assert( sizeof( BlockHeader ) == 16 + 4 * ColumnCount );
+
+inline bool isArchive( std::string_view data )
+{
+    return data.size() >= sizeof( FileHeader ) && std::memcmp( data.data(), Magic, sizeof( Magic ) ) == 0;
+}
+
+inline uint64_t zigzag( const int64_t val )
+{
+    return ( static_cast<uint64_t>( val ) << 1 ) ^ static_cast<uint64_t>( val >> 63 );
+}
+
+inline int64_t unzigzag( const uint64_t val )
+{
+    return static_cast<int64_t>( val >> 1 ) ^ -static_cast<int64_t>( val & 1 );
+}
+
+inline void putVarint( std::string& out, uint64_t val )
+{
+    while ( val >= 0x80 ) {
+        out.push_back( static_cast<char>( val | 0x80 ) );
+        val >>= 7;
+    }
+    out.push_back( static_cast<char>( val ) );
+}
+
+
+/**
+ *  @brief  Reads one column of the current block, every read is bounds checked
+ *  @NOTE   Throws std::runtime_error when the column ends early, i.e. the archive is corrupt
+ */
+class ColumnCursor
+{
+private:
+    const uint8_t* mPos{ nullptr };
+    const uint8_t* mEnd{ nullptr };
+
+    [[noreturn]] static void overrun()
+    {
+        throw std::runtime_error( "[col::ColumnCursor] column ends early, corrupt archive" );
+    }
+
+public:
+    ColumnCursor() = default;
+
+    explicit ColumnCursor( std::string_view col )
+    : mPos{ reinterpret_cast<const uint8_t*>( col.data() ) }
+    , mEnd{ reinterpret_cast<const uint8_t*>( col.data() ) + col.size() }
+    {}
+
+    uint8_t byte()
+    {
+        if ( mPos == mEnd ) {
+            overrun();
+        }
+        return *mPos++;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t res{ 0 };
+        for ( unsigned shift = 0; shift < 64; shift += 7 ) {
+            const auto b = byte();
+            res |= static_cast<uint64_t>( b & 0x7f ) << shift;
+            if ( ( b & 0x80 ) == 0 ) {
+                return res;
+            }
+        }
+        overrun();
+    }
+
+    int64_t svarint()
+    {
+        return unzigzag( varint() );
+    }
+}; // class ColumnCursor
+
+
+/**
+ *  @brief  Walks the blocks of an archive held in memory, usually a MappedFile, decoding a message at a time
+ *          next() fills the same Order / Trade / L2Book the text parsers produce, reusing what msg already holds
+ *  @NOTE   Throws std::runtime_error on a bad FileHeader or a corrupt block; a truncated last block ends the archive
+ */
+class Reader
+{
+private:
+    std::string_view mData;
+    size_t mPos{ 0 };               // the next block header
+    uint32_t mPxScale{ bin::DefaultPxScale };
+
+    uint32_t mLeft{ 0 };            // messages left in the current block
+    ColumnCursor mCols[ColumnCount];
+    int64_t mSzStep{ 1 };
+    int64_t mPxStep{ 1 };
+    uint8_t mTagByte{ 0 };
+    bool mTagHigh{ false };         // the next tag is the high nibble of mTagByte
+    uint8_t mSideByte{ 0 };
+    unsigned mSideBit{ 8 };
+    int64_t mLastId{ 0 };
+    int64_t mLastPx{ 0 };
+
+    Price toPx( const int64_t ticks ) const
+    {
+        return Price::fromScaled( ticks, mPxScale );
+    }
+
+    // false at the end of the archive or on a truncated block
+    bool peekBlock( BlockHeader& header, size_t& body_len ) const
+    {
+        if ( mPos + sizeof( BlockHeader ) > mData.size() ) {
+            return false;
+        }
+        header = bin::load<BlockHeader>( mData.data() + mPos );
+        body_len = header.bodyLen();
+        return mPos + sizeof( BlockHeader ) + body_len <= mData.size();
+    }
+
+    bool openBlock()
+    {
+        BlockHeader header;
+        size_t body_len;
+        if ( !peekBlock( header, body_len ) ) {
+            return false;
+        }
+        size_t col_pos = mPos + sizeof( BlockHeader );
+        for ( size_t i = 0; i < ColumnCount; i++ ) {
+            mCols[i] = ColumnCursor{ mData.substr( col_pos, header.colLen[i] ) };
+            col_pos += header.colLen[i];
+        }
+        mPos = col_pos;
+        mLeft = header.msgCnt;
+        mSzStep = header.szStep;
+        mPxStep = static_cast<int64_t>( header.pxStep );
+        mTagHigh = false;
+        mSideBit = 8;
+        mLastId = 0;
+        mLastPx = 0;
+        return true;
+    }
+
+    char tag()
+    {
+        uint8_t idx;
+        if ( mTagHigh ) {
+            idx = mTagByte >> 4;
+        } else {
+            mTagByte = mCols[TagCol].byte();
+            idx = mTagByte & 0x0f;
+        }
+        mTagHigh = !mTagHigh;
+        if ( idx >= sizeof( Tags ) ) {
+            throw std::runtime_error( "[col::Reader::tag] unknown tag, corrupt archive" );
+        }
+        return Tags[idx];
+    }
+
+    bool side()
+    {
+        if ( mSideBit == 8 ) {
+            mSideByte = mCols[Sides].byte();
+            mSideBit = 0;
+        }
+        return ( mSideByte >> mSideBit++ ) & 1;
+    }
+
+    int id()
+    {
+        mLastId += mCols[Ids].svarint();
+        return static_cast<int>( mLastId );
+    }
+
+    int quantity()
+    {
+        return static_cast<int>( mCols[Sizes].svarint() * mSzStep );
+    }
+
+    Price price()
+    {
+        mLastPx += mCols[Prices].svarint() * mPxStep;
+        return toPx( mLastPx );
+    }
+
+    void decodeOrder( const char tag, Order& out )
+    {
+        out.isSell = side();
+        out.orderId = id();
+        out.size = quantity();
+        out.price = price();
+        out.bIsCancel = tag == 'C';
+        out.bIsReprice = tag == 'R';
+        out.oldId.reset();
+        out.oldPx.reset();
+        out.oldSz.reset();
+        if ( tag != 'N' ) {
+            out.oldId = id();
+        }
+        if ( tag == 'R' ) {
+            out.oldPx = price();
+            out.oldSz = quantity();
+        }
+    }
+
+    void decodeTrade( Trade& out )
+    {
+        out.isSell = side();
+        const auto lvl_cnt = mCols[Counts].varint();
+        if ( lvl_cnt == 0 ) {
+            throw std::runtime_error( "[col::Reader::decodeTrade] trade without a level, corrupt archive" );
+        }
+        out.price.clear();
+        out.volume.clear();
+        for ( uint64_t i = 0; i < lvl_cnt; i++ ) {
+            out.price.push_back( price() );
+            out.volume.push_back( quantity() );
+        }
+    }
+
+    template <typename Comparator>
+    void decodeSide( const uint64_t depth, OneSideBook<L2PriceLevel, Comparator>& side )
+    {
+        for ( uint64_t i = 0; i < depth; i++ ) {
+            const Price px = price();
+            side[px] = L2PriceLevel{ px, quantity() };
+        }
+    }
+
+    void decodeSnapShot( L2Book& out )
+    {
+        const auto bid_depth = mCols[Counts].varint();
+        const auto ask_depth = mCols[Counts].varint();
+        out.clear();
+        decodeSide( bid_depth, out.getBidSide() );
+        decodeSide( ask_depth, out.getAskSide() );
+    }
+
+public:
+    explicit Reader( std::string_view data )
+    : mData{ data }
+    {
+        if ( !isArchive( data ) ) {
+            throw std::runtime_error( "[col::Reader::Reader] not a columnar archive" );
+        }
+        const auto header = bin::load<FileHeader>( data.data() );
+        if ( header.version != Version || header.pxScale == 0 || header.headerSize < sizeof( FileHeader ) ) {
+            throw std::runtime_error( "[col::Reader::Reader] unsupported archive header" );
+        }
+        mPxScale = header.pxScale;
+        mPos = header.headerSize;
+    }
+
+    uint32_t pxScale() const
+    {
+        return mPxScale;
+    }
+
+    // false at the end of the archive; if msg already holds the right alternative it is decoded in place
+    bool next( Message& msg )
+    {
+        while ( mLeft == 0 ) {
+            if ( !openBlock() ) {
+                return false;
+            }
+        }
+        mLeft--;
+
+        const auto tag = this->tag();
+        switch ( tag )
+        {
+            case 'T':
+                if ( !std::holds_alternative<Trade>( msg ) ) {
+                    msg.emplace<Trade>();
+                }
+                decodeTrade( std::get<Trade>( msg ) );
+                return true;
+            case 'S':
+                if ( !std::holds_alternative<L2Book>( msg ) ) {
+                    msg.emplace<L2Book>();
+                }
+                decodeSnapShot( std::get<L2Book>( msg ) );
+                return true;
+            default:
+                if ( !std::holds_alternative<Order>( msg ) ) {
+                    msg.emplace<Order>();
+                }
+                decodeOrder( tag, std::get<Order>( msg ) );
+                return true;
+        }
+    }
+
+    // skip up to cnt messages, whole blocks are stepped over through their headers; returns how many were skipped
+    uint64_t skip( const uint64_t cnt )
+    {
+        uint64_t done{ 0 };
+        Message scratch;
+        while ( done < cnt ) {
+            if ( mLeft == 0 ) {
+                BlockHeader header;
+                size_t body_len;
+                if ( !peekBlock( header, body_len ) ) {
+                    break;
+                }
+                if ( header.msgCnt <= cnt - done ) {
+                    mPos += sizeof( BlockHeader ) + body_len;
+                    done += header.msgCnt;
+                    continue;
+                }
+            }
+            if ( !next( scratch ) ) {
+                break;
+            }
+            done++;
+        }
+        return done;
+    }
+}; // class Reader
+
+
+/**
+ *  @brief  Appends an archive to a std::string, the FileHeader is written on construction
+ *          Messages are gathered into columns and written out a block of blockMsgs messages at a time
+ *  @NOTE   Call flush() once done to write the last, partial, block; the destructor flushes as well
+ *  @NOTE   Prices are rounded to the nearest tick of 1 / pxScale
+ */
+class Writer
+{
+private:
+    std::string& mOut;
+    const uint32_t mPxScale;
+    const size_t mBlockMsgs;
+
+    std::string mCols[ColumnCount];
+    std::vector<int64_t> mSizes;    // encoded at flush, once szStep is known
+    std::vector<int64_t> mPrices;   // in ticks, encoded at flush, once pxStep is known
+    uint32_t mMsgCnt{ 0 };
+    uint8_t mSideByte{ 0 };
+    unsigned mSideBit{ 0 };
+    int64_t mLastId{ 0 };
+
+    int64_t toTicks( const Price px ) const
+    {
+        return px.toScaled( mPxScale );
+    }
+
+    void side( const bool is_sell )
+    {
+        mSideByte |= static_cast<uint8_t>( is_sell ? 1 : 0 ) << mSideBit;
+        if ( ++mSideBit == 8 ) {
+            mCols[Sides].push_back( static_cast<char>( mSideByte ) );
+            mSideByte = 0;
+            mSideBit = 0;
+        }
+    }
+
+    void id( const int val )
+    {
+        putVarint( mCols[Ids], zigzag( val - mLastId ) );
+        mLastId = val;
+    }
+
+    void quantity( const int val )
+    {
+        mSizes.push_back( val );
+    }
+
+    void price( const Price px )
+    {
+        mPrices.push_back( toTicks( px ) );
+    }
+
+    // the greatest common divisor of vals, 1 if they are all 0
+    static uint64_t step( const std::vector<int64_t>& vals )
+    {
+        uint64_t res{ 0 };
+        for ( const auto val: vals ) {
+            res = std::gcd( res, static_cast<uint64_t>( val < 0 ? -val : val ) );
+            if ( res == 1 ) {
+                break;
+            }
+        }
+        return res == 0 ? 1 : res;
+    }
+
+    void beginMessage( const char tag )
+    {
+        const auto idx = static_cast<uint8_t>( std::find( std::begin( Tags ), std::end( Tags ), tag ) - std::begin( Tags ) );
+        auto& col = mCols[TagCol];
+        if ( mMsgCnt % 2 == 0 ) {
+            col.push_back( static_cast<char>( idx ) );
+        } else {
+            col.back() = static_cast<char>( static_cast<uint8_t>( col.back() ) | idx << 4 );
+        }
+    }
+
+    void endMessage()
+    {
+        if ( ++mMsgCnt == mBlockMsgs ) {
+            flush();
+        }
+    }
+
+    template <typename Comparator>
+    void appendSide( const OneSideBook<L2PriceLevel, Comparator>& side )
+    {
+        for ( const auto& [px, lvl]: side ) {
+            price( px );
+            quantity( lvl.quantity );
+        }
+    }
+
+public:
+    explicit Writer( std::string& out, const uint32_t pxScale = bin::DefaultPxScale,
+                     const size_t block_msgs = DefaultBlockMsgs )
+    : mOut{ out }
+    , mPxScale{ pxScale }
+    , mBlockMsgs{ std::max<size_t>( block_msgs, 1 ) }
+    {
+        FileHeader header{};
+        std::memcpy( header.magic, Magic, sizeof( Magic ) );
+        header.version = Version;
+        header.headerSize = sizeof( FileHeader );
+        header.pxScale = pxScale;
+        mOut.append( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    }
+
+    ~Writer()
+    {
+        flush();
+    }
+
+    Writer( const Writer& ) = delete;
+    Writer& operator=( const Writer& ) = delete;
+
+    void write( const Order& order )
+    {
+        beginMessage( order.isCancel() ? 'C' : order.isReprice() ? 'R' : 'N' );
+        side( order.isSell );
+        id( order.orderId );
+        quantity( order.size );
+        price( order.price );
+        if ( order.isCancel() || order.isReprice() ) {
+            id( *order.oldId );
+        }
+        if ( order.isReprice() ) {
+            price( *order.oldPx );
+            quantity( *order.oldSz );
+        }
+        endMessage();
+    }
+
+    void write( const Trade& trade )
+    {
+        beginMessage( 'T' );
+        side( trade.isSell );
+        putVarint( mCols[Counts], trade.price.size() );
+        for ( size_t i = 0; i < trade.price.size(); i++ ) {
+            price( trade.price[i] );
+            quantity( trade.volume[i] );
+        }
+        endMessage();
+    }
+
+    void write( L2Book& snapshot )
+    {
+        beginMessage( 'S' );
+        putVarint( mCols[Counts], snapshot.getBidSideDepth() );
+        putVarint( mCols[Counts], snapshot.getAskSideDepth() );
+        appendSide( snapshot.getBidSide() );
+        appendSide( snapshot.getAskSide() );
+        endMessage();
+    }
+
+    // write the gathered messages as one block, nothing if there are none
+    void flush()
+    {
+        if ( mMsgCnt == 0 ) {
+            return;
+        }
+        if ( mSideBit != 0 ) {
+            mCols[Sides].push_back( static_cast<char>( mSideByte ) );
+        }
+
+        BlockHeader header{};
+        header.msgCnt = mMsgCnt;
+        const auto sz_step = step( mSizes );
+        header.szStep = sz_step <= UINT32_MAX ? static_cast<uint32_t>( sz_step ) : 1;
+        for ( const auto sz: mSizes ) {
+            putVarint( mCols[Sizes], zigzag( sz / header.szStep ) );
+        }
+        header.pxStep = step( mPrices );
+        int64_t last_px{ 0 };
+        for ( const auto px: mPrices ) {
+            putVarint( mCols[Prices], zigzag( ( px - last_px ) / static_cast<int64_t>( header.pxStep ) ) );
+            last_px = px;
+        }
+
+        for ( size_t i = 0; i < ColumnCount; i++ ) {
+            if ( mCols[i].size() > UINT32_MAX ) {
+                throw std::runtime_error( "[col::Writer::flush] column too large for one block" );
+            }
+            header.colLen[i] = static_cast<uint32_t>( mCols[i].size() );
+        }
+        mOut.append( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+        for ( auto& col: mCols ) {
+            mOut.append( col );
+            col.clear();
+        }
+
+        mSizes.clear();
+        mPrices.clear();
+        mMsgCnt = 0;
+        mSideByte = 0;
+        mSideBit = 0;
+        mLastId = 0;
+    }
+}; // class Writer
+
+} // namespace col
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  A hash map keeping its entries inline in one array of slots, open addressing with Robin Hood
+ *              linear probing: an entry is never further from its home slot than the ones it passed on the way
+ *          The map L3Book keeps orderMap in: no node per order, a lookup reads a few adjacent slots,
+ *              and a miss stops as soon as it reaches an entry closer to its home than the key would be
+ *  @NOTE   Erasing shifts the entries following in the run back by one slot, no tombstones are left behind;
+ *              inserting may move entries too, and growing rehashes them all: iterators and references are
+ *              invalidated by any insertion or erasure, use reserve() to size the table up front
+ *  @NOTE   K and V have to be default constructible, an empty slot holds value_type{}. The table doubles past
+ *              a load of MaxLoadNum / MaxLoadDen, Hash is mixed with a Fibonacci multiply, so std::hash<int>
+ *              being the identity does not matter. Do not modify the key through an iterator
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<K, V>>>
+class FlatHashMap
+{
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Alloc;
+
+    static constexpr size_t InitCapacity = 16;
+    static constexpr size_t MaxLoadNum = 3;
+    static constexpr size_t MaxLoadDen = 4;
+
+private:
+    struct Slot
+    {
+        uint32_t dist{ 0 };     // 0 when empty, else 1 + how far the entry sits from its home slot
+        value_type kv{};
+    }; // struct Slot
+
+    using SlotAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Slot>;
+
+    std::vector<Slot, SlotAlloc> mSlots;
+    size_t mSize{ 0 };
+    int mShift{ 64 };
+    Hash mHash;
+    KeyEqual mEqual;
+
+    size_t home( const K& key ) const
+    {
+        return ( static_cast<uint64_t>( mHash( key ) ) * 0x9E3779B97F4A7C15ull ) >> mShift;
+    }
+
+    size_t mask() const
+    {
+        return mSlots.size() - 1;
+    }
+
+    // the slot holding key, mSlots.size() if none
+    size_t lookup( const K& key ) const
+    {
+        if ( mSize == 0 ) {
+            return mSlots.size();
+        }
+        size_t idx = home( key );
+        for ( uint32_t dist = 1; ; dist++ ) {
+            const auto& slot = mSlots[idx];
+            if ( slot.dist < dist ) {
+                return mSlots.size();
+            }
+            if ( slot.dist == dist && mEqual( slot.kv.first, key ) ) {
+                return idx;
+            }
+            idx = ( idx + 1 ) & mask();
+        }
+    }
+
+    // key must not be held yet and there must be room for it, returns where it went
+    size_t place( value_type&& kv )
+    {
+        Slot cur{ 1, std::move( kv ) };
+        size_t idx = home( cur.kv.first );
+        size_t res = mSlots.size();
+        while ( true ) {
+            auto& slot = mSlots[idx];
+            if ( slot.dist == 0 ) {
+                slot = std::move( cur );
+                mSize++;
+                return res == mSlots.size() ? idx : res;
+            }
+            if ( slot.dist < cur.dist ) {
+                // takes the place of an entry closer to its home, which moves on
+                std::swap( slot, cur );
+                if ( res == mSlots.size() ) {
+                    res = idx;
+                }
+            }
+            idx = ( idx + 1 ) & mask();
+            cur.dist++;
+        }
+    }
+
+    void rehash( const size_t capacity )
+    {
+        std::vector<Slot, SlotAlloc> slots( capacity, mSlots.get_allocator() );
+        slots.swap( mSlots );
+        mShift = 64 - __builtin_ctzll( capacity );
+        mSize = 0;
+        for ( auto& slot: slots ) {
+            if ( slot.dist != 0 ) {
+                place( std::move( slot.kv ) );
+            }
+        }
+    }
+
+    // after the slots were moved out, which may have moved the entries one by one and left the slots
+    void reset()
+    {
+        mSlots.clear();
+        mSize = 0;
+        mShift = 64;
+    }
+
+    static size_t capacityFor( const size_t count )
+    {
+        size_t capacity = InitCapacity;
+        while ( capacity * MaxLoadNum < count * MaxLoadDen ) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    template <typename KeyT, typename... Args>
+    std::pair<size_t, bool> tryEmplace( KeyT&& key, Args&&... args )
+    {
+        const size_t found = lookup( key );
+        if ( found != mSlots.size() ) {
+            return { found, false };
+        }
+        if ( ( mSize + 1 ) * MaxLoadDen > mSlots.size() * MaxLoadNum ) {
+            rehash( capacityFor( mSize + 1 ) );
+        }
+        return { place( value_type( std::piecewise_construct, std::forward_as_tuple( std::forward<KeyT>( key ) ),
+                                    std::forward_as_tuple( std::forward<Args>( args )... ) ) ), true };
+    }
+
+    template <bool IsConst>
+    class Iter
+    {
+    private:
+        using SlotPtr = std::conditional_t<IsConst, const Slot*, Slot*>;
+        SlotPtr mSlot{ nullptr };
+        SlotPtr mEnd{ nullptr };
+
+        friend class FlatHashMap;
+        Iter( SlotPtr slot, SlotPtr end ): mSlot( slot ), mEnd( end )
+        {
+            skip();
+        }
+
+        void skip()
+        {
+            while ( mSlot != mEnd && mSlot->dist == 0 ) {
+                ++mSlot;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iter() = default;
+
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter( const Iter<false>& rhs ): mSlot( rhs.mSlot ), mEnd( rhs.mEnd ) {}
+
+        reference operator*() const
+        {
+            return mSlot->kv;
+        }
+
+        pointer operator->() const
+        {
+            return &mSlot->kv;
+        }
+
+        Iter& operator++()
+        {
+            ++mSlot;
+            skip();
+            return *this;
+        }
+
+        Iter operator++( int )
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mSlot == rhs.mSlot;
+        }
+
+        friend bool operator!=( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mSlot != rhs.mSlot;
+        }
+
+        friend class Iter<!IsConst>;
+    }; // class Iter
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    FlatHashMap() = default;
+
+    explicit FlatHashMap( const Alloc& alloc )
+    : mSlots( SlotAlloc( alloc ) )
+    {}
+
+    FlatHashMap( const FlatHashMap& rhs ) = default;
+    FlatHashMap& operator=( const FlatHashMap& rhs ) = default;
+
+    // rhs is left empty
+    FlatHashMap( FlatHashMap&& rhs )
+    : mSlots( std::move( rhs.mSlots ) )
+    , mSize( rhs.mSize )
+    , mShift( rhs.mShift )
+    , mHash( rhs.mHash )
+    , mEqual( rhs.mEqual )
+    {
+        rhs.reset();
+    }
+
+    FlatHashMap& operator=( FlatHashMap&& rhs )
+    {
+        if ( this != &rhs ) {
+            mSlots = std::move( rhs.mSlots );
+            mSize = rhs.mSize;
+            mShift = rhs.mShift;
+            rhs.reset();
+        }
+        return *this;
+    }
+
+    // the allocator-extended versions, the slots come from alloc
+    FlatHashMap( const FlatHashMap& rhs, const Alloc& alloc )
+    : mSlots( rhs.mSlots, SlotAlloc( alloc ) )
+    , mSize( rhs.mSize )
+    , mShift( rhs.mShift )
+    , mHash( rhs.mHash )
+    , mEqual( rhs.mEqual )
+    {}
+
+    FlatHashMap( FlatHashMap&& rhs, const Alloc& alloc )
+    : mSlots( std::move( rhs.mSlots ), SlotAlloc( alloc ) )
+    , mSize( rhs.mSize )
+    , mShift( rhs.mShift )
+    , mHash( rhs.mHash )
+    , mEqual( rhs.mEqual )
+    {
+        rhs.reset();
+    }
+
+    Alloc get_allocator() const
+    {
+        return Alloc( mSlots.get_allocator() );
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    // the slots held, reserve( n ) holds n entries without growing
+    size_t capacity() const
+    {
+        return mSlots.size();
+    }
+
+    void reserve( const size_t count )
+    {
+        const size_t capacity = capacityFor( count );
+        if ( capacity > mSlots.size() ) {
+            rehash( capacity );
+        }
+    }
+
+    iterator begin()
+    {
+        return iterator( mSlots.data(), mSlots.data() + mSlots.size() );
+    }
+
+    iterator end()
+    {
+        return iterator( mSlots.data() + mSlots.size(), mSlots.data() + mSlots.size() );
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator( mSlots.data(), mSlots.data() + mSlots.size() );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( mSlots.data() + mSlots.size(), mSlots.data() + mSlots.size() );
+    }
+
+    iterator find( const K& key )
+    {
+        const size_t idx = lookup( key );
+        return iterator( mSlots.data() + idx, mSlots.data() + mSlots.size() );
+    }
+
+    const_iterator find( const K& key ) const
+    {
+        const size_t idx = lookup( key );
+        return const_iterator( mSlots.data() + idx, mSlots.data() + mSlots.size() );
+    }
+
+    size_t count( const K& key ) const
+    {
+        return lookup( key ) != mSlots.size() ? 1 : 0;
+    }
+
+    V& operator[]( const K& key )
+    {
+        return mSlots[tryEmplace( key ).first].kv.second;
+    }
+
+    template <typename KeyT, typename... Args>
+    std::pair<iterator, bool> emplace( KeyT&& key, Args&&... args )
+    {
+        const auto [idx, inserted] = tryEmplace( std::forward<KeyT>( key ), std::forward<Args>( args )... );
+        return { iterator( mSlots.data() + idx, mSlots.data() + mSlots.size() ), inserted };
+    }
+
+    size_t erase( const K& key )
+    {
+        size_t idx = lookup( key );
+        if ( idx == mSlots.size() ) {
+            return 0;
+        }
+        // the rest of the run moves back a slot, up to an empty slot or an entry at its home
+        for ( size_t next = ( idx + 1 ) & mask(); mSlots[next].dist > 1; next = ( next + 1 ) & mask() ) {
+            mSlots[idx] = std::move( mSlots[next] );
+            mSlots[idx].dist--;
+            idx = next;
+        }
+        mSlots[idx] = Slot{};
+        mSize--;
+        return 1;
+    }
+
+    // keeps the slots
+    void clear()
+    {
+        if ( mSize == 0 ) {
+            return;
+        }
+        for ( auto& slot: mSlots ) {
+            if ( slot.dist != 0 ) {
+                slot = Slot{};
+            }
+        }
+        mSize = 0;
+    }
+}; // class FlatHashMap
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,618 @@
+#ifndef GUESS_OVERLAY_H
+#define GUESS_OVERLAY_H
+
+#include <OrderBook.h>
+#include <Trade.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+
+namespace sob {
+
+/**
+ *  @brief  What the trade guess remembers from one trade to the next: the volume traded at a level the order
+ *              stream has not shown yet, for each kind of taker, and that level
+ */
+struct TradeTally
+{
+    std::unordered_map<Price, int> sellVol;
+    Price lastSellLvl{};
+    std::unordered_map<Price, int> buyVol;
+    Price lastBuyLvl{};
+}; // struct TradeTally
+
+
+/**
+ *  @brief  Deduce from a trade the orders that must have come before it, when the trade stream leads the order stream
+ *          Book is anything with getBestBid() / getBestAsk() and guessOrder( isSell, size, px ), which applies an
+ *              order of its own making, matching as any other: L3Book or GuessOverlay
+ *  @NOTE   A guess of nothing is not applied
+ */
+template <typename Book>
+void guessFromTrade( Book& book, TradeTally& tally, const Trade& trade )
+{
+    const auto guess = [&book]( const bool is_sell, const int size, const Price px ) {
+        if ( size > 0 ) {
+            book.guessOrder( is_sell, size, px );
+        }
+    };
+
+    if( trade.isSell ) {
+        // Seller is the liquidity taker
+        const auto best_bid_px = book.getBestBid().price;
+
+        if ( trade.getLvlCnt() == 1 ) {
+            const auto trd_px = trade.price[0];
+
+            if( trd_px > best_bid_px ) {
+                /* *******************************************
+                 * There has to be some new bid orders at the trd_px which haven't arrived
+                 * Then come this trade, initiated by some selling liquidity taker
+                 *
+                 * !!! There is most likely some liquidity left on the traded lvl
+                 * !!! We can't have an accurate guess about how much liquidity there is left on that level,
+                 * !!! therefore we hold on the guess until that level has been totally consumed
+                 * *******************************************/
+                if ( tally.lastSellLvl == Price{} || trd_px == tally.lastSellLvl ) {
+                    tally.sellVol[trd_px] += trade.getTotalVol();
+                } else {
+                    /* *******************************************
+                     * !!! Now the last unconsumed level has been consumed;
+                     * !!! We may now make a guess: that price level is now on the ask side
+                     *          For simplicity, we just guess that there is one order there
+                     * *******************************************/
+                    guess( true, 2 * tally.sellVol[trd_px], tally.lastSellLvl );
+                    tally.sellVol.erase( tally.lastSellLvl );
+                }
+                tally.lastSellLvl = trd_px;
+            } else if ( trd_px == best_bid_px ) {
+                /* *******************************************
+                 * This has been a very logical trade message, we should just reflect the information in the orderbook
+                 *  NOTE: only the untraded quantity of the last trade message is estimated
+                 * *******************************************/
+                const auto trd_qty = trade.getTotalVol();
+                if ( trd_qty < book.getBestBid().quantity ) {
+                    // simply reflect the trade information on the book
+                    guess( true, trd_qty, best_bid_px );
+                } else {
+                    // trade quantity + not yet received aggresive orders
+                    guess( true, 3 * trd_qty, best_bid_px );
+                }
+
+                if( tally.lastSellLvl != Price{} && tally.lastSellLvl > best_bid_px ) {
+                    guess( true, 2 * tally.sellVol[tally.lastSellLvl], tally.lastSellLvl );
+                    tally.sellVol.erase( tally.lastSellLvl );
+                    tally.lastSellLvl = Price{};
+                }
+            } else {
+                spdlog::warn( "unexpected trade message, there has to have been out-of-order or lost trades, do nothing" );
+            }
+        } else {
+            /* *******************************************
+             * This is a trade-through order, apply the order first and then add an ask order of 2 * total traded volume on the best bid level
+             * *******************************************/
+            const auto total_trd_vol = trade.getTotalVol();
+            guess( true, total_trd_vol, trade.price[0] );
+            guess( true, 2 * total_trd_vol, best_bid_px );
+        }
+    } else {
+        // Buyer is the liquidity taker
+        const auto best_ask_px = book.getBestAsk().price;
+
+        if ( trade.getLvlCnt() == 1 ) {
+            const auto trd_px = trade.price[0];
+
+            if( trd_px < best_ask_px ) {
+                if ( tally.lastBuyLvl == Price{} || trd_px == tally.lastBuyLvl ) {
+                    tally.buyVol[trd_px] += trade.getTotalVol();
+                } else {
+                    guess( false, 2 * tally.buyVol[trd_px], tally.lastBuyLvl );
+                    tally.buyVol.erase( tally.lastBuyLvl );
+                }
+                tally.lastBuyLvl = trd_px;
+            } else if ( trd_px == best_ask_px ) {
+                const auto trd_qty = trade.getTotalVol();
+                if ( trd_qty < book.getBestAsk().quantity ) {
+                    // simply reflect the trade information on the book
+                    guess( false, trd_qty, best_ask_px );
+                } else {
+                    // trade quantity + not yet received aggresive orders
+                    guess( false, 3 * trd_qty, best_ask_px );
+                }
+
+                if( tally.lastBuyLvl != Price{} && tally.lastBuyLvl < best_ask_px ) {
+                    guess( false, 2 * tally.buyVol[tally.lastBuyLvl], tally.lastBuyLvl );
+                    tally.buyVol.erase( tally.lastBuyLvl );
+                    tally.lastBuyLvl = Price{};
+                }
+            } else {
+                spdlog::warn( "unexpected trade message, there has to have been out-of-order or lost trades, do nothing" );
+            }
+        } else {
+            /* *******************************************
+             * This is a trade-through order, apply the order first and then add a bid order of 2 * total traded volume on the best ask level
+             * *******************************************/
+            const auto total_trd_vol = trade.getTotalVol();
+            guess( false, total_trd_vol, trade.price[trade.getLvlCnt() - 1] );
+            guess( false, 2 * total_trd_vol, best_ask_px );
+        }
+    }
+}
+
+
+/**
+ *  @brief  The guessed state of a book: a sparse layer of per-level quantity changes on top of the book itself
+ *          Reads merge the two, a level shows the book's quantity plus what was guessed there and is gone once
+ *              that comes to nothing; the book goes on being updated underneath
+ *          The guesses are deduced from the trades and the snapshots that lead the order stream, see applyTrade /
+ *              applySnapShot, the orders that confirm them while the lead lasts are taken off them, see reconcile
+ *          Each change to the guesses is journaled, side, level and quantity: rollbackGuesses() takes them back
+ *              once the orders catch up, newest first, in the number of changes
+ *  @NOTE   Only quantities are guessed, the orders on a level are the book's own
+ *  @NOTE   Holds on to the book, which must outlive it
+ */
+template <typename Book>
+class GuessOverlay
+{
+private:
+    using Level = typename Book::Level;
+
+    const Book* mBook;
+
+    // the guessed change of each level, and their sum for the side
+    std::map<Price, int, BidComparator> mBids;
+    std::map<Price, int, AskComparator> mAsks;
+    long mBidSize{ 0 };
+    long mAskSize{ 0 };
+
+    TradeTally mTally;
+
+    /**
+     *  @brief  one change made to the guesses: by was added to the level px of a side, see rollbackGuesses
+     */
+    struct GuessStep
+    {
+        Price px;
+        int by;
+        bool isSell;
+    }; // struct GuessStep
+
+    std::vector<GuessStep> mJournal;    // since the last rollbackGuesses / clear, oldest first
+
+    // the book's quantity at each guessed level before an order of the stream, side, price, see mark / reconcile
+    std::vector<std::tuple<bool, Price, int>> mSeen;
+
+    /**
+     *  @brief  visit the levels of a side and of its guesses together, best first:
+     *              f( px, the book's level or nullptr, the guess there or 0 ), until f returns false
+     */
+    template <typename Side, typename Guesses, typename F>
+    static void walk( const Side& side, const Guesses& guesses, F&& f )
+    {
+        const auto comp = guesses.key_comp();
+        auto it = side.begin();
+        auto git = guesses.begin();
+        while ( it != side.end() || git != guesses.end() ) {
+            if ( git == guesses.end() || ( it != side.end() && comp( it->first, git->first ) ) ) {
+                if ( !f( it->first, &it->second, 0 ) ) {
+                    return;
+                }
+                ++it;
+            } else if ( it == side.end() || comp( git->first, it->first ) ) {
+                if ( !f( git->first, static_cast<const Level*>( nullptr ), git->second ) ) {
+                    return;
+                }
+                ++git;
+            } else {
+                if ( !f( it->first, &it->second, git->second ) ) {
+                    return;
+                }
+                ++it;
+                ++git;
+            }
+        }
+    }
+
+    static int quantityOf( const Level* level, const int guessed )
+    {
+        return ( level ? level->quantity : 0 ) + guessed;
+    }
+
+    template <typename Side, typename Guesses>
+    static L2PriceLevel best( const Side& side, const Guesses& guesses )
+    {
+        L2PriceLevel ret{};
+        walk( side, guesses, [&ret]( const Price px, const Level* level, const int guessed ) {
+            const int qty = quantityOf( level, guessed );
+            if ( qty > 0 ) {
+                ret = L2PriceLevel{ px, qty };
+                return false;
+            }
+            return true;
+        } );
+        return ret;
+    }
+
+    template <typename Side, typename Guesses>
+    static int quantityAt( const Side& side, const Guesses& guesses, const Price px )
+    {
+        const auto it = side.find( px );
+        const auto git = guesses.find( px );
+        return quantityOf( it == side.end() ? nullptr : &it->second, git == guesses.end() ? 0 : git->second );
+    }
+
+    template <typename Side>
+    static int bookQuantity( const Side& side, const Price px )
+    {
+        const auto it = side.find( px );
+        return it == side.end() ? 0 : it->second.quantity;
+    }
+
+    template <typename Guesses>
+    static int guessedAt( const Guesses& guesses, const Price px )
+    {
+        const auto git = guesses.find( px );
+        return git == guesses.end() ? 0 : git->second;
+    }
+
+    // what the book changed at a guessed level is taken off the guess there, as far as both go the same way
+    void confirm( const bool is_sell, const Price px, const int change )
+    {
+        const int guessed = is_sell ? guessedAt( mAsks, px ) : guessedAt( mBids, px );
+        if ( guessed > 0 && change > 0 ) {
+            adjust( is_sell, px, -std::min( guessed, change ) );
+        } else if ( guessed < 0 && change < 0 ) {
+            adjust( is_sell, px, -std::max( guessed, change ) );
+        }
+    }
+
+    template <typename Guesses, typename Target>
+    static void writeSide( const Guesses& guesses, const bool is_sell, Target& target )
+    {
+        for ( const auto& [px, guessed]: guesses ) {
+            target.guessLevel( is_sell, px, guessed );
+        }
+    }
+
+    template <typename Guesses>
+    static void shift( Guesses& guesses, long& size, const Price px, const int by )
+    {
+        size += by;
+        if ( ( guesses[px] += by ) == 0 ) {
+            guesses.erase( px );
+        }
+    }
+
+    // every change to the guesses goes through here, and into the journal
+    void adjust( const bool is_sell, const Price px, const int by )
+    {
+        mJournal.push_back( GuessStep{ px, by, is_sell } );
+        if ( is_sell ) {
+            shift( mAsks, mAskSize, px, by );
+        } else {
+            shift( mBids, mBidSize, px, by );
+        }
+    }
+
+    /**
+     *  @brief  the side shows the snapshot on the levels it covers: down to the last one it lists, the others are gone
+     *          what the previous snapshot guessed is replaced, only the levels whose guess changes are adjusted
+     */
+    template <typename Side, typename Guesses, typename SnapSide>
+    void snapSide( const bool is_sell, const Side& side, const Guesses& guesses, const SnapSide& snap )
+    {
+        const auto comp = guesses.key_comp();
+        const auto covered = [&snap, &comp]( const Price px ) {
+            return snap.empty() || !comp( snap.rbegin()->first, px );
+        };
+        const auto target = [&side, &snap, &covered]( const Price px ) {
+            const auto lvl = snap.find( px );
+            if ( lvl != snap.end() ) {
+                return lvl->second.quantity - bookQuantity( side, px );
+            }
+            return covered( px ) ? -bookQuantity( side, px ) : 0;
+        };
+
+        // the levels guessed already, brought to what this snapshot guesses, next taken first: adjust may erase
+        for ( auto git = guesses.begin(); git != guesses.end(); ) {
+            const auto [px, guessed] = *git++;
+            if ( const int to = target( px ); to != guessed ) {
+                adjust( is_sell, px, to - guessed );
+            }
+        }
+        // then those it is the first to guess
+        for ( const auto& [px, level]: side ) {
+            if ( !covered( px ) ) {
+                break;
+            }
+            if ( snap.find( px ) == snap.end() && level.quantity != 0 && guesses.find( px ) == guesses.end() ) {
+                adjust( is_sell, px, -level.quantity );
+            }
+        }
+        for ( const auto& [px, lvl]: snap ) {
+            const int guessed = lvl.quantity - bookQuantity( side, px );
+            if ( guessed != 0 && guesses.find( px ) == guesses.end() ) {
+                adjust( is_sell, px, guessed );
+            }
+        }
+    }
+
+    template <typename Side, typename Guesses, typename Out>
+    static void aggSide( const Side& side, const Guesses& guesses, Out& out )
+    {
+        walk( side, guesses, [&out]( const Price px, const Level* level, const int guessed ) {
+            const int qty = quantityOf( level, guessed );
+            if ( qty > 0 ) {
+                out[px] = L2PriceLevel{ px, qty };
+            }
+            return true;
+        } );
+    }
+
+    static void printLevel( std::stringstream& ss, const Price px, const Level* level, const int guessed )
+    {
+        if ( guessed != 0 ) {
+            ss << "Guess{px=" << px << ", qty=" << quantityOf( level, guessed )
+               << ", guessed=" << ( guessed > 0 ? "+" : "" ) << guessed << "}";
+        }
+        if ( level ) {
+            ss << ( guessed != 0 ? " " : "" ) << *level;
+        }
+        ss << '\n';
+    }
+
+public:
+    explicit GuessOverlay( const Book& book ): mBook( &book )
+    {}
+
+    const Book& book() const
+    {
+        return *mBook;
+    }
+
+    // nothing guessed, it reads as the book
+    bool empty() const
+    {
+        return mBids.empty() && mAsks.empty();
+    }
+
+    size_t numGuessedLevels() const
+    {
+        return mBids.size() + mAsks.size();
+    }
+
+    // the guesses of rhs, on the book of this one, e.g. a copy of the book of rhs
+    void assign( const GuessOverlay& rhs )
+    {
+        mBids = rhs.mBids;
+        mAsks = rhs.mAsks;
+        mBidSize = rhs.mBidSize;
+        mAskSize = rhs.mAskSize;
+        mJournal = rhs.mJournal;
+    }
+
+    /**
+     *  @brief  drop the guesses, what the trades seen so far leave to be confirmed is kept for the next ones
+     */
+    void clear()
+    {
+        mBids.clear();
+        mAsks.clear();
+        mBidSize = 0;
+        mAskSize = 0;
+        mJournal.clear();
+    }
+
+    /**
+     *  @brief  take back every change made to the guesses since the last call, newest first, for when the order
+     *              stream has caught up: O(changes), a guess, a snapshot level or a reconciled order each
+     *  @NOTE   leaves it empty, as clear() does, what the trades seen so far leave to be confirmed is kept
+     */
+    void rollbackGuesses()
+    {
+        for ( auto step = mJournal.rbegin(); step != mJournal.rend(); ++step ) {
+            if ( step->isSell ) {
+                shift( mAsks, mAskSize, step->px, -step->by );
+            } else {
+                shift( mBids, mBidSize, step->px, -step->by );
+            }
+        }
+        mJournal.clear();
+    }
+
+    // how many changes were made to the guesses since the last rollbackGuesses / clear
+    size_t numGuessSteps() const
+    {
+        return mJournal.size();
+    }
+
+    /**
+     *  @brief  note the book's quantity at the guessed levels, before an order of the stream is applied to it
+     */
+    void mark()
+    {
+        mSeen.clear();
+        for ( const auto& [px, guessed]: mBids ) {
+            mSeen.emplace_back( false, px, bookQuantity( mBook->getBidSide(), px ) );
+        }
+        for ( const auto& [px, guessed]: mAsks ) {
+            mSeen.emplace_back( true, px, bookQuantity( mBook->getAskSide(), px ) );
+        }
+    }
+
+    /**
+     *  @brief  the order applied since mark() is one the guesses were waiting for, as far as it changed a guessed
+     *              level the way the guess did: that much is taken off the guess, the level is not counted twice
+     *  @NOTE   in the number of levels guessed, for as long as the stream it was guessed from still leads
+     */
+    void reconcile()
+    {
+        for ( const auto& [is_sell, px, before]: mSeen ) {
+            if ( is_sell ) {
+                confirm( true, px, bookQuantity( mBook->getAskSide(), px ) - before );
+            } else {
+                confirm( false, px, bookQuantity( mBook->getBidSide(), px ) - before );
+            }
+        }
+        mSeen.clear();
+    }
+
+    /**
+     *  @brief  write the guesses into target, a copy of the book, see L3Book::guessLevel
+     */
+    template <typename Target>
+    void applyTo( Target& target ) const
+    {
+        writeSide( mBids, false, target );
+        writeSide( mAsks, true, target );
+    }
+
+    /**
+     *  @brief  an order of the guess's own making: it takes from the opposite side as far as it crosses it, the rest
+     *              rests on its own side, as L3Book::pureNewOrder would do with it
+     */
+    void guessOrder( const bool is_sell, int size, const Price px )
+    {
+        if ( is_sell ) {
+            for ( auto bid = getBestBid(); size > 0 && bid.quantity > 0 && !( bid.price < px ); bid = getBestBid() ) {
+                const int taken = std::min( size, bid.quantity );
+                adjust( false, bid.price, -taken );
+                size -= taken;
+            }
+            if ( size > 0 ) {
+                adjust( true, px, size );
+            }
+        } else {
+            for ( auto ask = getBestAsk(); size > 0 && ask.quantity > 0 && !( px < ask.price ); ask = getBestAsk() ) {
+                const int taken = std::min( size, ask.quantity );
+                adjust( true, ask.price, -taken );
+                size -= taken;
+            }
+            if ( size > 0 ) {
+                adjust( false, px, size );
+            }
+        }
+    }
+
+    // the trade stream leads, see guessFromTrade
+    void applyTrade( const Trade& trade )
+    {
+        guessFromTrade( *this, mTally, trade );
+    }
+
+    /**
+     *  @brief  the snapshot stream leads: the levels it covers are guessed to be as it shows them
+     *  @NOTE   replaces what the previous snapshot guessed, a snapshot is the whole of the levels it covers
+     */
+    void applySnapShot( L2Book& snapshot )
+    {
+        snapSide( false, mBook->getBidSide(), mBids, snapshot.getBidSide() );
+        snapSide( true, mBook->getAskSide(), mAsks, snapshot.getAskSide() );
+    }
+
+    L2PriceLevel getBestBid() const
+    {
+        return best( mBook->getBidSide(), mBids );
+    }
+
+    L2PriceLevel getBestAsk() const
+    {
+        return best( mBook->getAskSide(), mAsks );
+    }
+
+    auto getBestMarket() const
+    {
+        L2PxLvlPair ret;
+        if ( const auto bid = getBestBid(); bid.quantity > 0 ) {
+            ret.bid = bid;
+        }
+        if ( const auto ask = getBestAsk(); ask.quantity > 0 ) {
+            ret.ask = ask;
+        }
+        return ret;
+    }
+
+    int getBidQuantity( const Price px ) const
+    {
+        return quantityAt( mBook->getBidSide(), mBids, px );
+    }
+
+    int getAskQuantity( const Price px ) const
+    {
+        return quantityAt( mBook->getAskSide(), mAsks, px );
+    }
+
+    size_t getBidSideSize() const
+    {
+        return static_cast<size_t>( static_cast<long>( mBook->getBidSideSize() ) + mBidSize );
+    }
+
+    size_t getAskSideSize() const
+    {
+        return static_cast<size_t>( static_cast<long>( mBook->getAskSideSize() ) + mAskSize );
+    }
+
+    /**
+     *  @brief  the guessed book, aggregated
+     */
+    L2Book agg() const
+    {
+        OneSideBook<L2PriceLevel, BidComparator> bidL2Book;
+        OneSideBook<L2PriceLevel, AskComparator> askL2Book;
+        aggSide( mBook->getBidSide(), mBids, bidL2Book );
+        aggSide( mBook->getAskSide(), mAsks, askL2Book );
+        return { bidL2Book, askL2Book, getBidSideSize(), getAskSideSize() };
+    }
+
+    /**
+     *  @brief  as L3Book::toString, the book itself while nothing is guessed
+     *          a guessed level is prefixed with Guess{px, the quantity it shows, the guessed change}
+     */
+    std::string toString() const
+    {
+        if ( empty() ) {
+            return mBook->toString();
+        }
+
+        std::vector<std::tuple<Price, const Level*, int>> asks;
+        walk( mBook->getAskSide(), mAsks, [&asks]( const Price px, const Level* level, const int guessed ) {
+            if ( quantityOf( level, guessed ) > 0 ) {
+                asks.emplace_back( px, level, guessed );
+            }
+            return true;
+        } );
+
+        std::stringstream ss;
+        if ( asks.empty() )
+            ss << "<Empty>\n";
+        for( auto rit = asks.rbegin(); rit != asks.rend(); ++rit ) {
+            printLevel( ss, std::get<0>( *rit ), std::get<1>( *rit ), std::get<2>( *rit ) );
+        }
+
+        ss << "--^ ASK SIDE--------BID SIDE V---\n";
+
+        bool any_bid = false;
+        walk( mBook->getBidSide(), mBids, [&ss, &any_bid]( const Price px, const Level* level, const int guessed ) {
+            if ( quantityOf( level, guessed ) > 0 ) {
+                printLevel( ss, px, level, guessed );
+                any_bid = true;
+            }
+            return true;
+        } );
+        if ( !any_bid )
+            ss << "<Empty>\n";
+
+        return ss.str();
+    }
+}; // class GuessOverlay
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <SpscQueue.h>
+#include <Tokenizer.h>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <thread>
+
+
+namespace sob {
+
+// true if data starts with the gzip magic bytes
+inline bool isGzipStream( std::string_view data )
+{
+    return data.size() >= 2 && static_cast<unsigned char>( data[0] ) == 0x1f
+                             && static_cast<unsigned char>( data[1] ) == 0x8b;
+}
+
+
+/**
+ *  @brief  Hands out the lines of a gzipped .stream text file a batch at a time, like TokenReader
+ *          A background thread inflates the file into blocks of about BlockSize bytes, each block is cut after
+ *              its last '\n' so no line straddles two blocks, and passes them on through a ring of RingSize blocks
+ *          Decompression therefore overlaps with tokenising and applying the messages on the calling thread
+ *  @NOTE   The blocks are reused, so steady-state reading does not allocate
+ *  @NOTE   Throws std::runtime_error if the file cannot be opened; a corrupt file surfaces as an exception
+ *              from next(), thrown on the decompression thread and rethrown on the calling one
+ *  @NOTE   Only text streams, gzip the binary format is not supported
+ */
+class GzipTokenReader
+{
+private:
+    struct Block
+    {
+        std::string data;
+    }; // struct Block
+
+    const size_t mBlockSize;
+    const size_t mBatchLines;
+    const SimdLevel mLevel;
+
+    SpscQueue<Block> mRing;
+    std::atomic<bool> mStop{ false };
+    std::exception_ptr mError;
+    std::thread mInflater;
+
+    Block* mCur{ nullptr };
+    size_t mPos{ 0 };
+
+    void inflate( const std::string& path );
+
+public:
+    static constexpr size_t DefaultBlockSize = 1u << 20;
+    static constexpr size_t DefaultRingSize = 8;
+
+    explicit GzipTokenReader( const std::string& path,
+                              const size_t batch_lines = 1024,
+                              const SimdLevel level = BestSimdLevel,
+                              const size_t block_size = DefaultBlockSize,
+                              const size_t ring_size = DefaultRingSize );
+    ~GzipTokenReader();
+
+    GzipTokenReader( const GzipTokenReader& ) = delete;
+    GzipTokenReader& operator=( const GzipTokenReader& ) = delete;
+
+    // false once the file is exhausted, otherwise batch holds at least one line, valid until the next call
+    bool next( TokenBatch& batch );
+}; // class GzipTokenReader
+
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,567 @@
+#ifndef HYBRID_LADDER_H
+#define HYBRID_LADDER_H
+
+#include <Price.h>
+#include <spdlog/fmt/fmt.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  One side of a book split in two: a window of ticks at the touch held in a contiguous array
+ *              with an occupancy bitmap, like TickLadder, and the levels beyond it in an ordered map
+ *          A drop-in for the std::map<Price, LevelType, Comparator> L3Book uses by default ( see HybridSide ),
+ *              for books dense near the touch with a long sparse tail
+ *  @NOTE   The window always starts a quarter of its width before the best level, the map only holds
+ *              levels worse than the window: iterating is the window, then the map
+ *          A new best price before the window, or the touch drifting into the back half of the window,
+ *              recenters it; the levels crossing its end migrate between the array and the map
+ *  @NOTE   The width adapts to where the book gets updated, checked every ResizeEvery accesses through operator[]:
+ *              it doubles when more than 1/8 of them went to the map, halves when less than 1/32 of them
+ *              went past the first half of the window, a power of two in [ MinWindowTicks, MaxWindowTicks ]
+ *  @NOTE   The levels live in nodes of a pool owned by the container, the array and the map only point to them,
+ *              so a level never moves while it exists, references to it ( the dBuffer iterators of
+ *              L3Book::orderMap ) stay valid across migrations
+ */
+template <typename LevelType, typename Comparator>
+class HybridLadder
+{
+public:
+    using key_type = Price;
+    using mapped_type = LevelType;
+    using value_type = std::pair<const Price, LevelType>;
+    using size_type = size_t;
+
+    static constexpr int64_t MinWindowTicks = 64;
+    static constexpr int64_t MaxWindowTicks = int64_t{ 1 } << 16;
+    static constexpr size_t ResizeEvery = 256;      // accesses between two checks of the window width
+
+private:
+    // iterating from the highest tick down, as for the bid side
+    static constexpr bool Descending = Comparator{}( Price::fromTicks( 1 ), Price::fromTicks( 0 ) );
+    static constexpr int64_t InTail = -1;
+
+    struct Node
+    {
+        alignas( value_type ) unsigned char bytes[sizeof( value_type )];
+    }; // struct Node
+
+    using Tail = std::map<Price, value_type*, Comparator>;
+
+    std::vector<value_type*> mWindow;   // mWindow[i] is the level at rank mLo + i, nullptr if none
+    std::vector<uint64_t> mBits;
+    int64_t mLo{ 0 };
+    Tail mTail;                         // levels of rank >= mLo + window width
+    size_t mSize{ 0 };
+
+    std::deque<Node> mPool;             // never shrinks, the nodes keep their address
+    std::vector<value_type*> mFree;
+    std::vector<value_type*> mScratch;  // the window levels while recentering
+
+    size_t mAccesses{ 0 };
+    size_t mTailAccesses{ 0 };          // since the last width check, the accesses to levels in the map
+    size_t mFarAccesses{ 0 };           // and those to levels past the first half of the window
+
+    // the position in iteration order: ticks descending for bids, ascending for asks
+    static int64_t rankOf( const Price px )
+    {
+        return Descending ? -px.ticks() : px.ticks();
+    }
+
+    int64_t width() const
+    {
+        return static_cast<int64_t>( mWindow.size() );
+    }
+
+    template <typename... Args>
+    value_type* newNode( Args&&... args )
+    {
+        void* mem;
+        if ( mFree.empty() ) {
+            mem = mPool.emplace_back().bytes;
+        } else {
+            mem = mFree.back();
+            mFree.pop_back();
+        }
+        return new ( mem ) value_type( std::forward<Args>( args )... );
+    }
+
+    void deleteNode( value_type* node )
+    {
+        node->~value_type();
+        mFree.push_back( node );
+    }
+
+    void setSlot( const int64_t idx, value_type* node )
+    {
+        mWindow[idx] = node;
+        mBits[idx >> 6] |= uint64_t{ 1 } << ( idx & 63 );
+    }
+
+    void clearSlot( const int64_t idx )
+    {
+        mWindow[idx] = nullptr;
+        mBits[idx >> 6] &= ~( uint64_t{ 1 } << ( idx & 63 ) );
+    }
+
+    // the first occupied window index after idx, width() if none
+    int64_t nextIndex( const int64_t idx ) const
+    {
+        const int64_t from = idx + 1;
+        size_t word = static_cast<size_t>( from >> 6 );
+        if ( word >= mBits.size() ) {
+            return width();
+        }
+        uint64_t bits = mBits[word] & ( ~uint64_t{ 0 } << ( from & 63 ) );
+        while ( bits == 0 ) {
+            if ( ++word == mBits.size() ) {
+                return width();
+            }
+            bits = mBits[word];
+        }
+        return static_cast<int64_t>( word << 6 ) + __builtin_ctzll( bits );
+    }
+
+    // the last occupied window index before idx, InTail if none
+    int64_t prevIndex( const int64_t idx ) const
+    {
+        if ( idx <= 0 ) {
+            return InTail;
+        }
+        const int64_t to = idx - 1;
+        size_t word = static_cast<size_t>( to >> 6 );
+        uint64_t bits = mBits[word] & ( ~uint64_t{ 0 } >> ( 63 - ( to & 63 ) ) );
+        while ( bits == 0 ) {
+            if ( word-- == 0 ) {
+                return InTail;
+            }
+            bits = mBits[word];
+        }
+        return static_cast<int64_t>( word << 6 ) + 63 - __builtin_clzll( bits );
+    }
+
+    // whether a level sits at a window index below idx
+    bool anyBefore( const int64_t idx ) const
+    {
+        const size_t full = static_cast<size_t>( idx >> 6 );
+        for ( size_t word = 0; word < full; word++ ) {
+            if ( mBits[word] != 0 ) {
+                return true;
+            }
+        }
+        return ( idx & 63 ) != 0 && ( mBits[full] & ( ( uint64_t{ 1 } << ( idx & 63 ) ) - 1 ) ) != 0;
+    }
+
+    int64_t bestRank() const
+    {
+        const int64_t idx = nextIndex( -1 );
+        if ( idx < width() ) {
+            return mLo + idx;
+        }
+        return rankOf( mTail.begin()->first );
+    }
+
+    int64_t targetWidth() const
+    {
+        if ( mTailAccesses * 8 > ResizeEvery && width() < MaxWindowTicks ) {
+            return 2 * width();
+        }
+        if ( ( mTailAccesses + mFarAccesses ) * 32 < ResizeEvery && width() > MinWindowTicks ) {
+            return width() / 2;
+        }
+        return width();
+    }
+
+    /**
+     *  @brief  move the window to start at rank lo and span new_width ranks, lo is at most the best rank
+     *          the window levels falling past its end go to the map, the map levels now inside come in
+     */
+    void recenter( const int64_t lo, const int64_t new_width )
+    {
+        mScratch.clear();
+        for ( int64_t idx = nextIndex( -1 ); idx < width(); idx = nextIndex( idx ) ) {
+            mScratch.push_back( mWindow[idx] );
+        }
+        mWindow.assign( static_cast<size_t>( new_width ), nullptr );
+        mBits.assign( static_cast<size_t>( ( new_width + 63 ) >> 6 ), 0 );
+        mLo = lo;
+
+        for ( auto it = mScratch.rbegin(); it != mScratch.rend(); ++it ) {
+            const int64_t idx = rankOf( ( *it )->first ) - mLo;
+            if ( idx < new_width ) {
+                setSlot( idx, *it );
+            } else {
+                mTail.emplace_hint( mTail.begin(), ( *it )->first, *it );
+            }
+        }
+        while ( !mTail.empty() ) {
+            const auto it = mTail.begin();
+            const int64_t idx = rankOf( it->first ) - mLo;
+            if ( idx >= new_width ) {
+                break;
+            }
+            setSlot( idx, it->second );
+            mTail.erase( it );
+        }
+    }
+
+    void place( value_type* node )
+    {
+        const int64_t rank = rankOf( node->first );
+        if ( mSize == 0 ) {
+            mLo = rank - width() / 4;
+        } else if ( rank < mLo ) {
+            recenter( rank - width() / 4, width() );
+        }
+
+        if ( rank - mLo < width() ) {
+            setSlot( rank - mLo, node );
+        } else {
+            mTail.emplace( node->first, node );
+        }
+        mSize++;
+    }
+
+    void account( const Price px )
+    {
+        const int64_t idx = rankOf( px ) - mLo;
+        mTailAccesses += idx >= width();
+        mFarAccesses += idx >= width() / 2 && idx < width();
+        if ( ++mAccesses == ResizeEvery ) {
+            const int64_t new_width = targetWidth();
+            if ( new_width != width() ) {
+                recenter( bestRank() - new_width / 4, new_width );
+            }
+            mAccesses = mTailAccesses = mFarAccesses = 0;
+        }
+    }
+
+    void copyFrom( const HybridLadder& rhs )
+    {
+        mWindow.assign( rhs.mWindow.size(), nullptr );
+        mBits.assign( rhs.mBits.size(), 0 );
+        mLo = rhs.mLo;
+        mSize = rhs.mSize;
+        mAccesses = rhs.mAccesses;
+        mTailAccesses = rhs.mTailAccesses;
+        mFarAccesses = rhs.mFarAccesses;
+        for ( int64_t idx = rhs.nextIndex( -1 ); idx < rhs.width(); idx = rhs.nextIndex( idx ) ) {
+            setSlot( idx, newNode( *rhs.mWindow[idx] ) );
+        }
+        for ( const auto& [px, node]: rhs.mTail ) {
+            mTail.emplace_hint( mTail.end(), px, newNode( *node ) );
+        }
+    }
+
+    template <bool IsConst>
+    class Iter
+    {
+    private:
+        using Owner = std::conditional_t<IsConst, const HybridLadder, HybridLadder>;
+
+        Owner* mOwner{ nullptr };
+        int64_t mIdx{ InTail };                 // the window index, InTail when in the map
+        typename Tail::const_iterator mIt{};
+
+        friend class HybridLadder;
+        template <bool> friend class Iter;
+
+        Iter( Owner* owner, const int64_t idx, const typename Tail::const_iterator it )
+        : mOwner{ owner }
+        , mIdx{ idx }
+        , mIt{ it }
+        {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = HybridLadder::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iter() = default;
+
+        // iterator -> const_iterator
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter( const Iter<false>& rhs )
+        : mOwner{ rhs.mOwner }
+        , mIdx{ rhs.mIdx }
+        , mIt{ rhs.mIt }
+        {}
+
+        reference operator*() const
+        {
+            return mIdx == InTail ? *mIt->second : *mOwner->mWindow[mIdx];
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        Iter& operator++()
+        {
+            if ( mIdx == InTail ) {
+                ++mIt;
+            } else {
+                mIdx = mOwner->nextIndex( mIdx );
+                if ( mIdx == mOwner->width() ) {
+                    mIdx = InTail;
+                    mIt = mOwner->mTail.begin();
+                }
+            }
+            return *this;
+        }
+
+        Iter operator++( int )
+        {
+            auto res = *this;
+            ++*this;
+            return res;
+        }
+
+        Iter& operator--()
+        {
+            if ( mIdx == InTail && mIt != mOwner->mTail.begin() ) {
+                --mIt;
+            } else {
+                mIdx = mOwner->prevIndex( mIdx == InTail ? mOwner->width() : mIdx );
+            }
+            return *this;
+        }
+
+        Iter operator--( int )
+        {
+            auto res = *this;
+            --*this;
+            return res;
+        }
+
+        friend bool operator==( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mIdx == rhs.mIdx && ( lhs.mIdx != InTail || lhs.mIt == rhs.mIt );
+        }
+
+        friend bool operator!=( const Iter& lhs, const Iter& rhs )
+        {
+            return !( lhs == rhs );
+        }
+    }; // class Iter
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    HybridLadder()
+    : mWindow( MinWindowTicks, nullptr )
+    , mBits( MinWindowTicks >> 6, 0 )
+    {}
+
+    HybridLadder( const HybridLadder& rhs )
+    {
+        copyFrom( rhs );
+    }
+
+    // the nodes already allocated are reused, a book copied over and over ( SmartOrderBook::syncBooks ) does not allocate
+    HybridLadder& operator=( const HybridLadder& rhs )
+    {
+        if ( this != &rhs ) {
+            clear();
+            copyFrom( rhs );
+        }
+        return *this;
+    }
+
+    // the nodes move along with the pool, what points to the levels stays valid
+    HybridLadder( HybridLadder&& rhs )
+    : HybridLadder()
+    {
+        swap( rhs );
+    }
+
+    HybridLadder& operator=( HybridLadder&& rhs )
+    {
+        if ( this != &rhs ) {
+            HybridLadder tmp{ std::move( rhs ) };
+            swap( tmp );
+        }
+        return *this;
+    }
+
+    ~HybridLadder()
+    {
+        clear();
+    }
+
+    void swap( HybridLadder& rhs )
+    {
+        std::swap( mWindow, rhs.mWindow );
+        std::swap( mBits, rhs.mBits );
+        std::swap( mLo, rhs.mLo );
+        std::swap( mTail, rhs.mTail );
+        std::swap( mSize, rhs.mSize );
+        std::swap( mPool, rhs.mPool );
+        std::swap( mFree, rhs.mFree );
+        std::swap( mAccesses, rhs.mAccesses );
+        std::swap( mTailAccesses, rhs.mTailAccesses );
+        std::swap( mFarAccesses, rhs.mFarAccesses );
+    }
+
+    iterator begin()
+    {
+        const int64_t idx = nextIndex( -1 );
+        return idx < width() ? iterator{ this, idx, {} } : iterator{ this, InTail, mTail.begin() };
+    }
+
+    const_iterator begin() const
+    {
+        const int64_t idx = nextIndex( -1 );
+        return idx < width() ? const_iterator{ this, idx, {} } : const_iterator{ this, InTail, mTail.begin() };
+    }
+
+    iterator end() { return { this, InTail, mTail.end() }; }
+    const_iterator end() const { return { this, InTail, mTail.end() }; }
+    reverse_iterator rbegin() { return reverse_iterator{ end() }; }
+    reverse_iterator rend() { return reverse_iterator{ begin() }; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator{ end() }; }
+    const_reverse_iterator rend() const { return const_reverse_iterator{ begin() }; }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    int64_t windowTicks() const
+    {
+        return width();
+    }
+
+    // the levels held in the map, beyond the window
+    size_t tailSize() const
+    {
+        return mTail.size();
+    }
+
+    iterator find( const Price px )
+    {
+        const int64_t idx = rankOf( px ) - mLo;
+        if ( idx >= 0 && idx < width() ) {
+            return mWindow[idx] ? iterator{ this, idx, {} } : end();
+        }
+        return idx < 0 ? end() : iterator{ this, InTail, mTail.find( px ) };
+    }
+
+    const_iterator find( const Price px ) const
+    {
+        const int64_t idx = rankOf( px ) - mLo;
+        if ( idx >= 0 && idx < width() ) {
+            return mWindow[idx] ? const_iterator{ this, idx, {} } : end();
+        }
+        return idx < 0 ? end() : const_iterator{ this, InTail, mTail.find( px ) };
+    }
+
+    size_t count( const Price px ) const
+    {
+        return find( px ) == end() ? 0 : 1;
+    }
+
+    LevelType& operator[]( const Price px )
+    {
+        const auto it = find( px );
+        value_type* node = it != end() ? &*it : nullptr;
+        if ( !node ) {
+            node = newNode( px, LevelType{} );
+            place( node );
+        }
+        account( px );
+        return node->second;
+    }
+
+    LevelType& at( const Price px )
+    {
+        return const_cast<LevelType&>( std::as_const( *this ).at( px ) );
+    }
+
+    const LevelType& at( const Price px ) const
+    {
+        const auto it = find( px );
+        if ( it == end() ) {
+            throw std::out_of_range( fmt::format( "[HybridLadder::at] no level at {}", px ) );
+        }
+        return it->second;
+    }
+
+    size_t erase( const Price px )
+    {
+        const auto it = find( px );
+        if ( it == end() ) {
+            return 0;
+        }
+        mSize--;
+        if ( it.mIdx == InTail ) {
+            value_type* node = it.mIt->second;
+            mTail.erase( it.mIt );
+            deleteNode( node );
+            return 1;
+        }
+
+        deleteNode( mWindow[it.mIdx] );
+        clearSlot( it.mIdx );
+        // the touch left the front half of the window, follow it
+        if ( mSize != 0 && it.mIdx < width() / 2 && !anyBefore( width() / 2 ) ) {
+            recenter( bestRank() - width() / 4, width() );
+        }
+        return 1;
+    }
+
+    // the iterator following it, like std::map::erase; found again, the erase may have recentered the window
+    iterator erase( const_iterator it )
+    {
+        auto next = std::next( it );
+        const bool last = next == end();
+        const Price next_px = last ? Price{} : next->first;
+        erase( it->first );
+        return last ? end() : find( next_px );
+    }
+
+    iterator erase( iterator it )
+    {
+        return erase( const_iterator{ it } );
+    }
+
+    void clear()
+    {
+        for ( int64_t idx = nextIndex( -1 ); idx < width(); idx = nextIndex( idx ) ) {
+            deleteNode( mWindow[idx] );
+            clearSlot( idx );
+        }
+        for ( auto& [px, node]: mTail ) {
+            deleteNode( node );
+        }
+        mTail.clear();
+        mSize = 0;
+    }
+}; // class HybridLadder
+
+
+} // namespace sob
+
+
+#endif
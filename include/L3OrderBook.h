@@ -10,37 +10,377 @@
 #include <unordered_map>
 #include <spdlog/fmt/fmt.h>
 #include <IdGen.h>
+#include <TickLadder.h>
+#include <HybridLadder.h>
+#include <FlatHashMap.h>
+#include <BookView.h>
+#include <GuessOverlay.h>
+#include <memory_resource>
+#include <algorithm>
+#include <type_traits>
 
 
 
 namespace sob {
 
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
-class L3OrderBookListener;
-
 template<typename LevelType, typename Comparator>
-using OneSideBook = std::map<double, LevelType, Comparator>;
+using OneSideBook = std::map<Price, LevelType, Comparator>;
+
+/**
+ *  @brief  The container an L3Book keeps the levels of one side in, keyed on Price, in Comparator order
+ *  @NOTE   MapSide: std::map, the default, its nodes come from the book's allocator
+ *          LadderSide: TickLadder, a dense array of ticks, for books dense around the touch
+ *          HybridSide: HybridLadder, an array for the ticks at the touch and a std::map for the tail
+ *          the ladders keep their levels in pages of their own and ignore the allocator
+ */
+struct MapSide
+{
+    template <typename LevelType, typename Comparator, typename Alloc = std::allocator<std::pair<const Price, LevelType>>>
+    using type = std::map<Price, LevelType, Comparator, Alloc>;
+}; // struct MapSide
+
+struct LadderSide
+{
+    template <typename LevelType, typename Comparator, typename Alloc = std::allocator<std::pair<const Price, LevelType>>>
+    using type = TickLadder<LevelType, Comparator>;
+}; // struct LadderSide
+
+struct HybridSide
+{
+    template <typename LevelType, typename Comparator, typename Alloc = std::allocator<std::pair<const Price, LevelType>>>
+    using type = HybridLadder<LevelType, Comparator>;
+}; // struct HybridSide
+
+
+// the allocator of a book drawing from a pool of its own, see BookArena
+using PoolAlloc = std::pmr::polymorphic_allocator<RestingOrder>;
+
+/**
+ *  @brief  Where an L3Book allocates its levels, the orders they hold and its order map entries from
+ *          Alloc is default constructed for every container, the book holds no memory of its own
+ */
+template <typename Alloc>
+class BookArena
+{
+public:
+    Alloc allocator() const
+    {
+        return Alloc{};
+    }
+}; // class BookArena
+
+/**
+ *  @brief  With a polymorphic_allocator each book owns a pool: fixed-size chunks carved out of larger blocks,
+ *              one free list per chunk size, so what a canceled order or a consumed level frees is what the
+ *              next ones take, and a book in its steady state does not call malloc
+ *  @NOTE   A copy gets a pool of its own, the pool is given back when the book goes
+ *          unsynchronized, a book is only ever updated from one thread at a time
+ */
+template <typename T>
+class BookArena<std::pmr::polymorphic_allocator<T>>
+{
+public:
+    static constexpr size_t LargestPoolBlock = size_t{ 1 } << 16;
+
+private:
+    std::pmr::unsynchronized_pool_resource mPool{ std::pmr::pool_options{ 0, LargestPoolBlock } };
+
+public:
+    BookArena() = default;
+
+    BookArena( const BookArena& )
+    {}
+
+    BookArena& operator=( const BookArena& )
+    {
+        return *this;
+    }
+
+    std::pmr::polymorphic_allocator<T> allocator()
+    {
+        return &mPool;
+    }
+
+    std::pmr::memory_resource* resource()
+    {
+        return &mPool;
+    }
+}; // class BookArena
+
+
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
+class L3OrderBookListener;
 
 /**
  *  @brief  An Orderbook that keeps information on all levels plus the order information
  *          BuffType is the type of buffer used to hold all the orders on one level
+ *          SideType is the container holding the levels of each side, see MapSide
+ *          Alloc is what the levels, the orders and the order map allocate from, PoolAlloc for a pool per book
  *  @NOTE   This is not a Template class;
  */
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
 class L3Book
     // : public L2Book
 {
+    template <typename V>
+    using Rebind = typename std::allocator_traits<Alloc>::template rebind_alloc<V>;
+
+public:
+    using Level = L3PriceLevel<BuffType, Alloc>;
+    using BidSide = typename SideType::template type<Level, BidComparator, Rebind<std::pair<const Price, Level>>>;
+    using AskSide = typename SideType::template type<Level, AskComparator, Rebind<std::pair<const Price, Level>>>;
+    using OrderIt = typename dBuffer<RestingOrder, BuffType, Alloc>::iterator;
+    using OrderMap = FlatHashMap<int, OrderIt, std::hash<int>, std::equal_to<int>, Rebind<std::pair<int, OrderIt>>>;
+
 private:
-    OneSideBook<L3PriceLevel<BuffType>, BidComparator> bidBook;
-    OneSideBook<L3PriceLevel<BuffType>, AskComparator> askBook;
-    std::unordered_map<int, typename dBuffer<Order, BuffType>::iterator> orderMap;
+    BookArena<Alloc> arena;     // first, the containers below allocate from it
+
+    // a container allocating from the arena, if it takes an allocator
+    template <typename Container>
+    Container make()
+    {
+        if constexpr ( std::uses_allocator_v<Container, Alloc> ) {
+            return Container( arena.allocator() );
+        } else {
+            return Container{};
+        }
+    }
+
+    template <typename Container>
+    Container copyOf( const Container& rhs )
+    {
+        if constexpr ( std::uses_allocator_v<Container, Alloc> ) {
+            return Container( rhs, arena.allocator() );
+        } else {
+            return Container( rhs );
+        }
+    }
+
+    BidSide bidBook{ make<BidSide>() };
+    AskSide askBook{ make<AskSide>() };
+    OrderMap orderMap{ make<OrderMap>() };
 
     size_t bidSideSize = 0;
     size_t askSideSize = 0;
 
+
+    // the levels updated since the last syncTo, by price, duplicates and all
+    std::vector<Price> dirtyBids;
+    std::vector<Price> dirtyAsks;
+    std::vector<Price> syncPrices;      // scratch for syncTo
+
+    // those of the round before the last syncTo, for a target that was left out of it
+    std::vector<Price> prevDirtyBids;
+    std::vector<Price> prevDirtyAsks;
+    bool prevRound{ false };                // whether they cover the whole round, not so right after operator=
+
+    uint64_t syncEpoch{ 0 };                // bumped by every syncTo and whenever the whole book is replaced
+    const L3Book* syncSource{ nullptr };    // the book this one was last brought in line with by syncTo
+    uint64_t syncedAt{ 0 };                 // the epoch of syncSource in which that holds
+
     // std::vector<std::shared_ptr<L3OrderBookListener<BuffType>>> listeners;
-    std::vector<L3OrderBookListener<BuffType>*> listeners;
+    std::vector<L3OrderBookListener<BuffType, SideType, Alloc>*> listeners;
+
+    TradeTally guessTally;      // what applyTrade leaves to be confirmed by the next trades, see guessFromTrade
+
+    // the level at px of side is about to change, syncTo will copy it over
+    template <typename Side>
+    void touch( const Side&, const Price px )
+    {
+        if constexpr ( std::is_same_v<Side, BidSide> ) {
+            markDirty( dirtyBids, px );
+        } else {
+            markDirty( dirtyAsks, px );
+        }
+    }
+
+    // the duplicates are dropped rather than the list grown, for the books left unsynced for long
+    static void markDirty( std::vector<Price>& dirty, const Price px )
+    {
+        if ( dirty.size() == dirty.capacity() && dirty.size() >= 64 ) {
+            std::sort( dirty.begin(), dirty.end() );
+            dirty.erase( std::unique( dirty.begin(), dirty.end() ), dirty.end() );
+        }
+        dirty.push_back( px );
+    }
+
+    // a new level holding only this order, which the order map points at
+    template <typename Side>
+    void addLevel( Side& side, const Order& order )
+    {
+        touch( side, order.price );
+        auto& level = side[order.price];
+        level.reset( order );
+        orderMap[order.orderId] = level.orders.begin();
+    }
+
+    // see guessLevel
+    template <typename Side>
+    void guessLevel( Side& side, size_t& side_size, const bool is_sell, const Price px, const int by )
+    {
+        if ( by == 0 ) {
+            return;
+        }
+        Order order( IdGenNeg::genId(), is_sell, by > 0 ? by : -by, px );
+        const auto lvl = side.find( px );
+        if ( by > 0 ) {
+            if ( lvl == side.end() ) {
+                addLevel( side, order );
+            } else {
+                touch( side, px );
+                orderMap[order.orderId] = lvl->second.addNewOrder( order, orderMap );
+            }
+            side_size += order.size;
+            return;
+        }
+        if ( lvl == side.end() ) {
+            return;
+        }
+        touch( side, px );
+        if ( order.size < lvl->second.quantity ) {
+            side_size -= lvl->second.matchOrder( order, orderMap );
+            return;
+        }
+        for ( auto it = lvl->second.orders.begin(); it != lvl->second.orders.end(); ++it ) {
+            if ( !it->dead ) {
+                orderMap.erase( it->orderId );
+            }
+        }
+        side_size -= lvl->second.quantity;
+        side.erase( px );
+    }
+
+    // the levels of side the snapshot covers are made to show it, see applySnapShot
+    template <typename Side, typename SnapSide>
+    void snapSide( const Side& side, const bool is_sell, const SnapSide& snap )
+    {
+        const auto comp = snap.key_comp();     // the side's order
+        std::vector<std::pair<Price, int>> guesses;
+        for ( const auto& [px, level]: side ) {
+            if ( !snap.empty() && comp( snap.rbegin()->first, px ) ) {
+                break;
+            }
+            if ( snap.find( px ) == snap.end() ) {
+                guesses.emplace_back( px, -level.quantity );
+            }
+        }
+        for ( const auto& [px, lvl]: snap ) {
+            const auto it = side.find( px );
+            guesses.emplace_back( px, lvl.quantity - ( it == side.end() ? 0 : it->second.quantity ) );
+        }
+        for ( const auto& [px, by]: guesses ) {
+            guessLevel( is_sell, px, by );
+        }
+    }
+
+    /**
+     *  @brief  bring target in line with this book, which it was equal to at the last syncTo: only the levels
+     *              either of them touched since are copied, the others are already the same
+     *          a target left out of the latest round, the other half of a double buffer, takes the levels touched
+     *              in that round as well
+     *  @NOTE   a target last synced from another book, or further behind, gets a full copy
+     */
+    void syncOne( L3Book& target )
+    {
+        if ( &target == this ) {
+            return;
+        }
+        const bool behind = prevRound && target.syncedAt + 1 == syncEpoch;
+        if ( target.syncSource != this || ( target.syncedAt != syncEpoch && !behind ) ) {
+            target = *this;
+        } else {
+            syncSide( bidBook, dirtyBids, behind ? &prevDirtyBids : nullptr, target.bidBook, target.dirtyBids, target );
+            syncSide( askBook, dirtyAsks, behind ? &prevDirtyAsks : nullptr, target.askBook, target.dirtyAsks, target );
+            target.bidSideSize = bidSideSize;
+            target.askSideSize = askSideSize;
+        }
+        target.dirtyBids.clear();
+        target.dirtyAsks.clear();
+        target.syncSource = this;
+        target.syncedAt = syncEpoch + 1;
+    }
+
+    template <typename Side>
+    void syncSide( const Side& side, const std::vector<Price>& dirty, const std::vector<Price>* prev_dirty,
+                   Side& target_side, const std::vector<Price>& target_dirty, L3Book& target )
+    {
+        syncPrices.clear();
+        syncPrices.insert( syncPrices.end(), dirty.begin(), dirty.end() );
+        if ( prev_dirty ) {
+            syncPrices.insert( syncPrices.end(), prev_dirty->begin(), prev_dirty->end() );
+        }
+        syncPrices.insert( syncPrices.end(), target_dirty.begin(), target_dirty.end() );
+        std::sort( syncPrices.begin(), syncPrices.end() );
+        syncPrices.erase( std::unique( syncPrices.begin(), syncPrices.end() ), syncPrices.end() );
+        for ( const auto px: syncPrices ) {
+            syncLevel( side, target_side, px, target );
+        }
+    }
+
+    // the level at px of target_side made a copy of the one in side, the order map of target following
+    template <typename Side>
+    void syncLevel( const Side& side, Side& target_side, const Price px, L3Book& target )
+    {
+        auto& target_map = target.orderMap;
+        const auto target_lvl = target_side.find( px );
+        if ( target_lvl != target_side.end() ) {
+            auto& orders = target_lvl->second.orders;
+            for ( auto it = orders.begin(); it != orders.end(); ++it ) {
+                const auto found = target_map.find( it->orderId );
+                if ( !it->dead && found != target_map.end() && found->second == it ) {
+                    target_map.erase( it->orderId );
+                }
+            }
+        }
+
+        const auto lvl = side.find( px );
+        if ( lvl == side.end() ) {
+            if ( target_lvl != target_side.end() ) {
+                target_side.erase( px );
+            }
+            return;
+        }
+        auto& level = target_lvl != target_side.end() ? target_lvl->second : target_side[px];
+        level = lvl->second;
+
+        auto it = level.orders.begin();
+        for ( auto src_it = lvl->second.orders.begin(); src_it != lvl->second.orders.end(); ++src_it, ++it ) {
+            const auto found = orderMap.find( src_it->orderId );
+            if ( !src_it->dead && found != orderMap.end() && found->second == src_it ) {
+                target_map[found->first] = it;
+            }
+        }
+    }
+
+    /**
+     *  @brief  point orderMap at the copies of the orders rhs.orderMap points at
+     *          the levels are walked side by side with those of rhs, the copies being in the same order
+     */
+    void remapOrders( const L3Book& rhs )
+    {
+        orderMap.clear();
+        orderMap.reserve( rhs.orderMap.size() );
+        remapSide( bidBook, rhs.bidBook, rhs.orderMap );
+        remapSide( askBook, rhs.askBook, rhs.orderMap );
+    }
+
+    template <typename Side>
+    void remapSide( Side& side, const Side& rhs_side, const OrderMap& rhs_map )
+    {
+        auto lvl = side.begin();
+        for ( auto rhs_lvl = rhs_side.begin(); rhs_lvl != rhs_side.end(); ++rhs_lvl, ++lvl ) {
+            auto it = lvl->second.orders.begin();
+            for ( auto rhs_it = rhs_lvl->second.orders.begin(); rhs_it != rhs_lvl->second.orders.end(); ++rhs_it, ++it ) {
+                const auto found = rhs_map.find( rhs_it->orderId );
+                if ( found != rhs_map.end() && found->second == rhs_it ) {
+                    orderMap.emplace( found->first, it );
+                }
+            }
+        }
+    }
 
 public:
 
@@ -48,48 +388,67 @@ public:
      * @brief   a custom copy constructor is necessary to deal with the iterator problem
      *           trivially copied, the copied iterators will point to the original object
      *
-     * @NOTE    This function will be O(N^2) for std::list but only O(N) for boost::circular_buffer, N is the number of orders in the whole L3Book
+     * @NOTE    O(N), N is the number of orders in the whole L3Book, whatever the BuffType
      *          We shall use it cautiously
      */
-    L3Book( const L3Book<BuffType>& rhs )
-    : bidBook { rhs.bidBook }
-    , askBook { rhs.askBook }
+    L3Book( const L3Book& rhs )
+    : bidBook { copyOf( rhs.bidBook ) }
+    , askBook { copyOf( rhs.askBook ) }
     , bidSideSize { rhs.bidSideSize }
     , askSideSize { rhs.askSideSize }
     {
-        for( auto&[ ind, it ]: rhs.orderMap ) {
-            const double px = it->price;
-            
-            if (it -> isSell) {
-                // orderMap[ind] = askBook[px].orders.begin() + ( it - const_cast<typename BuffType<Order>::iterator>(rhs.askBook.at(px).orders.begin()) );
-                orderMap[ind] = std::next(askBook[px].orders.begin(), std::distance( static_cast<typename BuffType<Order>::iterator>(it), rhs.askBook.at(px).orders.begin()));
-            } else {
-                // orderMap[ind] = bidBook[px].orders.begin() + ( it - const_cast<typename BuffType<Order>::iterator>(rhs.bidBook.at(px).orders.begin()) );
-                // orderMap[ind] = bidBook[px].orders.begin() + ( static_cast<typename BuffType<Order>::iterator>(it) - rhs.bidBook.at(px).orders.begin());
-                orderMap[ind] = std::next(bidBook[px].orders.begin(), std::distance( static_cast<typename BuffType<Order>::iterator>(it), rhs.bidBook.at(px).orders.begin()));
-            }
-        }
+        remapOrders( rhs );
     }
 
-    auto& operator= ( const L3Book<BuffType>& rhs )
+    /**
+     *  @NOTE   the books last synced from this one are no longer in line with it, their next syncTo copies it all
+     */
+    auto& operator= ( const L3Book& rhs )
     {
         bidBook = rhs.bidBook;
         askBook = rhs.askBook;
         bidSideSize = rhs.bidSideSize;
         askSideSize = rhs.askSideSize;
-        for( auto&[ ind, it ]: rhs.orderMap ) {
-            const double px = it->price;
-            if (it -> isSell) {
-                orderMap[ind] = std::next(askBook[px].orders.begin(),
-                                          std::distance( static_cast<typename BuffType<Order>::iterator>(it), rhs.askBook.at(px).orders.begin()));
-            } else {
-                orderMap[ind] = std::next(bidBook[px].orders.begin(),
-                                          std::distance( static_cast<typename BuffType<Order>::iterator>(it), rhs.bidBook.at(px).orders.begin()));
-            }
-        }
+        remapOrders( rhs );
+        dirtyBids.clear();
+        dirtyAsks.clear();
+        prevDirtyBids.clear();
+        prevDirtyAsks.clear();
+        prevRound = false;
+        syncEpoch++;
+        syncSource = nullptr;
         return *this;
     }
 
+    /**
+     *  @brief  make each of targets a copy of this book, as operator= does, at the cost of the levels touched
+     *              since the last syncTo rather than of the whole book
+     *          a level either book updated since is copied over, the order map of the target following it
+     *  @NOTE   incremental as long as the targets are updated through applyOrder and the like, and none of them
+     *              is left out of two rounds in a row: the sides handed out by getBidSide / getAskSide are not
+     *              tracked, a book assigned to or left further behind gets a full copy the next time
+     *  @NOTE   so two copies synced in turns, a double buffer, each take the levels touched over two rounds
+     */
+    template <typename... Books>
+    void syncTo( Books&... targets )
+    {
+        ( syncOne( targets ), ... );
+        std::swap( prevDirtyBids, dirtyBids );
+        std::swap( prevDirtyAsks, dirtyAsks );
+        dirtyBids.clear();
+        dirtyAsks.clear();
+        prevRound = true;
+        syncEpoch++;
+    }
+
+    /**
+     *  @brief  size the order map for that many resting orders, so that it does not grow before
+     */
+    void reserveOrders( const size_t orders )
+    {
+        orderMap.reserve( orders );
+    }
+
     size_t getBidSideSize() const
     {
         return bidSideSize;
@@ -110,20 +469,69 @@ public:
         return askBook.size();
     }
 
-    OneSideBook<L3PriceLevel<BuffType>, BidComparator>& getBidSide()
+    BidSide& getBidSide()
+    {
+        return bidBook;
+    }
+
+    AskSide& getAskSide()
+    {
+        return askBook;
+    }
+
+    // read-only, to walk the depth of a side without copying a level, see LevelView
+    const BidSide& getBidSide() const
     {
         return bidBook;
     }
 
-    OneSideBook<L3PriceLevel<BuffType>, AskComparator>& getAskSide()
+    const AskSide& getAskSide() const
     {
         return askBook;
     }
 
-    L3PriceLevel<BuffType> getBestBidL3() const
+    /**
+     *  @brief  the best levels, read in place: no order is copied, unlike getBestBidL3 / getBestAskL3
+     *  @NOTE   the view is valid until the book is next updated
+     */
+    LevelView<Level> bestBidView() const
+    {
+        if ( bidBook.empty() ) {
+            return {};
+        }
+        return LevelView<Level>{ bidBook.begin()->second };
+    }
+
+    LevelView<Level> bestAskView() const
+    {
+        if ( askBook.empty() ) {
+            return {};
+        }
+        return LevelView<Level>{ askBook.begin()->second };
+    }
+
+    /**
+     *  @brief  the best bid and ask, price and quantity, read off the first level of each side
+     *  @NOTE   built on each call and held by the caller: a const book is never written to, so readers sharing one
+     *              need no lock
+     */
+    L2PxLvlPair topOfBook() const
+    {
+        L2PxLvlPair ret;
+        if ( !bidBook.empty() ) {
+            ret.bid = bidBook.begin()->second.toL2PriceLevel();
+        }
+        if ( !askBook.empty() ) {
+            ret.ask = askBook.begin()->second.toL2PriceLevel();
+        }
+        return ret;
+    }
+
+    // a copy of the whole level, orders included, bestBidView reads it in place
+    Level getBestBidL3() const
     {
         if ( bidBook.empty() ) {
-            return L3PriceLevel<BuffType>{};
+            return Level{};
         }
         return bidBook.begin()->second;
     }
@@ -136,10 +544,11 @@ public:
         return bidBook.begin()->second.toL2PriceLevel();
     }
 
-    L3PriceLevel<BuffType> getBestAskL3() const
+    // a copy of the whole level, orders included, bestAskView reads it in place
+    Level getBestAskL3() const
     {
         if ( askBook.empty() ) {
-            return L3PriceLevel<BuffType>{};
+            return Level{};
         }
         return askBook.begin()->second;
     }
@@ -153,21 +562,27 @@ public:
     }
 
 
-    void accept( L3OrderBookListener<BuffType>* listener )
+    void accept( L3OrderBookListener<BuffType, SideType, Alloc>* listener )
     {
         // listeners.push_back( std::shared_ptr<L3OrderBookListener<BuffType>>( listener ) );
         listeners.push_back( listener );
     }
 
+    // the listener is no longer told about the book, e.g. before it goes out of scope
+    void dismiss( L3OrderBookListener<BuffType, SideType, Alloc>* listener )
+    {
+        listeners.erase( std::remove( listeners.begin(), listeners.end(), listener ), listeners.end() );
+    }
+
     bool isAggressive( const Order& order ) const
     {
         if ( order.isSell ) {
-            if ( bidBook.empty() || order.price > getBestBid().price ) {
+            if ( bidBook.empty() || order.price > bidBook.begin()->first ) {
                 return false;
             }
             return true;
         } else {
-            if ( askBook.empty() || order.price < getBestAsk().price ) {
+            if ( askBook.empty() || order.price < askBook.begin()->first ) {
                 return false;
             }
             return true;
@@ -185,17 +600,23 @@ public:
     }
 
 
-    void rmLvl( const double px )
+    void rmLvl( const Price px )
     {
+        touch( bidBook, px );
+        touch( askBook, px );
         if ( bidBook.find( px ) != bidBook.end() ) {
             for(auto& order: bidBook[px].orders) {
-                orderMap.erase( order.orderId );
+                if ( !order.dead ) {
+                    orderMap.erase( order.orderId );
+                }
             }
             bidBook.erase( px );
         }
         if ( askBook.find( px ) != askBook.end() ) {
             for(auto& order: askBook[px].orders) {
-                orderMap.erase( order.orderId );
+                if ( !order.dead ) {
+                    orderMap.erase( order.orderId );
+                }
             }
             askBook.erase( px );
         }
@@ -204,7 +625,7 @@ public:
 
 
     // std::optional<std::list<Order>::iterator> queryOrderId( const int orderId ) const
-    std::optional<typename BuffType<Order>::iterator> queryOrderId( const int orderId ) const
+    std::optional<OrderIt> queryOrderId( const int orderId ) const
     {
 #ifdef DEBUG_ORDER_MAP
         prtOrderMap();
@@ -344,30 +765,41 @@ public:
     //     }
     // }
 
-    // TODO: change the L3Level.orders.erase(it) to something better, i.e. mark an order is canceled
+    // the level drops the order in O(1), see L3PriceLevel::cancel
     bool cancelId( const int id )
     {
-        if( orderMap.find( id ) == orderMap.end() ) {
+        const auto found = orderMap.find( id );
+        if( found == orderMap.end() ) {
             return false;
         }
-        auto it = orderMap[id];
+        const auto it = found->second;
+        orderMap.erase( id );
         if ((*it).isSell) {
-            auto& L3Level = askBook[ (*it).price ];
             askSideSize -= it->size;
-            L3Level.numOrders--;
-            L3Level.quantity -= it->size;
-            L3Level.orders.erase( it );
+            touch( askBook, it->price );
+            askBook[ (*it).price ].cancel( it, orderMap );
         } else{
-            auto& L3Level = bidBook[ (*it).price ];
             bidSideSize -= it->size;
-            L3Level.numOrders--;
-            L3Level.quantity -= it->size;
-            L3Level.orders.erase( it );
+            touch( bidBook, it->price );
+            bidBook[ (*it).price ].cancel( it, orderMap );
         }
-        orderMap.erase( id );
         return true;
     }
 
+    /**
+     *  @brief  squeeze the canceled orders out of every level, for when the feed is idle
+     *  @NOTE   levels compact themselves once they hold more dead orders than live ones, this is never required
+     */
+    void compact()
+    {
+        for ( auto& [px, level]: bidBook ) {
+            level.compact( orderMap );
+        }
+        for ( auto& [px, level]: askBook ) {
+            level.compact( orderMap );
+        }
+    }
+
     // true: cancelled, false: cancel fail
     bool cancelOrder( const Order& order );
     // {
@@ -403,290 +835,71 @@ public:
         }
     }
 
-    void applySnapShot( L2Book& snapshot )
+    /**
+     *  @brief  a guessed change of by to the level px of a side, e.g. one of a GuessOverlay written into a copy:
+     *              an order of the book's own making, under the next negative id, rests at the back of the level,
+     *              or -by is taken from its front
+     *  @NOTE   unlike pureNewOrder nothing is matched against the other side, that level alone changes
+     */
+    void guessLevel( const bool is_sell, const Price px, const int by )
     {
-        for ( auto& listener: listeners ) {
-            listener->onSnapShotMsg( this, snapshot );
+        if ( is_sell ) {
+            guessLevel( askBook, askSideSize, is_sell, px, by );
+        } else {
+            guessLevel( bidBook, bidSideSize, is_sell, px, by );
         }
+    }
 
-        // bidBook.clear();
-        // askBook.clear();
-        // bidSideSize = 0;
-        // askSideSize = 0;
-        // orderMap.clear();
-        //
-        // for( auto&[ px, lvl ]: snapshot.getBidSide() ) {
-        //     Order new_order{ fmt::format( "N {} 0 {} {}", IdGenNeg::getInstance().genId(), lvl.quantity, px )};
-        //     pureNewOrder( new_order );
-        // }
-        // for( auto&[ px, lvl ]: snapshot.getAskSide() ) {
-        //     Order new_order{ fmt::format( "N {} 1 {} {}", IdGenNeg::getInstance().genId(), lvl.quantity, px )};
-        //     pureNewOrder( new_order );
-        // }
-
-        // std::vector<Order> toApply;
-
-        for( auto&[ px, L3lvl ]: bidBook ) {
-            if ( snapshot.getBidSide().find( px ) == snapshot.getBidSide().end() ) {
-                // remove the level in old L3 book that's no longer there
-                Order new_order( fmt::format( "N {} 1 {} {}", 
-                                 IdGenNeg::getInstance().genId(),
-                                 L3lvl.quantity,
-                                 px)
-                                );
-                pureNewOrder( new_order );
-                // toApply.emplace_back( new_order );
-                // rmLvl( px );
-            }
-            break;
-        }
-
-        for( auto&[ px, L3lvl ]: askBook ) {
-            if ( snapshot.getAskSide().find( px ) == snapshot.getAskSide().end() ) {
-                Order new_order( fmt::format( "N {} 0 {} {}", 
-                                 IdGenNeg::getInstance().genId(),
-                                 L3lvl.quantity,
-                                 px) );
-                pureNewOrder( new_order );
-                // toApply.emplace_back( new_order );
-                // rmLvl( px );
-            }
-            break;
-        }
-
-        for ( auto& [px, lvl]: snapshot.getBidSide() ) {
-            if ( bidBook.find( px ) == bidBook.end() ) {
-                Order new_order( fmt::format( "N {} 0 {} {}", 
-                                 IdGenNeg::getInstance().genId(),
-                                 lvl.quantity,
-                                 px
-                                ));
-                // toApply.emplace_back( new_order );
-                pureNewOrder( new_order );
-            } else {
-                if ( lvl.quantity > bidBook[px].quantity ) {
-                    Order new_order( fmt::format( "N {} 0 {} {}", 
-                                     IdGenNeg::getInstance().genId(),
-                                     lvl.quantity - bidBook[px].quantity,
-                                     px));
-                    // bidBook[px].matchOrder( new_order, orderMap );
-                    bidBook[px].orders.push_back( new_order );
-                } else {
-                    Order new_order( fmt::format( "N {} 1 {} {}", 
-                                     IdGenNeg::getInstance().genId(),
-                                     lvl.quantity - bidBook[px].quantity,
-                                     px));
-                    bidBook[px].matchOrder( new_order, orderMap );
-                }
-            }
+    /**
+     *  @brief  tell the listeners about a trade / a snapshot without applying it,
+     *              what it implies is kept apart from the book, see GuessOverlay
+     */
+    void announce( const Trade& trade )
+    {
+        for ( auto& listener: listeners ) {
+            listener->onTradeMsg( this, trade );
         }
+    }
 
-        for ( auto& [px, lvl]: snapshot.getAskSide() ) {
-            if ( askBook.find( px ) == askBook.end() ) {
-                Order new_order( fmt::format( "N {} 1 {} {}", 
-                                 IdGenNeg::getInstance().genId(),
-                                 lvl.quantity,
-                                 px));
-                pureNewOrder( new_order );
-            } else {
-                if ( lvl.quantity > askBook[px].quantity ) {
-                    Order new_order( fmt::format( "N {} 1 {} {}", 
-                                     IdGenNeg::getInstance().genId(),
-                                     lvl.quantity - askBook[px].quantity,
-                                     px));
-                    // askBook[px].matchOrder( new_order, orderMap );
-                    askBook[px].orders.push_back( new_order );
-                } else {
-                    Order new_order( fmt::format( "N {} 0 {} {}", 
-                                     IdGenNeg::getInstance().genId(),
-                                     lvl.quantity - askBook[px].quantity,
-                                     px));
-                    askBook[px].matchOrder( new_order, orderMap );
-                }
-            }
+    void announce( L2Book& snapshot )
+    {
+        for ( auto& listener: listeners ) {
+            listener->onSnapShotMsg( this, snapshot );
         }
     }
 
+    /**
+     *  @brief  an order of the book's own making, under the next negative id, matched or rested as any other
+     *              but not announced, see guessFromTrade
+     */
+    void guessOrder( const bool is_sell, const int size, const Price px )
+    {
+        Order order( IdGenNeg::genId(), is_sell, size, px );
+        pureNewOrder( order );
+    }
+
     /**
      *  @brief  Happens when trade stream leads L3 Order Stream and L2 Snapshot Stream
+     *          the orders the trade implies are applied to the book itself, see guessFromTrade
+     *  @NOTE   SmartOrderBook keeps them apart from its ground truth instead, see GuessOverlay
      */
     void applyTrade( Trade& trade )
     {
-
-        for ( auto& listener: listeners ) {
-            listener->onTradeMsg( this, trade );
-        }
-
-        if( trade.isSell ) {
-            // Seller is the liquidity taker
-            const auto best_bid_px = getBestBid().price;
-            const int lvl_cnt = trade.getLvlCnt();
-
-            if (lvl_cnt == 1) {
-                const auto trd_px = trade.price[0];
-                
-                static std::unordered_map<double, int> recored_trds_vol;
-                static double last_unconsumed_lvl = 0;
-
-                if( trd_px > best_bid_px ) {
-                    /* *******************************************
-                     * There has to be some new bid orders at the trd_px which haven't arrived
-                     * Then come this trade, initiated by some selling liquidity taker
-                     *
-                     * !!! There is most likely some liquidity left on the traded lvl
-                     * !!! We can't have an accurate guess about how much liquidity there is left on that level, 
-                     * !!! therefore we hold on the guess until that level has been totally consumed
-                     * *******************************************/
-
-                    if ( last_unconsumed_lvl == 0 || trd_px == last_unconsumed_lvl ) {
-                        recored_trds_vol[trd_px] += trade.getTotalVol();
-                    } else {
-                        /* *******************************************
-                         * !!! Now the last_unconsumed_lvl has bee consumed;;
-                         * !!! We may now make a guess:
-                         *          That price level is now on the ask side
-                         *          The guessed ask side size is: 2 * ( recored_trds_vol[trd_px] + trade.getTotalVol() )
-                         *          For simplicity, we just guess that there is one order there
-                         * *******************************************/
-                        Order tmp_order( fmt::format("N {} 1 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     2 * recored_trds_vol[trd_px],
-                                                     last_unconsumed_lvl ) ) ;
-                        pureNewOrder( tmp_order );
-                        recored_trds_vol.erase( last_unconsumed_lvl );
-                    }
-                    last_unconsumed_lvl = trd_px;
-                } else if ( trd_px == best_bid_px ) {
-                    /* *******************************************
-                     * This has been a very logical trade message, we should just reflect the information in the orderbook
-                     *  NOTE: I'm simplifying this logic, to only estimate the untraded quantity using the last trade mesage
-                     *        The best level
-                     * *******************************************/
-                    const auto trd_qty = trade.getTotalVol();
-                    if ( trd_qty < getBestBid().quantity ) {
-                        // simply reflect the trade information on the book
-                        Order tmp_order( fmt::format("N {} 1 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     trd_qty,
-                                                     best_bid_px ) );
-                        pureNewOrder( tmp_order );
-                    } else {
-                        // trade quantity + not yet received aggresive orders
-                        Order tmp_order( fmt::format("N {} 1 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     3 * trd_qty,
-                                                     best_bid_px ) ) ;
-                        pureNewOrder( tmp_order );
-                    }
-
-                    if( last_unconsumed_lvl > best_bid_px ) {
-                        Order tmp_order( fmt::format("N {} 1 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     2 * recored_trds_vol[last_unconsumed_lvl],
-                                                     last_unconsumed_lvl ) ) ;
-                        pureNewOrder( tmp_order );
-                        recored_trds_vol.erase( last_unconsumed_lvl );
-                        last_unconsumed_lvl = 0;
-                    }
-                    
-                } else {
-                    // throw std::runtime_error( "unexpected trade message, there has to have been out-of-order or lost trades" );
-                    spdlog::warn( "unexpected trade message, there has to have been out-of-order or lost trades, do nothing" );
-                }
-            } else {
-                /* *******************************************
-                 * This is a trade-through order, apply the order first and then add an ask order of 2 * total traded volume on the best bid level
-                 * *******************************************/
-                const auto total_trd_vol = trade.getTotalVol();
-                Order tmp_order( fmt::format("N {} 1 {} {}", 
-                                      IdGenNeg::getInstance().genId(),
-                                      total_trd_vol, 
-                                      trade.price[0] ) );
-                pureNewOrder( tmp_order );
-
-                Order tmp_order_( fmt::format("N {} 1 {} {}", 
-                                      IdGenNeg::getInstance().genId(),
-                                      2 * total_trd_vol, 
-                                      best_bid_px ) );
-                pureNewOrder( tmp_order_ );
-            }
-        } else {
-            // Seller is the liquidity taker
-            const auto best_ask_px = getBestAsk().price;
-            const int lvl_cnt = trade.getLvlCnt();
-
-            if (lvl_cnt == 1) {
-                const auto trd_px = trade.price[0];
-                
-                static std::unordered_map<double, int> recorded_trds_vol_;
-                static double last_unconsumed_lvl_ = 0;
-                // spdlog::warn("last_unconsumed_lvl_ = {}", last_unconsumed_lvl_);
-                if( trd_px < best_ask_px ) {
-
-                    if ( last_unconsumed_lvl_ == 0 || trd_px == last_unconsumed_lvl_ ) {
-                        recorded_trds_vol_[trd_px] += trade.getTotalVol();
-                    } else {
-                        Order tmp_order( fmt::format("N {} 0 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     2 * recorded_trds_vol_[trd_px],
-                                                     last_unconsumed_lvl_ ) );
-                        pureNewOrder( tmp_order );
-                        recorded_trds_vol_.erase( last_unconsumed_lvl_ );
-                    }
-                    last_unconsumed_lvl_ = trd_px;
-
-                } else if ( trd_px == best_ask_px ) {
-                    const auto trd_qty = trade.getTotalVol();
-                    if ( trd_qty < getBestBid().quantity ) {
-                        // simply reflect the trade information on the book
-                        Order tmp_order( fmt::format("N {} 0 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     trd_qty,
-                                                     best_ask_px ) );
-                        pureNewOrder( tmp_order );
-                    } else {
-                        // trade quantity + not yet received aggresive orders
-                        Order tmp_order( fmt::format("N {} 0 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     3 * trd_qty,
-                                                     best_ask_px ) );
-                        pureNewOrder( tmp_order );
-                    }
-
-                    if( last_unconsumed_lvl_ < best_ask_px ) {
-                        // spdlog::warn("i am here, last_unconsumed_lvl_ = {}", last_unconsumed_lvl_);
-                        Order tmp_order( fmt::format("N {} 0 {} {}", 
-                                                     IdGenNeg::getInstance().genId(),
-                                                     2 * recorded_trds_vol_[last_unconsumed_lvl_],
-                                                     last_unconsumed_lvl_ ) ) ;
-                        pureNewOrder( tmp_order );
-                        recorded_trds_vol_.erase( last_unconsumed_lvl_ );
-                        last_unconsumed_lvl_ = 0;
-                    }
-                    
-                } else {
-                    spdlog::warn( "unexpected trade message, there has to have been out-of-order or lost trades, do nothing" );
-                }
-            } else {
-                /* *******************************************
-                 * This is a trade-through order, apply the order first and then add an ask order of 2 * total traded volume on the best bid level
-                 * *******************************************/
-                const auto total_trd_vol = trade.getTotalVol();
-                Order tmp_order( fmt::format("N {} 0 {} {}", 
-                                      IdGenNeg::getInstance().genId(),
-                                      total_trd_vol, 
-                                      trade.price[trade.getLvlCnt()-1] ) );
-                pureNewOrder( tmp_order );
-
-                Order tmp_order_(fmt::format("N {} 0 {} {}", 
-                                      IdGenNeg::getInstance().genId(),
-                                      2 * total_trd_vol, 
-                                      best_ask_px ) );
-                pureNewOrder( tmp_order_ );
-            }
-        }
+        announce( trade );
+        guessFromTrade( *this, guessTally, trade );
     }
 
+    /**
+     *  @brief  Happens when snapshot stream leads: the levels it covers, down to the last one it lists, are made
+     *              to show it with orders of the book's own making, see guessLevel, the others are gone
+     *  @NOTE   as GuessOverlay::applySnapShot, on the book itself
+     */
+    void applySnapShot( L2Book& snapshot )
+    {
+        announce( snapshot );
+        snapSide( bidBook, false, snapshot.getBidSide() );
+        snapSide( askBook, true, snapshot.getAskSide() );
+    }
 
     L3Book( std::vector<Order>& orders )
     {
@@ -700,12 +913,12 @@ public:
 
     auto getBestMarketL3() const
     {
-        L3PxLvlPair<BuffType> ret;
+        L3PxLvlPair<BuffType, Alloc> ret;
         if ( !askBook.empty() ) {
-            ret.ask = std::optional<L3PriceLevel<BuffType>>{askBook.begin()->second};
+            ret.ask = std::optional<Level>{askBook.begin()->second};
         }
         if ( !bidBook.empty() ) {
-            ret.bid = std::optional<L3PriceLevel<BuffType>>{bidBook.begin()->second};
+            ret.bid = std::optional<Level>{bidBook.begin()->second};
         }
         return ret;
     }
@@ -713,7 +926,7 @@ public:
     // to keep it the same interface as L2Book
     auto getBestMarket() const
     {
-        return getBestMarketL3().toL2PxLvlPair();
+        return topOfBook();
     }
 
 
@@ -8,26 +8,31 @@
 
 namespace sob {
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType, typename Alloc>
 class L3OrderBookListener
 {
 public:
     L3OrderBookListener()
     {}
 
-    void subscribe( std::shared_ptr<L3Book<BuffType>> book )
+    void subscribe( std::shared_ptr<L3Book<BuffType, SideType, Alloc>> book )
     {
         book -> accept( this );
     }
 
-    L3OrderBookListener(std::shared_ptr<L3Book<BuffType>> book)
+    void unsubscribe( std::shared_ptr<L3Book<BuffType, SideType, Alloc>> book )
+    {
+        book -> dismiss( this );
+    }
+
+    L3OrderBookListener(std::shared_ptr<L3Book<BuffType, SideType, Alloc>> book)
     {
         subscribe( book );
     }
 
-    virtual void onBookUpdate( L3Book<BuffType>* book, const Order& order ) = 0;
-    virtual void onTradeMsg( L3Book<BuffType>* book, const Trade& trade ) = 0;
-    virtual void onSnapShotMsg( L3Book<BuffType>* book, L2Book& snapshot ) = 0;
+    virtual void onBookUpdate( L3Book<BuffType, SideType, Alloc>* book, const Order& order ) = 0;
+    virtual void onTradeMsg( L3Book<BuffType, SideType, Alloc>* book, const Trade& trade ) = 0;
+    virtual void onSnapShotMsg( L3Book<BuffType, SideType, Alloc>* book, L2Book& snapshot ) = 0;
 
 }; // class L3OrderBookListener
 
@@ -0,0 +1,117 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <Tokenizer.h>
+
+
+namespace sob {
+
+/**
+ *  @brief  Read-only memory mapping of a whole file
+ *          Nothing is copied, the pages are faulted in by the kernel when they are touched
+ *  @NOTE   Throws std::runtime_error if the file cannot be opened or mapped
+ */
+class MappedFile
+{
+private:
+    int mFd{ -1 };
+    const char* mData{ nullptr };
+    size_t mSize{ 0 };
+
+public:
+    explicit MappedFile( const std::string& path );
+    ~MappedFile();
+
+    MappedFile( const MappedFile& ) = delete;
+    MappedFile& operator=( const MappedFile& ) = delete;
+
+    MappedFile( MappedFile&& rhs ) noexcept;
+    MappedFile& operator=( MappedFile&& rhs ) noexcept;
+
+    std::string_view view() const
+    {
+        return { mData, mSize };
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    /**
+     *  @brief  tell the kernel the bytes in [0, end) will not be read again, so their pages can leave the RSS
+     *          Only whole pages are released, the page holding end is kept
+     */
+    void release( const size_t end ) const;
+}; // class MappedFile
+
+
+/**
+ *  @brief  Hands out the lines of a MappedFile as string_views, one at a time
+ *          Consumed pages are released every ReleaseStride bytes so that memory use does not grow with the file size
+ *  @NOTE   The views stay valid as long as the MappedFile is alive and the line has not been released,
+ *              i.e. until the next call to next()
+ */
+class LineReader
+{
+private:
+    static constexpr size_t ReleaseStride = 8u << 20;
+
+    const MappedFile& mFile;
+    size_t mPos{ 0 };
+    size_t mReleased{ 0 };
+
+public:
+    explicit LineReader( const MappedFile& file )
+    : mFile{ file }
+    {}
+
+    // false once the file is exhausted, a trailing '\r' is stripped
+    bool next( std::string_view& line );
+}; // class LineReader
+
+
+/**
+ *  @brief  Hands out the lines of a MappedFile a batch at a time, already split into fields by the Tokenizer
+ *          Consumed pages are released like LineReader does
+ *  @NOTE   The batch refers to the mapping, it stays valid until the next call to next()
+ */
+class TokenReader
+{
+private:
+    static constexpr size_t ReleaseStride = 8u << 20;
+
+    const MappedFile& mFile;
+    const size_t mBatchLines;
+    const SimdLevel mLevel;
+    size_t mPos{ 0 };
+    size_t mReleased{ 0 };
+
+public:
+    static constexpr size_t DefaultBatchLines = 1024;
+
+    explicit TokenReader( const MappedFile& file, const size_t batch_lines = DefaultBatchLines,
+                          const SimdLevel level = BestSimdLevel )
+    : mFile{ file }
+    , mBatchLines{ batch_lines }
+    , mLevel{ level }
+    {}
+
+    // continue from the start of a line, e.g. an offset taken from a StreamIndex
+    void seek( const size_t pos )
+    {
+        mPos = pos;
+    }
+
+    // false once the file is exhausted, otherwise batch holds at least one line
+    bool next( TokenBatch& batch );
+}; // class TokenReader
+
+
+} // namespace sob
+
+
+#endif
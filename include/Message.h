@@ -0,0 +1,74 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include <Order.h>
+#include <OrderBook.h>
+#include <Trade.h>
+#include <MsgParser.h>
+#include <Tokenizer.h>
+#include <variant>
+#include <string_view>
+
+
+namespace sob {
+
+/**
+ *  @brief  One decoded message of any of the three streams
+ */
+using Message = std::variant<Order, Trade, L2Book>;
+
+/**
+ *  @brief  decode the fields of one text message into msg, never throws
+ *          Cursor is a FieldCursor over the raw line or a TokenCursor over a tokenised one
+ *  @NOTE   if msg already holds the right alternative it is decoded in place,
+ *              so reusing a Message for messages of the same kind keeps the buffers of its Trade / L2Book
+ */
+template <typename Cursor>
+ParseError decodeFields( Cursor cur, Message& msg )
+{
+    auto peek = cur;
+    const auto type = peek.next();
+    if ( type.size() != 1 ) {
+        return type.empty() ? ParseError::Empty : ParseError::UnknownType;
+    }
+
+    switch ( type[0] )
+    {
+        case 'N':
+        case 'C':
+        case 'R':
+            if ( !std::holds_alternative<Order>( msg ) ) {
+                msg.emplace<Order>();
+            }
+            return Order::parseFields( cur, std::get<Order>( msg ) );
+        case 'T':
+            if ( !std::holds_alternative<Trade>( msg ) ) {
+                msg.emplace<Trade>();
+            }
+            return Trade::parseFields( cur, std::get<Trade>( msg ) );
+        case 'S':
+            if ( !std::holds_alternative<L2Book>( msg ) ) {
+                msg.emplace<L2Book>();
+            }
+            return L2Book::parseFields( cur, std::get<L2Book>( msg ) );
+        default:
+            return ParseError::UnknownType;
+    }
+}
+
+inline ParseError decodeMessage( std::string_view str, Message& msg )
+{
+    return decodeFields( FieldCursor{ str }, msg );
+}
+
+// line i of a batch filled by Tokenizer::tokenize()
+inline ParseError decodeMessage( const TokenBatch& batch, const size_t i, Message& msg )
+{
+    return decodeFields( batch.cursor( i ), msg );
+}
+
+
+} // namespace sob
+
+
+#endif
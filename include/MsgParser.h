@@ -0,0 +1,144 @@
+#ifndef MSG_PARSER_H
+#define MSG_PARSER_H
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+
+namespace sob {
+
+/**
+ *  @brief  Result of decoding one serialised message, see the "Serialised Stream format" in README.md
+ *  @NOTE   The parsers never throw, malformed lines are reported through this code
+ */
+enum class ParseError
+{
+    Ok,
+    Empty,          // nothing but whitespace in the line
+    UnknownType,    // leading message tag is not one of N, C, R, T, S
+    MissingField,   // line ended before all mandatory fields were read
+    BadField,       // a field is not a valid number
+    TrailingData    // extra fields after a complete message
+}; // enum class ParseError
+
+inline std::string_view toString( const ParseError err )
+{
+    switch ( err )
+    {
+        case ParseError::Ok:            return "Ok";
+        case ParseError::Empty:         return "Empty";
+        case ParseError::UnknownType:   return "UnknownType";
+        case ParseError::MissingField:  return "MissingField";
+        case ParseError::BadField:      return "BadField";
+        case ParseError::TrailingData:  return "TrailingData";
+    }
+    return "Unknown";
+}
+
+inline bool isFieldSep( const char c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// a whole field as a number, std::from_chars has to consume all of it
+template <typename T>
+ParseError decodeField( std::string_view field, T& out )
+{
+    if ( field.empty() ) {
+        return ParseError::MissingField;
+    }
+    const auto [ ptr, ec ] = std::from_chars( field.data(), field.data() + field.size(), out );
+    if ( ec != std::errc{} || ptr != field.data() + field.size() ) {
+        return ParseError::BadField;
+    }
+    return ParseError::Ok;
+}
+
+// isSell style flags are serialised as 0 or 1
+inline ParseError decodeField( std::string_view field, bool& out )
+{
+    int flag{};
+    const auto err = decodeField( field, flag );
+    if ( err != ParseError::Ok ) {
+        return err;
+    }
+    if ( flag != 0 && flag != 1 ) {
+        return ParseError::BadField;
+    }
+    out = ( flag == 1 );
+    return ParseError::Ok;
+}
+
+/**
+ *  @brief  The typed reads shared by the field cursors, Cursor only has to provide next()
+ *          The message decoders are written against this interface: next(), atEnd() and read( ... )
+ */
+template <typename Cursor>
+class FieldReader
+{
+public:
+    template <typename T>
+    ParseError read( T& out )
+    {
+        return decodeField( static_cast<Cursor*>( this )->next(), out );
+    }
+
+    template <typename T, typename... Rest>
+    ParseError read( T& out, Rest&... rest )
+    {
+        const auto err = read( out );
+        if ( err != ParseError::Ok ) {
+            return err;
+        }
+        return read( rest... );
+    }
+}; // class FieldReader
+
+/**
+ *  @brief  Walks the whitespace separated fields of one message in place
+ *          Numbers are decoded with std::from_chars, so there is no locale, no stream and no allocation involved
+ */
+class FieldCursor : public FieldReader<FieldCursor>
+{
+private:
+    const char* mCur;
+    const char* mEnd;
+
+    void skipSeps()
+    {
+        while ( mCur != mEnd && isFieldSep( *mCur ) ) {
+            ++mCur;
+        }
+    }
+
+public:
+    explicit FieldCursor( std::string_view msg )
+    : mCur{ msg.data() }
+    , mEnd{ msg.data() + msg.size() }
+    {}
+
+    // true if only whitespace is left
+    bool atEnd()
+    {
+        skipSeps();
+        return mCur == mEnd;
+    }
+
+    // the next raw field, empty if the line is exhausted
+    std::string_view next()
+    {
+        skipSeps();
+        const char* begin = mCur;
+        while ( mCur != mEnd && !isFieldSep( *mCur ) ) {
+            ++mCur;
+        }
+        return std::string_view( begin, mCur - begin );
+    }
+}; // class FieldCursor
+
+
+} // namespace sob
+
+
+#endif
@@ -11,19 +11,17 @@
 #include <sstream>
 #include <optional>
 #include <algorithm>
+#include <type_traits>
 #include <string_view>
 #include <dBuffer.h>
+#include <MsgParser.h>
+#include <Price.h>
 
 
 namespace sob {
 
 
 
-struct OrderInfo
-{
-    // what should I put in here?
-}; // struct OrderInfo
-
 enum class OrderType
 {
     Normal,
@@ -37,16 +35,14 @@ struct Order
     int orderId;
     bool isSell;
     int size;
-    double price;
+    Price price;
 
     bool bIsCancel{false}; // for cancel order
     bool bIsReprice{false}; // for cancel order
     std::optional<int> oldId; // for cancel and reprice orders
-    std::optional<double> oldPx; // for reprice order, if this is not null, then it is a reprice order
+    std::optional<Price> oldPx; // for reprice order, if this is not null, then it is a reprice order
     std::optional<int> oldSz; // for reprice order, if this is not null, then it is a reprice order
 
-    std::shared_ptr<OrderInfo> info;
-
     OrderType getType() const
     {
         if( bIsCancel ) {
@@ -114,40 +110,147 @@ struct Order
         return ss.str();
     }
 
+    // the serialised stream format, the inverse of Order::parse
+    std::string to_simple_string() const
+    {
+        const char type = isCancel() ? 'C' : ( isReprice() ? 'R' : 'N' );
+        std::string res = fmt::format( "{} {} {} {} {}", type, orderId, isSell ? 1 : 0, size, price );
+        if ( isCancel() ) {
+            res += fmt::format( " {} 0 0", *oldId );
+        } else if ( isReprice() ) {
+            res += fmt::format( " {} {} {}", *oldId, *oldPx, *oldSz );
+        }
+        return res;
+    }
+
+    Order() = default;
+
+    // the normal order "N order_id is_sell size_ px" parses to, with no message in between
+    Order( const int order_id, const bool is_sell, const int size_, const Price px )
+    : orderId( order_id ), isSell( is_sell ), size( size_ ), price( px )
+    {}
+
     // fmt: type{Normal{'N'}, cancel{'C'}, reprice{'R'}}, orderId, isSell {0, 1}, size, price, [oldId], [oldPx], [oldSz]
     Order( const std::string& str )
     {
-        std::stringstream ss(str);
-        try {
-            std::string type; 
-            ss >> type;
-            if (type == "N") {
-                ss >> orderId >> isSell >> size >> price; 
-            } else if (type == "C") {
-                ss >> orderId ;
-                bIsCancel = true;
-                int _{};
-                ss >> _ >> _ >> _ >> *oldId >> _ >> _;
-                // std::cout << "Got oldId: " << *oldId << std::endl;
-            } else if (type == "R") {
-                ss >> orderId >> isSell >> size >> price >> *oldId >> *oldPx >> *oldSz;
-                // std::cout << "old ID: " << *oldId << std::endl;
-                // std::cout << "old Px: " << *oldPx << std::endl;
-                // std::cout << "old Sz: " << *oldSz << std::endl;
-                bIsReprice = true;
+        const auto err = parse( str, *this );
+        if ( err != ParseError::Ok ) {
+            spdlog::error("Got error when reading Order from string: {}, the error: {}"
+                          , str, sob::toString( err ));
+            throw std::runtime_error( "[Order::Order] malformed order message" );
+        }
+    }
+
+    /**
+     *  @brief  decode an order message in place, never allocates nor throws
+     *  @NOTE   [oldPx] [oldSz] are optional for cancel orders, they are not used anyway
+     */
+    static ParseError parse( std::string_view msg, Order& out )
+    {
+        FieldCursor cur{ msg };
+        return parseFields( cur, out );
+    }
+
+    // same as parse(), over any field cursor, e.g. the pre-tokenised TokenCursor
+    template <typename Cursor>
+    static ParseError parseFields( Cursor& cur, Order& out )
+    {
+        const auto type = cur.next();
+        if ( type.empty() ) {
+            return ParseError::Empty;
+        }
+        if ( type.size() != 1 ) {
+            return ParseError::UnknownType;
+        }
+
+        out.bIsCancel = false;
+        out.bIsReprice = false;
+        out.oldId.reset();
+        out.oldPx.reset();
+        out.oldSz.reset();
+
+        ParseError err{};
+        if ( type[0] == 'N' ) {
+            err = cur.read( out.orderId, out.isSell, out.size, out.price );
+        } else if ( type[0] == 'C' ) {
+            int old_id{};
+            err = cur.read( out.orderId, out.isSell, out.size, out.price, old_id );
+            if ( err == ParseError::Ok && !cur.atEnd() ) {
+                Price old_px{};
+                int old_sz{};
+                err = cur.read( old_px, old_sz );
             }
-        } catch ( const std::exception& e ) {
-            spdlog::error("Got error when reading L2PriceLevel from string: {}, the exception: {}"
-                          , str, e.what());
-            throw;
+            out.bIsCancel = true;
+            out.oldId = old_id;
+        } else if ( type[0] == 'R' ) {
+            int old_id{};
+            Price old_px{};
+            int old_sz{};
+            err = cur.read( out.orderId, out.isSell, out.size, out.price, old_id, old_px, old_sz );
+            out.bIsReprice = true;
+            out.oldId = old_id;
+            out.oldPx = old_px;
+            out.oldSz = old_sz;
+        } else {
+            return ParseError::UnknownType;
+        }
+
+        if ( err != ParseError::Ok ) {
+            return err;
         }
+        return cur.atEnd() ? ParseError::Ok : ParseError::TrailingData;
     }
 
+
 }; // struct Order
 
+
+/**
+ *  @brief  What a level keeps of an order resting on it: the cancel and reprice fields only ever matter
+ *              to the message, so they stay on Order; dead fits in the padding
+ *  @NOTE   Trivially copyable and 24 bytes, against the 80 of an Order: a level buffer growing or a book
+ *              being copied moves its orders as plain memory, with no optional or refcount to copy
+ */
+struct RestingOrder
+{
+    Price price;
+    int orderId;
+    int size;
+    bool isSell;
+    bool dead{ false };     // canceled, left in place until its level is compacted, see L3PriceLevel::cancel
+
+    RestingOrder() = default;
+
+    RestingOrder( const Order& order )
+    : price( order.price ), orderId( order.orderId ), size( order.size ), isSell( order.isSell )
+    {}
+
+    // printed as the new order it rests from
+    friend std::ostream& operator<<( std::ostream& os, const RestingOrder& o )
+    {
+        os << "Odr{N"
+           << ", id=" << o.orderId
+           << ", " << ( o.isSell ? "sell" : "buy" )
+           << ", sz=" << o.size
+           << ", px=" << o.price
+           << "}";
+        return os;
+    }
+
+    std::string toString() const
+    {
+        std::stringstream ss;
+        ss << *this;
+        return ss.str();
+    }
+}; // struct RestingOrder
+
+static_assert( std::is_trivially_copyable_v<RestingOrder> );
+static_assert( sizeof( RestingOrder ) <= 32 );
+
 struct L2PriceLevel
 {
-    double price;
+    Price price;
     int quantity;
 
     friend std::ostream& operator<<(std::ostream& os, const L2PriceLevel& l)
@@ -167,20 +270,19 @@ struct L2PriceLevel
 
     L2PriceLevel() = default;
 
-    L2PriceLevel( const double px, const int qty )
+    L2PriceLevel( const Price px, const int qty )
     : price{px}, quantity{qty}
     {}
 
     // fmt: px, qty
     L2PriceLevel( const std::string& str )
     {
-        std::stringstream ss(str);
-        try {
-            ss >> price >> quantity;
-        } catch ( const std::exception& e ) {
-            spdlog::error("Got error when reading L2PriceLevel from string: {}, the exception: {}"
-                          , str, e.what());
-            throw;
+        FieldCursor cur{ str };
+        const auto err = cur.read( price, quantity );
+        if ( err != ParseError::Ok ) {
+            spdlog::error("Got error when reading L2PriceLevel from string: {}, the error: {}"
+                          , str, sob::toString( err ));
+            throw std::runtime_error( "[L2PriceLevel::L2PriceLevel] malformed price level" );
         }
     }
 
@@ -229,15 +331,25 @@ struct L2PxLvlPair
 }; // sturct L2PxLvlPair
 
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
+/**
+ *  @brief  the orders resting on one level, in time priority
+ *  @NOTE   Alloc is what the orders buffer allocates from; a book hands its own to the levels it creates,
+ *              the allocator-extended constructors let containers do so through uses-allocator construction
+ */
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename Alloc = std::allocator<RestingOrder>>
 struct L3PriceLevel
 {
-    double price;
+    using allocator_type = Alloc;
+
+    Price price;
     int quantity;
     int numOrders;
     // std::list<Order> orders;
     // dBuffer<Order, boost::circular_buffer> orders;
-    dBuffer<Order, BuffType> orders;
+    dBuffer<RestingOrder, BuffType, Alloc> orders;
+
+    using OrderIt = typename dBuffer<RestingOrder, BuffType, Alloc>::iterator;
 
     friend std::ostream& operator<<(std::ostream& os, const L3PriceLevel& l)
     {
@@ -273,7 +385,8 @@ struct L3PriceLevel
         return std::prev( orders.end() );
     }
 
-    auto addNewOrder( const Order& order, std::unordered_map<int, typename BuffType<Order>::iterator>& orderMap)
+    template <typename OrderMap>
+    auto addNewOrder( const Order& order, OrderMap& )
     {
         assert( price == order.price );
         quantity += order.size;
@@ -285,7 +398,8 @@ struct L3PriceLevel
     // order must not take all the liquidity
     // return how much liquidity is taken
     // size_t matchOrder( Order& order, std::unordered_map<int, std::list<Order>::iterator>& orderMap)
-    size_t matchOrder( Order& order, std::unordered_map<int, typename BuffType<Order>::iterator>& orderMap)
+    template <typename OrderMap>
+    size_t matchOrder( Order& order, OrderMap& orderMap)
     {
         size_t res{};
         while (true) {
@@ -294,11 +408,12 @@ struct L3PriceLevel
                 const auto popped_id = orders.front().orderId;
                 order.size -= front_order.size;
                 res += front_order.size;
-                orders.pop_front();
-                orderMap.erase( popped_id );
-
                 numOrders -= 1;
                 quantity -= front_order.size;
+
+                // front_order goes with it
+                orders.pop_front();
+                orderMap.erase( popped_id );
             } else {
                 orders.front().size -= order.size;
                 res += order.size;
@@ -341,7 +456,50 @@ struct L3PriceLevel
     //     return res;
     // }
 
+    // erasing from the orders leaves the iterators on the others valid, the order goes at once
+    template <typename OrderMap>
+    void cancel( const OrderIt it, OrderMap& )
+    {
+        quantity -= it->size;
+        numOrders -= 1;
+        orders.erase( it );
+    }
+
+    // nothing is ever left behind
+    template <typename OrderMap>
+    void compact( OrderMap& )
+    {}
+
+    // start the level afresh with this one order, the buffer keeps its capacity and its allocator
+    void reset( const Order& order )
+    {
+        price = order.price;
+        quantity = order.size;
+        numOrders = 1;
+        orders.clear();
+        orders.push_back( order );
+    }
+
     L3PriceLevel() = default;
+    L3PriceLevel( const L3PriceLevel& ) = default;
+    L3PriceLevel( L3PriceLevel&& ) = default;
+    L3PriceLevel& operator=( const L3PriceLevel& ) = default;
+    L3PriceLevel& operator=( L3PriceLevel&& ) = default;
+
+    explicit L3PriceLevel( const allocator_type& alloc )
+    : price{}, quantity( 0 ), numOrders( 0 )
+    , orders( alloc )
+    {}
+
+    L3PriceLevel( const L3PriceLevel& rhs, const allocator_type& alloc )
+    : price( rhs.price ), quantity( rhs.quantity ), numOrders( rhs.numOrders )
+    , orders( rhs.orders, alloc )
+    {}
+
+    L3PriceLevel( L3PriceLevel&& rhs, const allocator_type& alloc )
+    : price( rhs.price ), quantity( rhs.quantity ), numOrders( rhs.numOrders )
+    , orders( std::move( rhs.orders ), alloc )
+    {}
     
     L3PriceLevel( const std::vector<Order>& orders_ )
     {
@@ -375,15 +533,24 @@ struct L3PriceLevel
 /**
  *  @brief  specialisation of the template class L3PriceLevel for boost::circular_buffer
  */
-template <>
-struct L3PriceLevel<boost::circular_buffer>
+template <typename Alloc>
+struct L3PriceLevel<boost::circular_buffer, Alloc>
 {
-    double price;
+    using allocator_type = Alloc;
+
+    Price price;
     int quantity;
     int numOrders;
     // std::list<Order> orders;
     // dBuffer<Order, boost::circular_buffer> orders;
-    dBuffer<Order, boost::circular_buffer> orders;
+    dBuffer<RestingOrder, boost::circular_buffer, Alloc> orders;
+    int numDead{ 0 };       // the canceled orders still held, see cancel
+
+    using OrderIt = typename dBuffer<RestingOrder, boost::circular_buffer, Alloc>::iterator;
+
+    // a level holding more dead orders than live ones compacts itself
+    static constexpr int MaxDeadNum = 1;
+    static constexpr int MaxDeadDen = 2;
 
     friend std::ostream& operator<<(std::ostream& os, const L3PriceLevel& l)
     {
@@ -392,8 +559,11 @@ struct L3PriceLevel<boost::circular_buffer>
            << ", #odr=" << l.numOrders
            << ", odr={";
 
-        for (auto& o : l.orders) 
-            os << o << ", ";
+        for (auto& o : l.orders) {
+            if ( !o.dead ) {
+                os << o << ", ";
+            }
+        }
         os << "}";
         return os;
     }
@@ -410,28 +580,21 @@ struct L3PriceLevel<boost::circular_buffer>
         return L2PriceLevel{ price, quantity };
     }
 
-    auto addNewOrder( const Order& order, std::unordered_map<int, typename boost::circular_buffer<Order>::iterator>& orderMap)
+    template <typename OrderMap>
+    auto addNewOrder( const Order& order, OrderMap& )
     {
         assert( price == order.price );
         quantity += order.size;
         numOrders += 1;
-        auto itmaps = orders.push_back( order );
-        if (!itmaps.empty()) {
-            // spdlog::warn( "[L3PriceLevel::addNewOrder] Got Iterator invalidation! itmaps.size() = {}", itmaps.size() );
-            for(auto&[ ind, it ]: orderMap) {
-                orderMap[ ind ];
-                if ( itmaps.find( it ) != itmaps.end() ) {
-                    orderMap[ ind ] = itmaps[ it ];
-                }
-            }
-        }
+        orders.push_back( order );
         return std::prev( orders.end() );
     }
 
     // order must not take all the liquidity
     // return how much liquidity is taken
     // size_t matchOrder( Order& order, std::unordered_map<int, std::list<Order>::iterator>& orderMap)
-    size_t matchOrder( Order& order, std::unordered_map<int, typename boost::circular_buffer<Order>::iterator>& orderMap)
+    template <typename OrderMap>
+    size_t matchOrder( Order& order, OrderMap& orderMap)
     {
         size_t res{};
         while (true) {
@@ -440,11 +603,13 @@ struct L3PriceLevel<boost::circular_buffer>
                 const auto popped_id = orders.front().orderId;
                 order.size -= front_order.size;
                 res += front_order.size;
-                orders.pop_front();
-                orderMap.erase( popped_id );
-
                 numOrders -= 1;
                 quantity -= front_order.size;
+
+                // front_order goes with it
+                orders.pop_front();
+                dropDeadFront();
+                orderMap.erase( popped_id );
             } else {
                 orders.front().size -= order.size;
                 res += order.size;
@@ -453,6 +618,7 @@ struct L3PriceLevel<boost::circular_buffer>
                     numOrders -= 1;
                     orderMap.erase( orders.front().orderId );
                     orders.pop_front();
+                    dropDeadFront();
                 }
                 break;
             }
@@ -460,7 +626,111 @@ struct L3PriceLevel<boost::circular_buffer>
         return res;
     }
 
+    // the dead orders reaching an end are let go, keeping both ends live
+    void dropDeadFront()
+    {
+        while ( orders.size() > 0 && orders.front().dead ) {
+            orders.pop_front();
+            numDead -= 1;
+        }
+    }
+
+    void dropDeadBack()
+    {
+        while ( orders.size() > 0 && orders.back().dead ) {
+            orders.pop_back();
+            numDead -= 1;
+        }
+    }
+
+    /**
+     *  @brief  cancel the order it points at, O(1): the front and the back are popped, an order in between is
+     *              marked dead and left in place, erasing it would shift the orders behind and stale their
+     *              iterators in orderMap. quantity and numOrders drop at once
+     *  @NOTE   the front and the back are always live, matchOrder finds the next order to fill at the front;
+     *              once more than MaxDeadNum / MaxDeadDen of the orders held are dead, the level compacts itself
+     */
+    template <typename OrderMap>
+    void cancel( const OrderIt it, OrderMap& orderMap )
+    {
+        quantity -= it->size;
+        numOrders -= 1;
+        if ( it == orders.begin() ) {
+            orders.pop_front();
+            dropDeadFront();
+        } else if ( std::next( it ) == orders.end() ) {
+            orders.pop_back();
+            dropDeadBack();
+        } else {
+            it->dead = true;
+            numDead += 1;
+            if ( numDead * MaxDeadDen > static_cast<int>( orders.size() ) * MaxDeadNum ) {
+                compact( orderMap );
+            }
+        }
+    }
+
+    /**
+     *  @brief  squeeze the dead orders out, the live ones moving forward keep their order and orderMap follows them
+     *  @NOTE   O(orders held); cancel calls it past the threshold, L3Book::compact on every level while idle
+     */
+    template <typename OrderMap>
+    void compact( OrderMap& orderMap )
+    {
+        if ( numDead == 0 ) {
+            return;
+        }
+        auto out = orders.begin();
+        for ( auto it = orders.begin(); it != orders.end(); ++it ) {
+            if ( it->dead ) {
+                continue;
+            }
+            if ( out != it ) {
+                *out = *it;
+                const auto found = orderMap.find( out->orderId );
+                if ( found != orderMap.end() && found->second == it ) {
+                    found->second = out;
+                }
+            }
+            ++out;
+        }
+        while ( out != orders.end() ) {
+            orders.pop_back();
+        }
+        numDead = 0;
+    }
+
+    // start the level afresh with this one order, the buffer keeps its capacity and its allocator
+    void reset( const Order& order )
+    {
+        price = order.price;
+        quantity = order.size;
+        numOrders = 1;
+        numDead = 0;
+        orders.clear();
+        orders.push_back( order );
+    }
+
     L3PriceLevel() = default;
+    L3PriceLevel( const L3PriceLevel& ) = default;
+    L3PriceLevel( L3PriceLevel&& ) = default;
+    L3PriceLevel& operator=( const L3PriceLevel& ) = default;
+    L3PriceLevel& operator=( L3PriceLevel&& ) = default;
+
+    explicit L3PriceLevel( const allocator_type& alloc )
+    : price{}, quantity( 0 ), numOrders( 0 )
+    , orders( alloc )
+    {}
+
+    L3PriceLevel( const L3PriceLevel& rhs, const allocator_type& alloc )
+    : price( rhs.price ), quantity( rhs.quantity ), numOrders( rhs.numOrders )
+    , orders( rhs.orders, alloc ), numDead( rhs.numDead )
+    {}
+
+    L3PriceLevel( L3PriceLevel&& rhs, const allocator_type& alloc )
+    : price( rhs.price ), quantity( rhs.quantity ), numOrders( rhs.numOrders )
+    , orders( std::move( rhs.orders ), alloc ), numDead( rhs.numDead )
+    {}
 
     L3PriceLevel( const int orders_init_size )
     : price(0), quantity(0), numOrders(0)
@@ -513,11 +783,12 @@ struct L3PriceLevel<boost::circular_buffer>
     }
 }; // struct L3PriceLevel
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename Alloc = std::allocator<RestingOrder>>
 struct L3PxLvlPair
 {
-    std::optional<L3PriceLevel<BuffType>> bid;
-    std::optional<L3PriceLevel<BuffType>> ask;
+    std::optional<L3PriceLevel<BuffType, Alloc>> bid;
+    std::optional<L3PriceLevel<BuffType, Alloc>> ask;
 
     friend std::ostream& operator<<(std::ostream& os, const L3PxLvlPair& p)
     {
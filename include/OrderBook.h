@@ -2,6 +2,7 @@
 #define ORDERBOOK_H
 
 #include <Order.h>
+#include <MsgParser.h>
 #include <memory>
 
 
@@ -11,7 +12,7 @@ namespace sob {
 
 struct BidComparator
 {
-    bool operator()( const double& lhs, const double& rhs ) const
+    constexpr bool operator()( const Price lhs, const Price rhs ) const
     {
         if ( lhs > rhs ) {
             return true;
@@ -22,7 +23,7 @@ struct BidComparator
 //
 struct AskComparator
 {
-    bool operator()( const double& lhs, const double& rhs ) const
+    constexpr bool operator()( const Price lhs, const Price rhs ) const
     {
         if ( lhs< rhs) {
             return true;
@@ -34,7 +35,7 @@ struct AskComparator
 
 
 template<typename LevelType, typename Comparator>
-using OneSideBook = std::map<double, LevelType, Comparator>;
+using OneSideBook = std::map<Price, LevelType, Comparator>;
 
 /**
  *  @brief  An Orderbook that keeps the aggregated information on all levels
@@ -52,7 +53,7 @@ private:
     size_t askSideSize = 0;
 
 public:
-    bool operator==( const L2Book& rhs )
+    bool operator==( const L2Book& rhs ) const
     {
         return bidBook == rhs.bidBook 
             && askBook == rhs.askBook
@@ -291,37 +292,111 @@ public:
         if ( msg[0] != 'S' ) {
             throw std::runtime_error( "First char for a snapshot message must be S" );
         }
-        std::stringstream ss(msg);
 
-        std::string tmp;
-        int bid_depth, ask_depth;
-        ss >> tmp >> bid_depth >> ask_depth;
+        const auto err = parse( msg, *this );
+        if ( err != ParseError::Ok ) {
+            throw std::runtime_error( fmt::format( "[L2Book::L2Book] malformed snapshot message: {}, the error: {}",
+                                                   msg, sob::toString( err ) ) );
+        }
+    }
 
+    void clear()
+    {
+        bidBook.clear();
+        askBook.clear();
+        bidSideSize = 0;
+        askSideSize = 0;
+    }
 
-        for ( int i=0; i < bid_depth; i++ ) {
-            double px;
-            int sz;
-            ss >> px >> sz;
-            bidBook[px] = L2PriceLevel{px, sz};
+    /**
+     *  @brief  decode a snapshot message into out, never throws
+     *  @NOTE   the map nodes already held by out are re-keyed and reused,
+     *              so decoding snapshots of a stable depth into the same L2Book does not allocate
+     */
+    static ParseError parse( std::string_view msg, L2Book& out )
+    {
+        FieldCursor cur{ msg };
+        return parseFields( cur, out );
+    }
+
+    // same as parse(), over any field cursor, e.g. the pre-tokenised TokenCursor
+    template <typename Cursor>
+    static ParseError parseFields( Cursor& cur, L2Book& out )
+    {
+        const auto type = cur.next();
+        if ( type.empty() ) {
+            return ParseError::Empty;
+        }
+        if ( type != "S" ) {
+            return ParseError::UnknownType;
         }
 
-        for ( int i=0; i < ask_depth; i++ ) {
-            double px;
+        int bid_depth{}, ask_depth{};
+        auto err = cur.read( bid_depth, ask_depth );
+        if ( err != ParseError::Ok ) {
+            return err;
+        }
+        if ( bid_depth < 0 || ask_depth < 0 ) {
+            return ParseError::BadField;
+        }
+
+        OneSideBook<L2PriceLevel, BidComparator> spare_bids{ BidComparator{} };
+        OneSideBook<L2PriceLevel, AskComparator> spare_asks{ AskComparator{} };
+        spare_bids.swap( out.bidBook );
+        spare_asks.swap( out.askBook );
+        out.clear();
+
+        err = parseSide( cur, bid_depth, spare_bids, out.bidBook );
+        if ( err != ParseError::Ok ) {
+            return err;
+        }
+        err = parseSide( cur, ask_depth, spare_asks, out.askBook );
+        if ( err != ParseError::Ok ) {
+            return err;
+        }
+        // the declared depths are authoritative, same as an order, anything after them is malformed
+        return cur.atEnd() ? ParseError::Ok : ParseError::TrailingData;
+    }
+
+private:
+    template <typename Cursor, typename Comparator>
+    static ParseError parseSide( Cursor& cur, const int depth,
+                                 OneSideBook<L2PriceLevel, Comparator>& spare,
+                                 OneSideBook<L2PriceLevel, Comparator>& side )
+    {
+        for ( int i=0; i < depth; i++ ) {
+            Price px;
             int sz;
-            ss >> px >> sz;
-            askBook[px] = L2PriceLevel{px, sz};
+            const auto err = cur.read( px, sz );
+            if ( err != ParseError::Ok ) {
+                return err;
+            }
+
+            if ( spare.empty() ) {
+                side[px] = L2PriceLevel{px, sz};
+                continue;
+            }
+            auto node = spare.extract( spare.begin() );
+            node.key() = px;
+            node.mapped() = L2PriceLevel{px, sz};
+            auto res = side.insert( std::move( node ) );
+            if ( !res.inserted ) {
+                res.position->second = L2PriceLevel{px, sz};
+            }
         }
+        return ParseError::Ok;
     }
 
+public:
     std::string to_simple_string() const
     {
         std::stringstream ss;
         ss << "S " << bidBook.size() << " " << askBook.size() << " ";
         for ( const auto& [px, level] : bidBook ) {
-            ss << px << " " << level.quantity << " ";
+            ss << fmt::format( "{}", px ) << " " << level.quantity << " ";
         }
         for ( const auto& [px, level] : askBook ) {
-            ss << px << " " << level.quantity << " ";
+            ss << fmt::format( "{}", px ) << " " << level.quantity << " ";
         }
         return ss.str().substr(0, ss.str().size() - 1); // because we do not need the last ' '
     }
@@ -0,0 +1,431 @@
+#ifndef ORDER_QUEUE_H
+#define ORDER_QUEUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  The queue of orders resting on one level: an intrusive doubly-linked list whose nodes come from
+ *              slabs owned by the queue, a BuffType for L3Book next to std::list and boost::circular_buffer
+ *          Adding at either end, erasing anywhere and popping the front are O(1), nothing is ever shifted
+ *  @NOTE   Nodes never move, moving the queue hands its slabs over, so an iterator is a stable handle on
+ *              its order until that order is erased: L3Book::orderMap keeps them without ever remapping,
+ *              where erasing from the middle of dBuffer<RestingOrder, boost::circular_buffer> shifts the orders behind
+ *  @NOTE   Erased nodes go to a free list and are reused by the next insertion, the slabs are only given back
+ *              when the queue goes. They double from InitSlabNodes up to MaxSlabNodes nodes, AllocT is rebound
+ *              to allocate them
+ */
+template <typename T, typename AllocT = std::allocator<T>>
+class OrderQueue
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using allocator_type = AllocT;
+
+    static constexpr size_t InitSlabNodes = 4;
+    static constexpr size_t MaxSlabNodes = 256;
+
+private:
+    struct Node
+    {
+        Node* prev;
+        Node* next;
+        alignas( T ) unsigned char storage[sizeof( T )];
+
+        T* value()
+        {
+            return std::launder( reinterpret_cast<T*>( storage ) );
+        }
+    }; // struct Node
+
+    using NodeAlloc = typename std::allocator_traits<AllocT>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    struct Slab
+    {
+        Node* nodes;
+        size_t count;
+    }; // struct Slab
+
+    NodeAlloc mAlloc;
+    std::vector<Slab> mSlabs;
+    Node* mHead{ nullptr };     // the sentinel, the list is circular through it; nullptr until the first node
+    Node* mFree{ nullptr };     // erased nodes, chained through next
+    size_t mSize{ 0 };
+
+    void grow()
+    {
+        const size_t count = mSlabs.empty() ? InitSlabNodes : std::min( 2 * mSlabs.back().count, MaxSlabNodes );
+        Node* nodes = NodeTraits::allocate( mAlloc, count );
+        mSlabs.push_back( Slab{ nodes, count } );
+        for ( size_t i = 0; i < count; i++ ) {
+            nodes[i].next = mFree;
+            mFree = nodes + i;
+        }
+    }
+
+    Node* takeNode()
+    {
+        if ( !mFree ) {
+            grow();
+        }
+        Node* node = mFree;
+        mFree = node->next;
+        return node;
+    }
+
+    void giveNode( Node* node )
+    {
+        node->next = mFree;
+        mFree = node;
+    }
+
+    Node* head()
+    {
+        if ( !mHead ) {
+            mHead = takeNode();
+            mHead->prev = mHead->next = mHead;
+        }
+        return mHead;
+    }
+
+    template <typename... Args>
+    Node* link( Node* before, Args&&... args )
+    {
+        Node* node = takeNode();
+        try {
+            ::new ( static_cast<void*>( node->storage ) ) T( std::forward<Args>( args )... );
+        } catch ( ... ) {
+            giveNode( node );
+            throw;
+        }
+        node->next = before;
+        node->prev = before->prev;
+        before->prev->next = node;
+        before->prev = node;
+        mSize++;
+        return node;
+    }
+
+    void unlink( Node* node )
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->value()->~T();
+        giveNode( node );
+        mSize--;
+    }
+
+    // takes the nodes of rhs, whose allocator compares equal
+    void steal( OrderQueue& rhs )
+    {
+        mSlabs = std::move( rhs.mSlabs );
+        rhs.mSlabs.clear();
+        mHead = std::exchange( rhs.mHead, nullptr );
+        mFree = std::exchange( rhs.mFree, nullptr );
+        mSize = std::exchange( rhs.mSize, 0 );
+    }
+
+    void release()
+    {
+        clear();
+        for ( const auto& slab: mSlabs ) {
+            NodeTraits::deallocate( mAlloc, slab.nodes, slab.count );
+        }
+        mSlabs.clear();
+        mHead = mFree = nullptr;
+    }
+
+    template <bool IsConst>
+    class Iter
+    {
+    private:
+        Node* mNode{ nullptr };
+
+        friend class OrderQueue;
+        explicit Iter( Node* node ): mNode( node ) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iter() = default;
+
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter( const Iter<false>& rhs ): mNode( rhs.mNode ) {}
+
+        reference operator*() const
+        {
+            return *mNode->value();
+        }
+
+        pointer operator->() const
+        {
+            return mNode->value();
+        }
+
+        Iter& operator++()
+        {
+            mNode = mNode->next;
+            return *this;
+        }
+
+        Iter operator++( int )
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        Iter& operator--()
+        {
+            mNode = mNode->prev;
+            return *this;
+        }
+
+        Iter operator--( int )
+        {
+            auto tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        friend bool operator==( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mNode == rhs.mNode;
+        }
+
+        friend bool operator!=( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mNode != rhs.mNode;
+        }
+
+        friend class Iter<!IsConst>;
+    }; // class Iter
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    OrderQueue() = default;
+
+    explicit OrderQueue( const AllocT& alloc )
+    : mAlloc( alloc )
+    {}
+
+    OrderQueue( const OrderQueue& rhs )
+    : mAlloc( NodeTraits::select_on_container_copy_construction( rhs.mAlloc ) )
+    {
+        for ( const auto& val: rhs ) {
+            push_back( val );
+        }
+    }
+
+    OrderQueue( OrderQueue&& rhs ) noexcept
+    : mAlloc( rhs.mAlloc )
+    {
+        steal( rhs );
+    }
+
+    // the allocator-extended versions, the nodes come from alloc
+    OrderQueue( const OrderQueue& rhs, const AllocT& alloc )
+    : mAlloc( alloc )
+    {
+        for ( const auto& val: rhs ) {
+            push_back( val );
+        }
+    }
+
+    OrderQueue( OrderQueue&& rhs, const AllocT& alloc )
+    : mAlloc( alloc )
+    {
+        if ( mAlloc == rhs.mAlloc ) {
+            steal( rhs );
+        } else {
+            for ( auto& val: rhs ) {
+                emplace_back( std::move( val ) );
+            }
+            rhs.clear();
+        }
+    }
+
+    // reuses the nodes already held
+    OrderQueue& operator=( const OrderQueue& rhs )
+    {
+        if ( this != &rhs ) {
+            clear();
+            for ( const auto& val: rhs ) {
+                push_back( val );
+            }
+        }
+        return *this;
+    }
+
+    // the nodes of rhs are taken over when the allocator follows them or both allocators compare equal
+    OrderQueue& operator=( OrderQueue&& rhs )
+    {
+        if ( this == &rhs ) {
+            return *this;
+        }
+        if constexpr ( NodeTraits::propagate_on_container_move_assignment::value ) {
+            release();
+            mAlloc = std::move( rhs.mAlloc );
+            steal( rhs );
+        } else if ( mAlloc == rhs.mAlloc ) {
+            release();
+            steal( rhs );
+        } else {
+            clear();
+            for ( auto& val: rhs ) {
+                emplace_back( std::move( val ) );
+            }
+            rhs.clear();
+        }
+        return *this;
+    }
+
+    ~OrderQueue()
+    {
+        release();
+    }
+
+    AllocT get_allocator() const
+    {
+        return AllocT( mAlloc );
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    // the nodes held, in use or free, the sentinel included
+    size_t capacity() const
+    {
+        size_t res = 0;
+        for ( const auto& slab: mSlabs ) {
+            res += slab.count;
+        }
+        return res;
+    }
+
+    iterator begin()
+    {
+        return iterator( mHead ? mHead->next : nullptr );
+    }
+
+    iterator end()
+    {
+        return iterator( mHead );
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator( mHead ? mHead->next : nullptr );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( mHead );
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    T& front()
+    {
+        return *mHead->next->value();
+    }
+
+    const T& front() const
+    {
+        return *mHead->next->value();
+    }
+
+    T& back()
+    {
+        return *mHead->prev->value();
+    }
+
+    const T& back() const
+    {
+        return *mHead->prev->value();
+    }
+
+    void push_back( const T& val )
+    {
+        link( head(), val );
+    }
+
+    void push_front( const T& val )
+    {
+        link( head()->next, val );
+    }
+
+    template <typename... Args>
+    iterator emplace_back( Args&&... args )
+    {
+        return iterator( link( head(), std::forward<Args>( args )... ) );
+    }
+
+    void pop_front()
+    {
+        unlink( mHead->next );
+    }
+
+    void pop_back()
+    {
+        unlink( mHead->prev );
+    }
+
+    iterator erase( const_iterator it )
+    {
+        Node* next = it.mNode->next;
+        unlink( it.mNode );
+        return iterator( next );
+    }
+
+    // keeps the nodes for reuse
+    void clear()
+    {
+        if ( !mHead ) {
+            return;
+        }
+        while ( mHead->next != mHead ) {
+            unlink( mHead->next );
+        }
+    }
+}; // class OrderQueue
+
+} // namespace sob
+
+
+#endif
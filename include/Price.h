@@ -0,0 +1,153 @@
+#ifndef PRICE_H
+#define PRICE_H
+
+#include <MsgParser.h>
+#include <spdlog/fmt/fmt.h>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+
+namespace sob {
+
+/**
+ *  @brief  The tick size of the instrument being replayed, expressed as ticks per price unit,
+ *              i.e. one tick is 1 / ticksPerUnit; 10000 by default, the pxScale of the binary formats
+ *  @NOTE   A ( Singleton ) like IdGen, set it before any message is decoded:
+ *              prices already held are not converted when it changes
+ */
+class TickSize
+{
+private:
+    TickSize(){}
+    inline static uint32_t ticksPerUnit = 10000;
+
+public:
+    static uint32_t get()
+    {
+        return ticksPerUnit;
+    }
+
+    static void set( const uint32_t ticks_per_unit )
+    {
+        if ( ticks_per_unit == 0 ) {
+            throw std::runtime_error( "[TickSize::set] ticks_per_unit must be positive" );
+        }
+        ticksPerUnit = ticks_per_unit;
+    }
+}; // class TickSize
+
+
+/**
+ *  @brief  A price as an integer number of ticks, see TickSize
+ *          Books key their levels on it, so lookups compare integers instead of doubles parsed from text
+ *  @NOTE   Converts implicitly from double, rounding to the nearest tick, so that the I/O boundaries
+ *              ( parsers, tests, fmt ) keep working in decimal prices
+ */
+class Price
+{
+private:
+    int64_t mTicks{ 0 };
+
+public:
+    constexpr Price() = default;
+
+    Price( const double px )
+    : mTicks{ std::llround( px * TickSize::get() ) }
+    {}
+
+    static constexpr Price fromTicks( const int64_t ticks )
+    {
+        Price res;
+        res.mTicks = ticks;
+        return res;
+    }
+
+    // from an integer price in units of 1 / scale, exact when scale is the tick size ( binary formats )
+    static Price fromScaled( const int64_t val, const uint32_t scale )
+    {
+        if ( scale == TickSize::get() ) {
+            return fromTicks( val );
+        }
+        return Price{ static_cast<double>( val ) / scale };
+    }
+
+    constexpr int64_t ticks() const
+    {
+        return mTicks;
+    }
+
+    // the inverse of fromScaled
+    int64_t toScaled( const uint32_t scale ) const
+    {
+        if ( scale == TickSize::get() ) {
+            return mTicks;
+        }
+        return std::llround( toDouble() * scale );
+    }
+
+    // divided rather than multiplied by the tick size, so a price read from text converts back to the same double
+    double toDouble() const
+    {
+        return static_cast<double>( mTicks ) / TickSize::get();
+    }
+
+    friend constexpr bool operator==( const Price lhs, const Price rhs ) { return lhs.mTicks == rhs.mTicks; }
+    friend constexpr bool operator!=( const Price lhs, const Price rhs ) { return lhs.mTicks != rhs.mTicks; }
+    friend constexpr bool operator<( const Price lhs, const Price rhs ) { return lhs.mTicks < rhs.mTicks; }
+    friend constexpr bool operator>( const Price lhs, const Price rhs ) { return lhs.mTicks > rhs.mTicks; }
+    friend constexpr bool operator<=( const Price lhs, const Price rhs ) { return lhs.mTicks <= rhs.mTicks; }
+    friend constexpr bool operator>=( const Price lhs, const Price rhs ) { return lhs.mTicks >= rhs.mTicks; }
+
+    friend std::ostream& operator<<( std::ostream& os, const Price px )
+    {
+        return os << px.toDouble();
+    }
+}; // class Price
+
+// a price field is read as a decimal and rounded to the nearest tick
+inline ParseError decodeField( std::string_view field, Price& out )
+{
+    double px{};
+    const auto err = decodeField( field, px );
+    if ( err != ParseError::Ok ) {
+        return err;
+    }
+    out = Price{ px };
+    return ParseError::Ok;
+}
+
+
+} // namespace sob
+
+
+template <>
+struct std::hash<sob::Price>
+{
+    size_t operator()( const sob::Price px ) const noexcept
+    {
+        return std::hash<int64_t>{}( px.ticks() );
+    }
+};
+
+// formats as the decimal price, the same text the double it came from would give
+template <>
+struct fmt::formatter<sob::Price>
+{
+    constexpr auto parse( format_parse_context& ctx ) -> decltype( ctx.begin() )
+    {
+        return ctx.begin();
+    }
+
+    template <typename FormatContext>
+    auto format( const sob::Price px, FormatContext& ctx ) const -> decltype( ctx.out() )
+    {
+        return fmt::format_to( ctx.out(), "{}", px.toDouble() );
+    }
+};
+
+
+#endif
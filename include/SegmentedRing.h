@@ -0,0 +1,466 @@
+#ifndef SEGMENTED_RING_H
+#define SEGMENTED_RING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  A double-ended queue in fixed-size segments of SegSize elements, the engine behind
+ *              dBuffer<T, boost::circular_buffer>
+ *          Each element gets a sequence number when it goes in, one past the back or one before the front;
+ *              it lives in segment seq / SegSize, at seq % SegSize, and an iterator is the sequence number
+ *  @NOTE   Growing adds a segment and never moves an element, so pushing or popping at either end leaves the
+ *              iterators on the other elements valid: L3Book::orderMap keeps them without ever remapping.
+ *              Erasing in the middle shifts the elements behind forward, which invalidates their iterators
+ *  @NOTE   The segments are kept in a table that is itself a ring, in sequence order from mFirst on: a segment
+ *              emptied at the front becomes the last spare one and a push_front past the front takes the last spare
+ *              one back, each by moving one pointer, so popping is O(1) however deep the ring. The table doubles when
+ *              every slot of it holds a segment; the segments are only given back when the ring goes
+ *  @NOTE   AllocT is rebound to allocate them. Iterators point into the ring itself, moving the ring invalidates
+ *              them, as it does those of a boost::circular_buffer
+ */
+template <typename T, typename AllocT = std::allocator<T>, size_t SegBits = 6>
+class SegmentedRing
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using allocator_type = AllocT;
+
+    static constexpr int64_t SegSize = int64_t{ 1 } << SegBits;
+
+private:
+    using ValAlloc = typename std::allocator_traits<AllocT>::template rebind_alloc<T>;
+    using ValTraits = std::allocator_traits<ValAlloc>;
+    using SegsAlloc = typename std::allocator_traits<AllocT>::template rebind_alloc<T*>;
+
+    ValAlloc mAlloc;
+    std::vector<T*, SegsAlloc> mSegs;   // the table, a power of two in size, nullptr where no segment is held
+    size_t mFirst{ 0 };                 // where in mSegs the segment numbered mBase is
+    size_t mNumSegs{ 0 };               // the segments held, from mFirst on, the spare ones last
+    int64_t mBase{ 0 };                 // the segment number of the one at mFirst, which holds the front
+    int64_t mHead{ 0 };                 // the sequence number of the front
+    int64_t mTail{ 0 };                 // one past the sequence number of the back
+
+    // the slot of the table k segments on from the one at mFirst
+    T*& seg( const size_t k )
+    {
+        return mSegs[( mFirst + k ) & ( mSegs.size() - 1 )];
+    }
+
+    T* seg( const size_t k ) const
+    {
+        return mSegs[( mFirst + k ) & ( mSegs.size() - 1 )];
+    }
+
+    // seq may be negative after push_front, the shift and the mask round it down
+    T* slot( const int64_t seq ) const
+    {
+        return seg( static_cast<size_t>( ( seq >> SegBits ) - mBase ) ) + ( seq & ( SegSize - 1 ) );
+    }
+
+    // the segments from the one holding the back onwards, those past it are spare
+    size_t usedSegs() const
+    {
+        return mHead == mTail ? 0 : static_cast<size_t>( ( ( mTail - 1 ) >> SegBits ) - mBase + 1 );
+    }
+
+    // twice the slots in the table, the segments laid out again from slot 0, for when every slot holds one
+    void growTable()
+    {
+        std::vector<T*, SegsAlloc> segs( std::max<size_t>( 2 * mSegs.size(), 1 ), nullptr, mSegs.get_allocator() );
+        for ( size_t k = 0; k < mNumSegs; k++ ) {
+            segs[k] = seg( k );
+        }
+        mSegs = std::move( segs );
+        mFirst = 0;
+    }
+
+    // one more segment, after those held
+    void addSeg()
+    {
+        if ( mNumSegs == mSegs.size() ) {
+            growTable();
+        }
+        T* added = newSeg();
+        seg( mNumSegs ) = added;
+        mNumSegs++;
+    }
+
+    T* newSeg()
+    {
+        return ValTraits::allocate( mAlloc, SegSize );
+    }
+
+    template <typename... Args>
+    void construct( const int64_t seq, Args&&... args )
+    {
+        ValTraits::construct( mAlloc, slot( seq ), std::forward<Args>( args )... );
+    }
+
+    void destroy( const int64_t seq )
+    {
+        ValTraits::destroy( mAlloc, slot( seq ) );
+    }
+
+    // the front segment was emptied, it becomes the last spare one
+    void retireFront()
+    {
+        // the slot past the last segment held, unless that is the slot of the front one itself
+        seg( mNumSegs ) = std::exchange( seg( 0 ), nullptr );
+        mFirst = ( mFirst + 1 ) & ( mSegs.size() - 1 );
+        mBase++;
+    }
+
+    // takes the segments of rhs, whose allocator compares equal
+    void steal( SegmentedRing& rhs )
+    {
+        mSegs = std::move( rhs.mSegs );
+        rhs.mSegs.clear();
+        mFirst = std::exchange( rhs.mFirst, 0 );
+        mNumSegs = std::exchange( rhs.mNumSegs, 0 );
+        mBase = std::exchange( rhs.mBase, 0 );
+        mHead = std::exchange( rhs.mHead, 0 );
+        mTail = std::exchange( rhs.mTail, 0 );
+    }
+
+    void release()
+    {
+        clear();
+        for ( size_t k = 0; k < mNumSegs; k++ ) {
+            ValTraits::deallocate( mAlloc, seg( k ), SegSize );
+        }
+        mSegs.clear();
+        mFirst = 0;
+        mNumSegs = 0;
+    }
+
+    void reserveSegs( const size_t capacity )
+    {
+        const size_t segs = ( capacity + SegSize - 1 ) / SegSize;
+        while ( mNumSegs < segs ) {
+            addSeg();
+        }
+    }
+
+    template <bool IsConst>
+    class Iter
+    {
+    private:
+        using RingPtr = std::conditional_t<IsConst, const SegmentedRing*, SegmentedRing*>;
+        RingPtr mRing{ nullptr };
+        int64_t mSeq{ 0 };
+
+        friend class SegmentedRing;
+        Iter( RingPtr ring, const int64_t seq ): mRing( ring ), mSeq( seq ) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iter() = default;
+
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter( const Iter<false>& rhs ): mRing( rhs.mRing ), mSeq( rhs.mSeq ) {}
+
+        reference operator*() const
+        {
+            return *mRing->slot( mSeq );
+        }
+
+        pointer operator->() const
+        {
+            return mRing->slot( mSeq );
+        }
+
+        Iter& operator++()
+        {
+            mSeq++;
+            return *this;
+        }
+
+        Iter operator++( int )
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        Iter& operator--()
+        {
+            mSeq--;
+            return *this;
+        }
+
+        Iter operator--( int )
+        {
+            auto tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        friend bool operator==( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mSeq == rhs.mSeq && lhs.mRing == rhs.mRing;
+        }
+
+        friend bool operator!=( const Iter& lhs, const Iter& rhs )
+        {
+            return !( lhs == rhs );
+        }
+
+        friend class Iter<!IsConst>;
+    }; // class Iter
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    SegmentedRing() = default;
+
+    explicit SegmentedRing( const AllocT& alloc )
+    : mAlloc( alloc ), mSegs( SegsAlloc( alloc ) )
+    {}
+
+    // with room for capacity elements before the first segment is added
+    explicit SegmentedRing( const size_t capacity, const AllocT& alloc = AllocT() )
+    : mAlloc( alloc ), mSegs( SegsAlloc( alloc ) )
+    {
+        reserveSegs( capacity );
+    }
+
+    SegmentedRing( const SegmentedRing& rhs )
+    : mAlloc( ValTraits::select_on_container_copy_construction( rhs.mAlloc ) ), mSegs( SegsAlloc( mAlloc ) )
+    {
+        assign( rhs );
+    }
+
+    SegmentedRing( SegmentedRing&& rhs ) noexcept
+    : mAlloc( rhs.mAlloc ), mSegs( SegsAlloc( rhs.mAlloc ) )
+    {
+        steal( rhs );
+    }
+
+    // the allocator-extended versions, the segments come from alloc
+    SegmentedRing( const SegmentedRing& rhs, const AllocT& alloc )
+    : mAlloc( alloc ), mSegs( SegsAlloc( alloc ) )
+    {
+        assign( rhs );
+    }
+
+    SegmentedRing( SegmentedRing&& rhs, const AllocT& alloc )
+    : mAlloc( alloc ), mSegs( SegsAlloc( alloc ) )
+    {
+        if ( mAlloc == rhs.mAlloc ) {
+            steal( rhs );
+        } else {
+            assign( rhs );
+            rhs.clear();
+        }
+    }
+
+    // reuses the segments already held
+    SegmentedRing& operator=( const SegmentedRing& rhs )
+    {
+        if ( this != &rhs ) {
+            assign( rhs );
+        }
+        return *this;
+    }
+
+    // the segments of rhs are taken over when the allocator follows them or both allocators compare equal
+    SegmentedRing& operator=( SegmentedRing&& rhs )
+    {
+        if ( this == &rhs ) {
+            return *this;
+        }
+        if constexpr ( ValTraits::propagate_on_container_move_assignment::value ) {
+            release();
+            mAlloc = std::move( rhs.mAlloc );
+            steal( rhs );
+        } else if ( mAlloc == rhs.mAlloc ) {
+            release();
+            steal( rhs );
+        } else {
+            assign( rhs );
+            rhs.clear();
+        }
+        return *this;
+    }
+
+    ~SegmentedRing()
+    {
+        release();
+    }
+
+    AllocT get_allocator() const
+    {
+        return AllocT( mAlloc );
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>( mTail - mHead );
+    }
+
+    bool empty() const
+    {
+        return mHead == mTail;
+    }
+
+    // the elements the segments held can take, in use or spare
+    size_t capacity() const
+    {
+        return mNumSegs * SegSize;
+    }
+
+    iterator begin()
+    {
+        return iterator( this, mHead );
+    }
+
+    iterator end()
+    {
+        return iterator( this, mTail );
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator( this, mHead );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( this, mTail );
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    T& front()
+    {
+        return *slot( mHead );
+    }
+
+    const T& front() const
+    {
+        return *slot( mHead );
+    }
+
+    T& back()
+    {
+        return *slot( mTail - 1 );
+    }
+
+    const T& back() const
+    {
+        return *slot( mTail - 1 );
+    }
+
+    void push_back( const T& val )
+    {
+        if ( static_cast<size_t>( ( mTail >> SegBits ) - mBase ) == mNumSegs ) {
+            addSeg();
+        }
+        construct( mTail, val );
+        mTail++;
+    }
+
+    void push_front( const T& val )
+    {
+        if ( ( ( mHead - 1 ) >> SegBits ) < mBase ) {
+            // the last spare segment if there is one, a new one otherwise
+            if ( usedSegs() == mNumSegs ) {
+                addSeg();
+            }
+            T* spare = std::exchange( seg( mNumSegs - 1 ), nullptr );
+            mFirst = ( mFirst - 1 ) & ( mSegs.size() - 1 );
+            seg( 0 ) = spare;
+            mBase--;
+        }
+        construct( mHead - 1, val );
+        mHead--;
+    }
+
+    void pop_front()
+    {
+        destroy( mHead );
+        mHead++;
+        if ( mHead == mTail ) {
+            // start over at the front of the first segment
+            mHead = mTail = mBase * SegSize;
+        } else if ( ( mHead >> SegBits ) > mBase ) {
+            retireFront();
+        }
+    }
+
+    void pop_back()
+    {
+        mTail--;
+        destroy( mTail );
+        if ( mHead == mTail ) {
+            mHead = mTail = mBase * SegSize;
+        }
+    }
+
+    /**
+     *  @brief  erase the element it points at, the front and the back are popped, anywhere else the elements
+     *              behind are shifted forward and their iterators then point one element further
+     */
+    void erase( const_iterator it )
+    {
+        if ( it.mSeq == mHead ) {
+            pop_front();
+            return;
+        }
+        for ( int64_t seq = it.mSeq; seq + 1 < mTail; seq++ ) {
+            *slot( seq ) = std::move( *slot( seq + 1 ) );
+        }
+        pop_back();
+    }
+
+    // keeps the segments for reuse
+    void clear()
+    {
+        for ( int64_t seq = mHead; seq < mTail; seq++ ) {
+            destroy( seq );
+        }
+        mHead = mTail = mBase * SegSize;
+    }
+
+    // the elements of rhs, in the segments already held
+    void assign( const SegmentedRing& rhs )
+    {
+        clear();
+        for ( const auto& val: rhs ) {
+            push_back( val );
+        }
+    }
+}; // class SegmentedRing
+
+} // namespace sob
+
+
+#endif
@@ -4,6 +4,11 @@
 
 #include <L3OrderBook.h>
 #include <L3OrderBookListener.h>
+#include <GuessOverlay.h>
+#include <Message.h>
+#include <SpscQueue.h>
+#include <thread>
+#include <exception>
 
 
 
@@ -11,7 +16,7 @@ namespace sob {
 
 
 template<typename LevelType, typename Comparator>
-using OneSideBook = std::map<double, LevelType, Comparator>;
+using OneSideBook = std::map<Price, LevelType, Comparator>;
 
 
 enum class SyncMode
@@ -22,9 +27,10 @@ enum class SyncMode
     SNAPSHOT_IN_LEAD
 }; // enum class SyncMode
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
 class Synchronizer
-    : public L3OrderBookListener<BuffType>
+    : public L3OrderBookListener<BuffType, SideType, Alloc>
 {
 private:
     int actualOrderCnt{};
@@ -39,8 +45,8 @@ private:
 public:
     Synchronizer() = default;
 
-    Synchronizer( std::shared_ptr<L3Book<BuffType>> book )
-    : L3OrderBookListener<BuffType>( book )
+    Synchronizer( std::shared_ptr<L3Book<BuffType, SideType, Alloc>> book )
+    : L3OrderBookListener<BuffType, SideType, Alloc>( book )
     {}
 
     SyncMode getSyncStatus() const
@@ -53,7 +59,7 @@ public:
         return lastMode;
     }
     
-    virtual void onBookUpdate( L3Book<BuffType>* book, const Order& order ) override
+    virtual void onBookUpdate( L3Book<BuffType, SideType, Alloc>* book, const Order& order ) override
     {
         spdlog::debug( "onBookUpdate" );
         actualOrderCnt++;
@@ -68,6 +74,13 @@ public:
             lastMode = mode;
             mode = SyncMode::ORDER_IN_LEAD;
             return;
+        } else if( actualTradeCnt < receivedTradeCnt ) {
+            // an order the trades have not been waiting for, or not the last of them: they still lead
+            lastMode = mode;
+            mode = SyncMode::TRADE_IN_LEAD;
+        } else if( actualSnapShotCnt < receivedSnapShotCnt ) {
+            lastMode = mode;
+            mode = SyncMode::SNAPSHOT_IN_LEAD;
         } else {
             // return mode = SyncMode::SYNCHRONOUS;
             lastMode = mode;
@@ -75,7 +88,7 @@ public:
         }
     }
     
-    virtual void onTradeMsg( L3Book<BuffType>* book, const Trade& trade ) override
+    virtual void onTradeMsg( L3Book<BuffType, SideType, Alloc>* book, const Trade& trade ) override
     {
         // spdlog::debug( "onTradeMsg" );
         receivedTradeCnt++;
@@ -92,7 +105,7 @@ public:
         }
     }
 
-    virtual void onSnapShotMsg( L3Book<BuffType>* book, L2Book& ) override
+    virtual void onSnapShotMsg( L3Book<BuffType, SideType, Alloc>* book, L2Book& ) override
     {
         spdlog::debug( "onSnapShotMsg" );
         receivedSnapShotCnt++;
@@ -114,57 +127,145 @@ public:
  *  @brief This is used to gather the latest information received and produce a most up-to-date order book
  *  @NOTE  The result contain some guesses/deductions,
  *  @NOTE  This is not a Template class;
+ *  @NOTE  There is a single L3Book, the ground truth the order stream builds; what the trades and the snapshots
+ *             leading it imply is kept in a GuessOverlay on top of it, one for each, and dropped once the orders catch up
+ *  @NOTE  An order that comes while a stream leads is taken off what was guessed from it, see GuessOverlay::reconcile
  *  @member doGuess: if false, only reflect the information carried by the orderstream, else do the guess ASAP, default to true
  */
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
 class SmartOrderBook
 {
+public:
+    using Book = L3Book<BuffType, SideType, Alloc>;
+    using GuessBook = GuessOverlay<Book>;
+
 private:
-    std::shared_ptr<L3Book<BuffType>> bookGroundTruth;
-    std::shared_ptr<L3Book<BuffType>> bookTrade;
-    std::shared_ptr<L3Book<BuffType>> bookSnapShot;
+    std::shared_ptr<Book> bookGroundTruth;
+    GuessBook tradeGuess;
+    GuessBook snapShotGuess;
 
-    Synchronizer<BuffType> synchronizer;
+    Synchronizer<BuffType, SideType, Alloc> synchronizer;
 
     bool doGuess{ true };
 
-    std::shared_ptr<L3Book<BuffType>> leaderBook;
+    bool snapShotLeads{ false };    // which guess getLeaderView reads, the other one may be behind
+
+    // decoding targets reused across messages, so that parsing does not allocate
+    Order scratchOrder;
+    Trade scratchTrade;
+    L2Book scratchSnapShot;
+
+    template <typename MsgType>
+    static bool parseOrReport( std::string_view str, MsgType& msg )
+    {
+        const auto err = MsgType::parse( str, msg );
+        if ( err != ParseError::Ok ) {
+            spdlog::error( "[SmartOrderBook::applyMessage] dropping malformed message: \"{}\", the error: {}",
+                           str, toString( err ) );
+            return false;
+        }
+        return true;
+    }
+
+    void syncBooks()
+    {
+        auto status = synchronizer.getSyncStatus();
+        auto last_status = synchronizer.getLastSyncStatus();
+
+        /**
+         *  the orders have caught up with the trades and the snapshots, what they implied is dropped
+         */
+        if (status == SyncMode::SYNCHRONOUS) {
+            if( last_status != SyncMode::SYNCHRONOUS ) {
+                spdlog::warn( "[SmartOrderBook::applyMessage] Back to SYNCHRONOUS Status" );
+            }
+            spdlog::debug( "[SmartOrderBook::applyMessage] SYNCHRONOUS" );
+            dropGuesses();
+        }
+
+        else if( status == SyncMode::ORDER_IN_LEAD ) {
+            spdlog::warn( "[SmartOrderBook::applyMessage] DETECTED ORDER_IN_LEAD" );
+            dropGuesses();
+        }
+
+        else if( status == SyncMode::TRADE_IN_LEAD ) {
+            spdlog::warn( "[SmartOrderBook::applyMessage] DETECTED TRADE_IN_LEAD" );
+            snapShotLeads = false;
+        }
+
+        else if( status == SyncMode::SNAPSHOT_IN_LEAD ) {
+            spdlog::warn( "[SmartOrderBook::applyMessage] DETECTED SNAPSHOT_IN_LEAD" );
+            snapShotLeads = true;
+        }
+    }
+
+    // in the number of changes made to the guesses, nothing to do while in sync
+    void dropGuesses()
+    {
+        tradeGuess.rollbackGuesses();
+        snapShotGuess.rollbackGuesses();
+        snapShotLeads = false;
+    }
 
 public:
-    // synchronizer should subscribe to all three books
+    // synchronizer listens to the ground truth, which also announces the trades and the snapshots
     SmartOrderBook()
-    : bookGroundTruth { std::make_shared<L3Book<BuffType>>() }
-    , bookTrade { std::make_shared<L3Book<BuffType>>() }
-    , bookSnapShot { std::make_shared<L3Book<BuffType>>() }
-    , leaderBook { std::make_shared<L3Book<BuffType>>() }
+    : bookGroundTruth { std::make_shared<Book>() }
+    , tradeGuess { *bookGroundTruth }
+    , snapShotGuess { *bookGroundTruth }
     {
         synchronizer.subscribe( bookGroundTruth );
-        synchronizer.subscribe( bookTrade );
-        synchronizer.subscribe( bookSnapShot );
     }
 
-    void acceptSubscription( L3OrderBookListener<BuffType>* book )
+    void acceptSubscription( L3OrderBookListener<BuffType, SideType, Alloc>* book )
     {
         book->subscribe( bookGroundTruth );
-        book->subscribe( bookTrade );
-        book->subscribe( bookSnapShot );
     }
 
+    // a listener that does not live as long as the book has to cancel before it goes
+    void cancelSubscription( L3OrderBookListener<BuffType, SideType, Alloc>* book )
+    {
+        book->unsubscribe( bookGroundTruth );
+    }
 
+    // size the order map of the book for that many resting orders
+    void reserveOrders( const size_t orders )
+    {
+        bookGroundTruth->reserveOrders( orders );
+    }
 
+    // squeeze the canceled orders out of the book, for when the feed is idle
+    void compact()
+    {
+        bookGroundTruth->compact();
+    }
+
+
+    // the orders the guesses were waiting for are taken off them, not to be counted twice
     auto applyOrder( Order& order )
     {
-        return bookGroundTruth->applyOrder( order );
+        if ( tradeGuess.empty() && snapShotGuess.empty() ) {
+            return bookGroundTruth->applyOrder( order );
+        }
+        tradeGuess.mark();
+        snapShotGuess.mark();
+        const auto ret = bookGroundTruth->applyOrder( order );
+        tradeGuess.reconcile();
+        snapShotGuess.reconcile();
+        return ret;
     }
 
-    auto applyTrade( Trade& trade )
+    void applyTrade( Trade& trade )
     {
-        return bookTrade->applyTrade( trade );
+        bookGroundTruth->announce( trade );
+        tradeGuess.applyTrade( trade );
     }
 
-    auto applySnapShot( L2Book& snapshot )
+    void applySnapShot( L2Book& snapshot )
     {
-        return bookSnapShot->applySnapShot( snapshot );
+        bookGroundTruth->announce( snapshot );
+        snapShotGuess.applySnapShot( snapshot );
     }
 
     
@@ -175,74 +276,198 @@ public:
         }
     }
 
-    void applyMessage( const std::string& str )
+    void applyMessage( std::string_view str )
     {
-        if( doGuess ) {
-            if ( str[0] == 'N' || str[0] == 'C' || str[0] == 'R' ) {
-                Order order{ str };
-                applyOrder( order );
-            } else if ( str[0] == 'T' ) {
-                Trade trade{ str };
-                applyTrade( trade );
-            } else if ( str[0] == 'S' ) {
-                L2Book snapshot{ str };
-                applySnapShot( snapshot );
+        if ( str.empty() ) {
+            return;
+        }
+
+        if ( str[0] == 'N' || str[0] == 'C' || str[0] == 'R' ) {
+            if ( parseOrReport( str, scratchOrder ) ) {
+                applyMessage( scratchOrder );
+            }
+        } else if ( str[0] == 'T' ) {
+            if ( parseOrReport( str, scratchTrade ) ) {
+                applyMessage( scratchTrade );
+            }
+        } else if ( str[0] == 'S' ) {
+            if ( parseOrReport( str, scratchSnapShot ) ) {
+                applyMessage( scratchSnapShot );
             }
+        }
+    }
 
-            auto status = synchronizer.getSyncStatus();
-            auto last_status = synchronizer.getLastSyncStatus();
+    /**
+     *  @brief  apply an already decoded message and update the leader book
+     *          this is what the text path ends up calling, binary decoders can feed the book directly
+     */
+    void applyMessage( Order& order )
+    {
+        applyOrder( order );
+        if( doGuess ) {
+            syncBooks();
+        }
+    }
 
-            {
-                /**
-                 *  update bookTrade and bookSnapShot with the ground truth
-                 */
-                if (status == SyncMode::SYNCHRONOUS) {
-                    if( last_status != SyncMode::SYNCHRONOUS ) {
-                        spdlog::warn( "[SmartOrderBook::applyMessage] Back to SYNCHRONOUS Status" );
-                    }
-                    spdlog::debug( "[SmartOrderBook::applyMessage] SYNCHRONOUS" );
-                    leaderBook = bookGroundTruth;
-                    // TODO: we should make it asynchronous, i.e. in another thread such that it will not block the main logic
-                    // if( last_status == SyncMode::ORDER_IN_LEAD ) {
-                        *bookTrade = *bookGroundTruth;
-                        *bookSnapShot = *bookGroundTruth;
-                    // }
-                }
+    void applyMessage( Trade& trade )
+    {
+        if( doGuess ) {
+            applyTrade( trade );
+            syncBooks();
+        }
+    }
 
-                else if( status == SyncMode::ORDER_IN_LEAD ) {
-                    spdlog::warn( "[SmartOrderBook::applyMessage] DETECTED ORDER_IN_LEAD" );
-                    leaderBook = bookGroundTruth;
-                    // we need deep copy here, don't simply assign the pointers
-                    *bookTrade = *bookGroundTruth;
-                    *bookSnapShot = *bookGroundTruth;
-                }
+    void applyMessage( L2Book& snapshot )
+    {
+        if( doGuess ) {
+            applySnapShot( snapshot );
+            syncBooks();
+        }
+    }
 
-                else if( status == SyncMode::TRADE_IN_LEAD ) {
-                    spdlog::warn( "[SmartOrderBook::applyMessage] DETECTED TRADE_IN_LEAD" );
-                    leaderBook = bookTrade;
-                }
+    /**
+     *  @brief  apply a message decoded upstream, text, binary or network alike, no string handling is involved
+     *  @NOTE   the books update the orders they are given in place ( e.g. the remaining size while matching ),
+     *              so this overload decodes straight into the message it is handed
+     */
+    void applyMessage( Message& msg )
+    {
+        std::visit( [this]( auto& m ) { applyMessage( m ); }, msg );
+    }
+
+    /**
+     *  @brief  same as above for messages the caller wants to keep intact
+     *  @NOTE   the message is copied into the scratch Order / Trade / L2Book first, these keep their buffers,
+     *              so copying does not allocate once they have seen a message of the same depth
+     */
+    void applyMessage( const Message& msg )
+    {
+        if ( const auto* order = std::get_if<Order>( &msg ) ) {
+            scratchOrder = *order;
+            applyMessage( scratchOrder );
+        } else if ( !doGuess ) {
+            return;     // trades and snapshots only feed the guess
+        } else if ( const auto* trade = std::get_if<Trade>( &msg ) ) {
+            scratchTrade = *trade;
+            applyMessage( scratchTrade );
+        } else {
+            scratchSnapShot = std::get<L2Book>( msg );
+            applyMessage( scratchSnapShot );
+        }
+    }
+
+    // a batch of already decoded messages, applied in order
+    void applyMessages( const Message* msgs, const size_t cnt )
+    {
+        for ( size_t i = 0; i < cnt; i++ ) {
+            applyMessage( msgs[i] );
+        }
+    }
+
+    void applyMessages( const std::vector<Message>& msgs )
+    {
+        applyMessages( msgs.data(), msgs.size() );
+    }
 
-                else if( status == SyncMode::SNAPSHOT_IN_LEAD ) {
-                    spdlog::warn( "[SmartOrderBook::applyMessage] DETECTED SNAPSHOT_IN_LEAD" );
-                    leaderBook = bookSnapShot;
+    static constexpr size_t DefaultPipelineCapacity = 4096;
+
+    /**
+     *  @brief  Pipelined replay: messages are decoded on a helper thread and applied on the calling thread
+     *          next_msg( Message& ) runs on the decoder thread, it decodes the next message straight into a slot of
+     *              a bounded SPSC ring and returns false once its source is exhausted
+     *          The calling thread keeps ownership of the books and applies the messages in their original order
+     *  @NOTE   throughput approaches the slower of decoding and applying instead of their sum
+     *  @NOTE   an exception thrown on either side stops both threads and is rethrown here
+     */
+    template <typename MsgSource>
+    void applyMessagesPipelined( MsgSource&& next_msg, const size_t capacity = DefaultPipelineCapacity )
+    {
+        SpscQueue<Message> ring{ capacity };
+        std::atomic<bool> stop{ false };
+        std::exception_ptr decoder_error;
+
+        std::thread decoder{ [&ring, &stop, &decoder_error, &next_msg]() {
+            try {
+                while ( !stop.load( std::memory_order_relaxed ) ) {
+                    Message* slot = ring.acquire();
+                    if ( slot == nullptr ) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if ( !next_msg( *slot ) ) {
+                        break;
+                    }
+                    ring.publish();
                 }
+            } catch ( ... ) {
+                decoder_error = std::current_exception();
             }
-            
-        } else {
-            if ( str[0] == 'N' || str[0] == 'C' || str[0] == 'C' ) {
-                Order order{ str };
-                applyOrder( order );
+            ring.close();
+        } };
+
+        try {
+            while ( true ) {
+                Message* msg = ring.front();
+                if ( msg == nullptr ) {
+                    if ( ring.drained() ) {
+                        break;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+                applyMessage( *msg );
+                ring.pop();
             }
+        } catch ( ... ) {
+            stop.store( true, std::memory_order_relaxed );
+            decoder.join();
+            throw;
         }
+
+        decoder.join();
+        if ( decoder_error ) {
+            std::rethrow_exception( decoder_error );
+        }
+    }
+
+    /**
+     *  @brief  the most up-to-date book: the ground truth, with what the leading stream implies on top
+     *  @NOTE   reads as the ground truth while in sync, or when not guessing: nothing is guessed then
+     *  @NOTE   valid as long as this SmartOrderBook, its content until the next message
+     */
+    const GuessBook& getLeaderView() const
+    {
+        return snapShotLeads ? snapShotGuess : tradeGuess;
     }
 
-    std::shared_ptr<L3Book<BuffType>> getLeaderBook() const
+    /**
+     *  @brief  the most up-to-date book as an L3Book: the ground truth itself while nothing is guessed,
+     *              otherwise a copy of it the guesses are written into, see GuessOverlay::applyTo
+     *  @NOTE   a copy is O(N), N the number of orders in the book, and is not updated by the next messages:
+     *              getLeaderView reads the same in place
+     */
+    std::shared_ptr<Book> getLeaderBook() const
     {
-        // noGuess: always return the most accurate book, i.e., bookGroundTruth
-        if ( !doGuess ) {
+        const auto& leader = getLeaderView();
+        if ( leader.empty() ) {
             return bookGroundTruth;
         }
-        return leaderBook;
+        auto book = std::make_shared<Book>( *bookGroundTruth );
+        leader.applyTo( *book );
+        return book;
+    }
+
+    // bring copies of the ground truth in line with it, see L3Book::syncTo
+    template <typename... Books>
+    void syncGroundTruthTo( Books&... targets )
+    {
+        bookGroundTruth->syncTo( targets... );
+    }
+
+    // what the order stream alone says, without any guess
+    std::shared_ptr<const Book> getGroundTruth() const
+    {
+        return bookGroundTruth;
     }
 }; // class SmartOrderBook
 
@@ -0,0 +1,118 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+
+namespace sob {
+
+constexpr size_t CacheLineSize = 64;
+
+/**
+ *  @brief  Bounded, lock-free, single-producer / single-consumer ring
+ *          Slots are constructed once and reused, the producer fills a slot in place and publishes it,
+ *              the consumer reads it in place and releases it, so nothing is copied or allocated per element
+ *  @NOTE   The producer and the consumer indices live on their own cache lines, each side also caches
+ *              the other side's index so that the shared line is only touched when the cached value runs out
+ *  @NOTE   Exactly one thread may call acquire/publish/close, exactly one other thread may call front/pop
+ */
+template <typename T>
+class SpscQueue
+{
+private:
+    std::vector<T> mSlots;
+    const size_t mMask;
+
+    alignas(CacheLineSize) std::atomic<size_t> mTail{ 0 };     // written by the producer
+    alignas(CacheLineSize) size_t mHeadCache{ 0 };             // producer's view of mHead
+    alignas(CacheLineSize) std::atomic<size_t> mHead{ 0 };     // written by the consumer
+    alignas(CacheLineSize) size_t mTailCache{ 0 };             // consumer's view of mTail
+    alignas(CacheLineSize) std::atomic<bool> mClosed{ false };
+
+    static size_t roundUpPow2( const size_t n )
+    {
+        size_t res = 1;
+        while ( res < n ) {
+            res <<= 1;
+        }
+        return res;
+    }
+
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue( const size_t capacity )
+    : mSlots( roundUpPow2( capacity ) )
+    , mMask{ mSlots.size() - 1 }
+    {
+        if ( capacity == 0 ) {
+            throw std::runtime_error( "[SpscQueue::SpscQueue] capacity must be positive" );
+        }
+    }
+
+    SpscQueue( const SpscQueue& ) = delete;
+    SpscQueue& operator=( const SpscQueue& ) = delete;
+
+    size_t capacity() const
+    {
+        return mSlots.size();
+    }
+
+    // producer: the next free slot, nullptr if the ring is full
+    T* acquire()
+    {
+        const size_t tail = mTail.load( std::memory_order_relaxed );
+        if ( tail - mHeadCache == mSlots.size() ) {
+            mHeadCache = mHead.load( std::memory_order_acquire );
+            if ( tail - mHeadCache == mSlots.size() ) {
+                return nullptr;
+            }
+        }
+        return &mSlots[ tail & mMask ];
+    }
+
+    // producer: hand the slot returned by acquire() over to the consumer
+    void publish()
+    {
+        mTail.store( mTail.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+
+    // producer: no more elements will be published
+    void close()
+    {
+        mClosed.store( true, std::memory_order_release );
+    }
+
+    // consumer: the oldest published slot, nullptr if there is none yet
+    T* front()
+    {
+        const size_t head = mHead.load( std::memory_order_relaxed );
+        if ( head == mTailCache ) {
+            mTailCache = mTail.load( std::memory_order_acquire );
+            if ( head == mTailCache ) {
+                return nullptr;
+            }
+        }
+        return &mSlots[ head & mMask ];
+    }
+
+    // consumer: give the slot returned by front() back to the producer
+    void pop()
+    {
+        mHead.store( mHead.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+
+    // consumer: true once the producer has closed the ring and every element has been popped
+    bool drained()
+    {
+        return mClosed.load( std::memory_order_acquire ) && front() == nullptr;
+    }
+}; // class SpscQueue
+
+
+} // namespace sob
+
+
+#endif
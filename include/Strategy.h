@@ -9,13 +9,14 @@
 namespace sob {
 
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType = MapSide,
+          typename Alloc = std::allocator<RestingOrder>>
 class LoggingStrategy
-    : public L3OrderBookListener<BuffType>
+    : public L3OrderBookListener<BuffType, SideType, Alloc>
 {
 
 public:
-    virtual void onBookUpdate( L3Book<BuffType>* book, const Order& order )
+    virtual void onBookUpdate( L3Book<BuffType, SideType, Alloc>* book, const Order& order )
     {
         if (order.isCancel()) {
             spdlog::info( "[LoggingStrategy] Order Cancelled: {}", order.toString() );
@@ -28,12 +29,12 @@ public:
         }
     }
 
-    virtual void onTradeMsg( L3Book<BuffType>* book, const Trade& trade )
+    virtual void onTradeMsg( L3Book<BuffType, SideType, Alloc>* book, const Trade& trade )
     {
         spdlog::info( "[LoggingStrategy] Trade Received: {}", trade.toString() );
     }
 
-    virtual void onSnapShotMsg( L3Book<BuffType>* book, L2Book& snapshot )
+    virtual void onSnapShotMsg( L3Book<BuffType, SideType, Alloc>* book, L2Book& snapshot )
     {
         spdlog::info( "[LoggingStrategy] Snapshot Received: {}", snapshot.toString() );
     }
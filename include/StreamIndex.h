@@ -0,0 +1,89 @@
+#ifndef STREAM_INDEX_H
+#define STREAM_INDEX_H
+
+#include <MappedFile.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  Byte offset of every stride-th message of a stream, text or binary
+ *          Entry k is where message k * stride starts, so a replay can start from any message
+ *              without parsing what comes before it, and a file can be cut into chunks on message boundaries
+ *  @NOTE   For text streams every line is a message, empty lines included
+ *  @NOTE   Kept next to the stream as "<stream>.idx", see sidecarPath(); an index built for a file of
+ *              a different size is considered stale and is rebuilt
+ */
+class StreamIndex
+{
+private:
+    uint32_t mStride{ DefaultStride };
+    uint64_t mStreamSize{ 0 };
+    uint64_t mMessages{ 0 };
+    std::vector<uint64_t> mOffsets;
+
+public:
+    static constexpr uint32_t DefaultStride = 4096;
+
+    static std::string sidecarPath( const std::string& stream_path )
+    {
+        return stream_path + ".idx";
+    }
+
+    // walk the whole stream once, throws std::runtime_error if stride is 0
+    static StreamIndex build( std::string_view data, const uint32_t stride = DefaultStride );
+
+    // nullopt if there is no readable index at path or it was built for a stream of another size
+    static std::optional<StreamIndex> load( const std::string& path, const uint64_t stream_size );
+
+    // throws std::runtime_error if the file cannot be written
+    void save( const std::string& path ) const;
+
+    // the sidecar of stream_path if it is up to date, otherwise build it and try to save it
+    static StreamIndex loadOrBuild( const std::string& stream_path, const MappedFile& file,
+                                    const uint32_t stride = DefaultStride );
+
+    uint32_t stride() const
+    {
+        return mStride;
+    }
+
+    uint64_t messageCount() const
+    {
+        return mMessages;
+    }
+
+    size_t entries() const
+    {
+        return mOffsets.size();
+    }
+
+    // where message entry * stride starts, the end of the stream for entry == entries()
+    uint64_t offset( const size_t entry ) const
+    {
+        return entry < mOffsets.size() ? mOffsets[entry] : mStreamSize;
+    }
+
+    // the last entry at or before message msg_no
+    size_t entryFor( const uint64_t msg_no ) const
+    {
+        return static_cast<size_t>( msg_no / mStride );
+    }
+
+    /**
+     *  @brief  where message msg_no of data starts, the end of data if there are not that many messages
+     *          jumps to entryFor( msg_no ) and walks the less than stride messages left from there
+     */
+    uint64_t offsetOf( std::string_view data, const uint64_t msg_no ) const;
+}; // class StreamIndex
+
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,633 @@
+#ifndef TICK_LADDER_H
+#define TICK_LADDER_H
+
+#include <Price.h>
+#include <spdlog/fmt/fmt.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sob {
+
+/**
+ *  @brief  One side of a book as a dense price ladder: the levels sit in an array indexed by their tick,
+ *              next to a bitmap of the ticks holding a level, so the best price is a find-first-set away
+ *          A drop-in for the std::map<Price, LevelType, Comparator> L3Book uses by default ( see LadderSide ):
+ *              same interface subset, same iteration order ( Comparator ), same iterator guarantees
+ *  @NOTE   The array is cut into pages of 64 ticks, one bitmap word each, reached through a page table
+ *              anchored at the lowest page in use; the window follows the price by sliding the table,
+ *              the pages, hence the levels, never move. Iterators and references to a level stay valid
+ *              until that level is erased, which the dBuffer iterators in L3Book::orderMap rely on
+ *  @NOTE   Empty pages at either end of the window are recycled, the window spans the levels held, up to
+ *              MaxWindowTicks. Past that it keeps to the best levels, the pages of the others are held in a map
+ *              aside, slower to reach but never refused: use it for books dense around the touch
+ */
+template <typename LevelType, typename Comparator>
+class TickLadder
+{
+public:
+    using key_type = Price;
+    using mapped_type = LevelType;
+    using value_type = std::pair<const Price, LevelType>;
+    using size_type = size_t;
+
+    static constexpr int PageBits = 6;
+    static constexpr int64_t PageTicks = int64_t{ 1 } << PageBits;
+    static constexpr size_t MaxPages = size_t{ 1 } << 16;
+    static constexpr int64_t MaxWindowTicks = MaxPages * PageTicks;
+
+private:
+    // iterating from the highest tick down, as for the bid side
+    static constexpr bool Descending = Comparator{}( Price::fromTicks( 1 ), Price::fromTicks( 0 ) );
+    static constexpr int64_t EndTick = std::numeric_limits<int64_t>::min();
+
+    struct Page
+    {
+        uint64_t bits{ 0 };
+        alignas( value_type ) unsigned char storage[PageTicks][sizeof( value_type )];
+
+        Page() = default;
+        Page( const Page& ) = delete;
+        Page& operator=( const Page& ) = delete;
+
+        ~Page()
+        {
+            clear();
+        }
+
+        value_type* slot( const int64_t idx )
+        {
+            return std::launder( reinterpret_cast<value_type*>( storage[idx] ) );
+        }
+
+        const value_type* slot( const int64_t idx ) const
+        {
+            return std::launder( reinterpret_cast<const value_type*>( storage[idx] ) );
+        }
+
+        void clear()
+        {
+            for ( ; bits != 0; bits &= bits - 1 ) {
+                slot( __builtin_ctzll( bits ) )->~value_type();
+            }
+        }
+    }; // struct Page
+
+    std::vector<std::unique_ptr<Page>> mPages;  // mPages[i] holds the ticks of page mBase + i, nullptr if never used
+    int64_t mBase{ 0 };                         // the anchor, the page number of mPages[0]
+    size_t mSize{ 0 };
+    std::vector<std::unique_ptr<Page>> mSpare;  // pages recycled from the ends of the window
+    std::map<int64_t, std::unique_ptr<Page>> mFar;  // the pages beyond the window holding a level, by page number
+
+    static int64_t pageOf( const int64_t tick )
+    {
+        return tick >> PageBits;                // floor, negative ticks included
+    }
+
+    static int64_t slotOf( const int64_t tick )
+    {
+        return tick & ( PageTicks - 1 );
+    }
+
+    const Page* findPage( const int64_t tick ) const
+    {
+        const int64_t idx = pageOf( tick ) - mBase;
+        if ( idx < 0 || idx >= static_cast<int64_t>( mPages.size() ) ) {
+            const auto far = mFar.find( pageOf( tick ) );
+            return far == mFar.end() ? nullptr : far->second.get();
+        }
+        return mPages[idx].get();
+    }
+
+    Page* findPage( const int64_t tick )
+    {
+        return const_cast<Page*>( std::as_const( *this ).findPage( tick ) );
+    }
+
+    std::unique_ptr<Page> newPage()
+    {
+        if ( mSpare.empty() ) {
+            return std::unique_ptr<Page>( new Page );   // default-initialised, the slots are constructed on demand
+        }
+        auto page = std::move( mSpare.back() );
+        mSpare.pop_back();
+        return page;
+    }
+
+    // the page holding tick, sliding or widening the window to it first
+    Page& acquirePage( const Price px )
+    {
+        const int64_t page = pageOf( px.ticks() );
+        if ( !mPages.empty() && !fits( page ) ) {
+            // the window keeps to the best levels
+            const bool better = Descending ? page > mBase : page < mBase;
+            if ( !better ) {
+                auto& far = mFar[page];
+                if ( !far ) {
+                    far = newPage();
+                }
+                return *far;
+            }
+            slideTo( page );
+        }
+
+        if ( mPages.empty() ) {
+            mBase = page;
+            mPages.emplace_back();
+            adopt( page, page + 1 );
+        } else if ( page < mBase ) {
+            const auto shift = static_cast<size_t>( mBase - page );
+            mPages.resize( mPages.size() + shift );
+            std::move_backward( mPages.begin(), mPages.end() - shift, mPages.end() );
+            const int64_t begin = mBase;
+            mBase = page;
+            adopt( page, begin );
+        } else if ( page >= mBase + static_cast<int64_t>( mPages.size() ) ) {
+            const int64_t end = mBase + static_cast<int64_t>( mPages.size() );
+            mPages.resize( static_cast<size_t>( page - mBase + 1 ) );
+            adopt( end, page + 1 );
+        }
+        auto& slot = mPages[page - mBase];
+        if ( !slot ) {
+            slot = newPage();
+        }
+        return *slot;
+    }
+
+    // true if the window can stretch to page and stay within MaxPages
+    bool fits( const int64_t page ) const
+    {
+        const int64_t lo = std::min( page, mBase );
+        const int64_t hi = std::max( page, mBase + static_cast<int64_t>( mPages.size() ) - 1 );
+        return hi - lo < static_cast<int64_t>( MaxPages );
+    }
+
+    // hand the worst pages of the window over to mFar until page fits in it, the levels do not move
+    void slideTo( const int64_t page )
+    {
+        const auto held = static_cast<int64_t>( mPages.size() );
+        const auto max_pages = static_cast<int64_t>( MaxPages );
+        const int64_t lo = Descending ? std::clamp( page - max_pages + 1 - mBase, int64_t{ 0 }, held ) : 0;
+        const int64_t hi = Descending ? held : std::clamp( page + max_pages - mBase, int64_t{ 0 }, held );
+        for ( int64_t i = 0; i < held; i++ ) {
+            if ( ( i >= lo && i < hi ) || !mPages[i] ) {
+                continue;
+            }
+            if ( mPages[i]->bits == 0 ) {
+                mSpare.push_back( std::move( mPages[i] ) );
+            } else {
+                mFar.emplace( mBase + i, std::move( mPages[i] ) );
+            }
+        }
+        mPages.erase( mPages.begin() + hi, mPages.end() );
+        mPages.erase( mPages.begin(), mPages.begin() + lo );
+        mBase += lo;
+        trim();
+    }
+
+    // the pages of mFar in [ lo, hi ), now inside the window, move into it
+    void adopt( const int64_t lo, const int64_t hi )
+    {
+        for ( auto it = mFar.lower_bound( lo ); it != mFar.end() && it->first < hi; it = mFar.erase( it ) ) {
+            mPages[it->first - mBase] = std::move( it->second );
+        }
+    }
+
+    // drop the empty pages at both ends, so the window keeps following the levels
+    void trim()
+    {
+        const auto is_empty = []( const std::unique_ptr<Page>& page ) { return !page || page->bits == 0; };
+        size_t back = mPages.size();
+        while ( back > 0 && is_empty( mPages[back - 1] ) ) {
+            back--;
+        }
+        size_t front = 0;
+        while ( front < back && is_empty( mPages[front] ) ) {
+            front++;
+        }
+        if ( front == 0 && back == mPages.size() ) {
+            return;
+        }
+        for ( size_t i = 0; i < mPages.size(); i++ ) {
+            if ( ( i < front || i >= back ) && mPages[i] ) {
+                mSpare.push_back( std::move( mPages[i] ) );
+            }
+        }
+        mPages.erase( mPages.begin() + back, mPages.end() );
+        mPages.erase( mPages.begin(), mPages.begin() + front );
+        mBase = mPages.empty() ? 0 : mBase + static_cast<int64_t>( front );
+    }
+
+    // the first page holding a level after page, below the window, in it, then above it; nullptr if none
+    const Page* pageAfter( int64_t& page ) const
+    {
+        const auto far = mFar.upper_bound( page );
+        if ( far != mFar.end() && ( mPages.empty() || far->first < mBase ) ) {
+            page = far->first;
+            return far->second.get();
+        }
+        const int64_t end = mBase + static_cast<int64_t>( mPages.size() );
+        for ( int64_t p = std::max( page + 1, mBase ); p < end; p++ ) {
+            const Page* held = mPages[p - mBase].get();
+            if ( held && held->bits != 0 ) {
+                page = p;
+                return held;
+            }
+        }
+        if ( far != mFar.end() ) {
+            page = far->first;
+            return far->second.get();
+        }
+        return nullptr;
+    }
+
+    // the first page holding a level before page, above the window, in it, then below it; nullptr if none
+    const Page* pageBefore( int64_t& page ) const
+    {
+        const auto far = mFar.lower_bound( page );
+        const auto prev = far == mFar.begin() ? mFar.end() : std::prev( far );
+        if ( prev != mFar.end() && ( mPages.empty() || prev->first > mBase ) ) {
+            page = prev->first;
+            return prev->second.get();
+        }
+        const int64_t end = mBase + static_cast<int64_t>( mPages.size() );
+        for ( int64_t p = std::min( page, end ) - 1; p >= mBase; p-- ) {
+            const Page* held = mPages[p - mBase].get();
+            if ( held && held->bits != 0 ) {
+                page = p;
+                return held;
+            }
+        }
+        if ( prev != mFar.end() ) {
+            page = prev->first;
+            return prev->second.get();
+        }
+        return nullptr;
+    }
+
+    // the closest tick holding a level strictly above tick, EndTick if none
+    int64_t above( const int64_t tick ) const
+    {
+        int64_t page = pageOf( tick );
+        const int64_t slot = slotOf( tick );
+        uint64_t bits = slot + 1 < PageTicks ? findPage( tick )->bits & ( ~uint64_t{ 0 } << ( slot + 1 ) ) : 0;
+        if ( bits == 0 ) {
+            const Page* held = pageAfter( page );
+            if ( !held ) {
+                return EndTick;
+            }
+            bits = held->bits;
+        }
+        return page * PageTicks + __builtin_ctzll( bits );
+    }
+
+    // the closest tick holding a level strictly below tick, EndTick if none
+    int64_t below( const int64_t tick ) const
+    {
+        int64_t page = pageOf( tick );
+        uint64_t bits = findPage( tick )->bits & ( ( uint64_t{ 1 } << slotOf( tick ) ) - 1 );
+        if ( bits == 0 ) {
+            const Page* held = pageBefore( page );
+            if ( !held ) {
+                return EndTick;
+            }
+            bits = held->bits;
+        }
+        return page * PageTicks + 63 - __builtin_clzll( bits );
+    }
+
+    // the ends of the window always hold a level, see trim(), and so do the pages of mFar
+    int64_t lowest() const
+    {
+        if ( !mFar.empty() && ( mPages.empty() || mFar.begin()->first < mBase ) ) {
+            return mFar.begin()->first * PageTicks + __builtin_ctzll( mFar.begin()->second->bits );
+        }
+        return mPages.empty() ? EndTick : mBase * PageTicks + __builtin_ctzll( mPages.front()->bits );
+    }
+
+    int64_t highest() const
+    {
+        if ( !mFar.empty() && ( mPages.empty() || mFar.rbegin()->first > mBase ) ) {
+            return mFar.rbegin()->first * PageTicks + 63 - __builtin_clzll( mFar.rbegin()->second->bits );
+        }
+        return mPages.empty() ? EndTick
+                              : ( mBase + static_cast<int64_t>( mPages.size() ) - 1 ) * PageTicks
+                                + 63 - __builtin_clzll( mPages.back()->bits );
+    }
+
+    int64_t first() const
+    {
+        return Descending ? highest() : lowest();
+    }
+
+    int64_t next( const int64_t tick ) const
+    {
+        return Descending ? below( tick ) : above( tick );
+    }
+
+    int64_t prev( const int64_t tick ) const
+    {
+        if ( tick == EndTick ) {
+            return Descending ? lowest() : highest();
+        }
+        return Descending ? above( tick ) : below( tick );
+    }
+
+    std::unique_ptr<Page> copyPage( const Page& src )
+    {
+        auto page = newPage();
+        for ( uint64_t bits = src.bits; bits != 0; bits &= bits - 1 ) {
+            const int slot = __builtin_ctzll( bits );
+            new ( page->storage[slot] ) value_type( *src.slot( slot ) );
+            page->bits |= uint64_t{ 1 } << slot;
+        }
+        return page;
+    }
+
+    void copyFrom( const TickLadder& rhs )
+    {
+        mBase = rhs.mBase;
+        mSize = rhs.mSize;
+        mPages.resize( rhs.mPages.size() );
+        for ( size_t i = 0; i < rhs.mPages.size(); i++ ) {
+            const Page* src = rhs.mPages[i].get();
+            if ( src && src->bits != 0 ) {
+                mPages[i] = copyPage( *src );
+            }
+        }
+        for ( const auto& [page, src]: rhs.mFar ) {
+            mFar.emplace( page, copyPage( *src ) );
+        }
+    }
+
+    template <bool IsConst>
+    class Iter
+    {
+    private:
+        using Ladder = std::conditional_t<IsConst, const TickLadder, TickLadder>;
+
+        Ladder* mLadder{ nullptr };
+        int64_t mTick{ EndTick };
+
+        friend class TickLadder;
+        template <bool> friend class Iter;
+
+        Iter( Ladder* ladder, const int64_t tick )
+        : mLadder{ ladder }
+        , mTick{ tick }
+        {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = TickLadder::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iter() = default;
+
+        // iterator -> const_iterator
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter( const Iter<false>& rhs )
+        : mLadder{ rhs.mLadder }
+        , mTick{ rhs.mTick }
+        {}
+
+        reference operator*() const
+        {
+            return *mLadder->findPage( mTick )->slot( slotOf( mTick ) );
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        Iter& operator++()
+        {
+            mTick = mLadder->next( mTick );
+            return *this;
+        }
+
+        Iter operator++( int )
+        {
+            auto res = *this;
+            ++*this;
+            return res;
+        }
+
+        Iter& operator--()
+        {
+            mTick = mLadder->prev( mTick );
+            return *this;
+        }
+
+        Iter operator--( int )
+        {
+            auto res = *this;
+            --*this;
+            return res;
+        }
+
+        friend bool operator==( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mTick == rhs.mTick;
+        }
+
+        friend bool operator!=( const Iter& lhs, const Iter& rhs )
+        {
+            return lhs.mTick != rhs.mTick;
+        }
+    }; // class Iter
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    TickLadder() = default;
+
+    TickLadder( const TickLadder& rhs )
+    {
+        copyFrom( rhs );
+    }
+
+    // the pages already allocated are reused, a book copied over and over ( SmartOrderBook::syncBooks ) does not allocate
+    TickLadder& operator=( const TickLadder& rhs )
+    {
+        if ( this != &rhs ) {
+            clear();
+            copyFrom( rhs );
+        }
+        return *this;
+    }
+
+    TickLadder( TickLadder&& rhs ) noexcept
+    : mPages{ std::move( rhs.mPages ) }
+    , mBase{ std::exchange( rhs.mBase, 0 ) }
+    , mSize{ std::exchange( rhs.mSize, 0 ) }
+    , mSpare{ std::move( rhs.mSpare ) }
+    , mFar{ std::move( rhs.mFar ) }
+    {
+        rhs.mPages.clear();
+        rhs.mFar.clear();
+    }
+
+    TickLadder& operator=( TickLadder&& rhs ) noexcept
+    {
+        if ( this != &rhs ) {
+            mPages = std::move( rhs.mPages );
+            mBase = std::exchange( rhs.mBase, 0 );
+            mSize = std::exchange( rhs.mSize, 0 );
+            mSpare = std::move( rhs.mSpare );
+            mFar = std::move( rhs.mFar );
+            rhs.mPages.clear();
+            rhs.mFar.clear();
+        }
+        return *this;
+    }
+
+    iterator begin() { return { this, first() }; }
+    iterator end() { return { this, EndTick }; }
+    const_iterator begin() const { return { this, first() }; }
+    const_iterator end() const { return { this, EndTick }; }
+    reverse_iterator rbegin() { return reverse_iterator{ end() }; }
+    reverse_iterator rend() { return reverse_iterator{ begin() }; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator{ end() }; }
+    const_reverse_iterator rend() const { return const_reverse_iterator{ begin() }; }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    // the ticks between the lowest and the highest page held, what the ladder spends memory on
+    int64_t windowTicks() const
+    {
+        return static_cast<int64_t>( mPages.size() ) * PageTicks;
+    }
+
+    iterator find( const Price px )
+    {
+        const Page* page = findPage( px.ticks() );
+        if ( page && ( page->bits >> slotOf( px.ticks() ) & 1 ) ) {
+            return { this, px.ticks() };
+        }
+        return end();
+    }
+
+    const_iterator find( const Price px ) const
+    {
+        const Page* page = findPage( px.ticks() );
+        if ( page && ( page->bits >> slotOf( px.ticks() ) & 1 ) ) {
+            return { this, px.ticks() };
+        }
+        return end();
+    }
+
+    size_t count( const Price px ) const
+    {
+        return find( px ) == end() ? 0 : 1;
+    }
+
+    LevelType& operator[]( const Price px )
+    {
+        Page& page = acquirePage( px );
+        const int64_t slot = slotOf( px.ticks() );
+        if ( !( page.bits >> slot & 1 ) ) {
+            new ( page.storage[slot] ) value_type( px, LevelType{} );
+            page.bits |= uint64_t{ 1 } << slot;
+            mSize++;
+        }
+        return page.slot( slot )->second;
+    }
+
+    LevelType& at( const Price px )
+    {
+        return const_cast<LevelType&>( std::as_const( *this ).at( px ) );
+    }
+
+    const LevelType& at( const Price px ) const
+    {
+        const auto it = find( px );
+        if ( it == end() ) {
+            throw std::out_of_range( fmt::format( "[TickLadder::at] no level at {}", px ) );
+        }
+        return it->second;
+    }
+
+    size_t erase( const Price px )
+    {
+        Page* page = findPage( px.ticks() );
+        const int64_t slot = slotOf( px.ticks() );
+        if ( !page || !( page->bits >> slot & 1 ) ) {
+            return 0;
+        }
+        page->slot( slot )->~value_type();
+        page->bits &= ~( uint64_t{ 1 } << slot );
+        mSize--;
+        if ( page->bits == 0 ) {
+            const auto far = mFar.find( pageOf( px.ticks() ) );
+            if ( far == mFar.end() ) {
+                trim();
+            } else {
+                mSpare.push_back( std::move( far->second ) );
+                mFar.erase( far );
+            }
+        }
+        return 1;
+    }
+
+    // the iterator following it, like std::map::erase
+    iterator erase( const_iterator it )
+    {
+        iterator res{ this, next( it.mTick ) };
+        erase( it->first );
+        return res;
+    }
+
+    iterator erase( iterator it )
+    {
+        return erase( const_iterator{ it } );
+    }
+
+    void clear()
+    {
+        for ( auto& page: mPages ) {
+            if ( page ) {
+                page->clear();
+                mSpare.push_back( std::move( page ) );
+            }
+        }
+        for ( auto& [page, far]: mFar ) {
+            far->clear();
+            mSpare.push_back( std::move( far ) );
+        }
+        mPages.clear();
+        mFar.clear();
+        mBase = 0;
+        mSize = 0;
+    }
+}; // class TickLadder
+
+
+} // namespace sob
+
+
+#endif
@@ -0,0 +1,327 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <MsgParser.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+namespace sob {
+
+/**
+ *  @brief  Instruction set used by tokenize() to classify the bytes of a block
+ *  @NOTE   Every level feeds the same separator / newline bitmasks to the same bit walk,
+ *              so all of them produce bit-identical offset tables
+ */
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2
+}; // enum class SimdLevel
+
+// the best level this translation unit was compiled for, AVX2 needs SOB_ENABLE_AVX2 ( -mavx2 )
+constexpr SimdLevel BestSimdLevel =
+#if defined(__AVX2__)
+    SimdLevel::Avx2;
+#elif defined(__SSE2__)
+    SimdLevel::Sse2;
+#else
+    SimdLevel::Scalar;
+#endif
+
+constexpr bool isSupported( const SimdLevel level )
+{
+    return static_cast<int>( level ) <= static_cast<int>( BestSimdLevel );
+}
+
+// [begin, end) byte offsets into the tokenised data
+struct FieldSpan
+{
+    uint32_t begin;
+    uint32_t end;
+
+    bool operator==( const FieldSpan& rhs ) const
+    {
+        return begin == rhs.begin && end == rhs.end;
+    }
+}; // struct FieldSpan
+
+
+/**
+ *  @brief  Walks the fields of one pre-tokenised line, a drop-in for FieldCursor in the message decoders
+ */
+class TokenCursor : public FieldReader<TokenCursor>
+{
+private:
+    const char* mBase;
+    const FieldSpan* mCur;
+    const FieldSpan* mEnd;
+
+public:
+    TokenCursor( const char* base, const FieldSpan* first, const FieldSpan* last )
+    : mBase{ base }
+    , mCur{ first }
+    , mEnd{ last }
+    {}
+
+    bool atEnd() const
+    {
+        return mCur == mEnd;
+    }
+
+    // the next raw field, empty if the line is exhausted
+    std::string_view next()
+    {
+        if ( mCur == mEnd ) {
+            return {};
+        }
+        const auto field = std::string_view( mBase + mCur->begin, mCur->end - mCur->begin );
+        ++mCur;
+        return field;
+    }
+}; // class TokenCursor
+
+
+/**
+ *  @brief  Offset tables for a batch of lines: the byte range of every line and of every field in it
+ *          Filled by tokenize(), the vectors keep their capacity so refilling one batch does not allocate
+ */
+class TokenBatch
+{
+private:
+    const char* mBase{ nullptr };
+    std::vector<FieldSpan> mLines;          // without the '\n' and a trailing '\r'
+    std::vector<FieldSpan> mFields;
+    std::vector<uint32_t> mLineFields;      // first field of line i is mFields[ mLineFields[i] ], size is lines() + 1
+
+    friend class Tokenizer;
+
+    void reset( const char* base )
+    {
+        mBase = base;
+        mLines.clear();
+        mFields.clear();
+        mLineFields.assign( 1, 0 );
+    }
+
+public:
+    TokenBatch()
+    : mLineFields( 1, 0 )
+    {}
+
+    size_t lines() const
+    {
+        return mLines.size();
+    }
+
+    std::string_view line( const size_t i ) const
+    {
+        return std::string_view( mBase + mLines[i].begin, mLines[i].end - mLines[i].begin );
+    }
+
+    size_t fieldCount( const size_t i ) const
+    {
+        return mLineFields[i + 1] - mLineFields[i];
+    }
+
+    TokenCursor cursor( const size_t i ) const
+    {
+        return TokenCursor{ mBase, mFields.data() + mLineFields[i], mFields.data() + mLineFields[i + 1] };
+    }
+
+    const std::vector<FieldSpan>& lineSpans() const
+    {
+        return mLines;
+    }
+
+    const std::vector<FieldSpan>& fieldSpans() const
+    {
+        return mFields;
+    }
+}; // class TokenBatch
+
+
+/**
+ *  @brief  Splits text into lines and whitespace separated fields, BlockSize bytes at a time
+ *          Each block is classified into a separator mask and a newline mask, with SIMD compares + movemask
+ *              where available, then the set bits of the masks are walked to emit the field and line offsets
+ *  @NOTE   The separators are the ones of FieldCursor: ' ', '\t', '\r' and '\n'
+ */
+class Tokenizer
+{
+public:
+    static constexpr size_t BlockSize = 32;
+
+    /**
+     *  @brief  tokenise up to max_lines lines of data into out
+     *  @return the number of bytes consumed, always the end of a line
+     *  @NOTE   the end of data ends the last line, so data should not stop in the middle of a line
+     *          offsets are 32 bits, data longer than 4GB is only tokenised up to the last line starting below 4GB
+     */
+    static size_t tokenize( std::string_view data, const size_t max_lines, TokenBatch& out,
+                            const SimdLevel level = BestSimdLevel )
+    {
+        switch ( level )
+        {
+#if defined(__AVX2__)
+            case SimdLevel::Avx2:   return run<SimdLevel::Avx2>( data, max_lines, out );
+#endif
+#if defined(__SSE2__)
+            case SimdLevel::Sse2:   return run<SimdLevel::Sse2>( data, max_lines, out );
+#endif
+            default:                return run<SimdLevel::Scalar>( data, max_lines, out );
+        }
+    }
+
+private:
+    static void classify( const char c, const uint32_t bit, uint32_t& sep, uint32_t& nl )
+    {
+        if ( isFieldSep( c ) ) {
+            sep |= bit;
+        }
+        if ( c == '\n' ) {
+            nl |= bit;
+        }
+    }
+
+    // the first n bytes of src, n <= BlockSize
+    static void scalarMasks( const char* src, const size_t n, uint32_t& sep, uint32_t& nl )
+    {
+        sep = 0;
+        nl = 0;
+        for ( size_t i = 0; i < n; i++ ) {
+            classify( src[i], uint32_t{ 1 } << i, sep, nl );
+        }
+    }
+
+    template <SimdLevel Level>
+    static void blockMasks( const char* src, uint32_t& sep, uint32_t& nl )
+    {
+#if defined(__AVX2__)
+        if constexpr ( Level == SimdLevel::Avx2 ) {
+            const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( src ) );
+            const __m256i is_nl = _mm256_cmpeq_epi8( block, _mm256_set1_epi8( '\n' ) );
+            const __m256i is_sep = _mm256_or_si256(
+                _mm256_or_si256( _mm256_cmpeq_epi8( block, _mm256_set1_epi8( ' ' ) ),
+                                 _mm256_cmpeq_epi8( block, _mm256_set1_epi8( '\t' ) ) ),
+                _mm256_or_si256( _mm256_cmpeq_epi8( block, _mm256_set1_epi8( '\r' ) ), is_nl ) );
+            sep = static_cast<uint32_t>( _mm256_movemask_epi8( is_sep ) );
+            nl = static_cast<uint32_t>( _mm256_movemask_epi8( is_nl ) );
+            return;
+        }
+#endif
+#if defined(__SSE2__)
+        if constexpr ( Level == SimdLevel::Sse2 ) {
+            const auto half = []( const char* p, uint32_t& s, uint32_t& n ) {
+                const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                const __m128i is_nl = _mm_cmpeq_epi8( block, _mm_set1_epi8( '\n' ) );
+                const __m128i is_sep = _mm_or_si128(
+                    _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( ' ' ) ),
+                                  _mm_cmpeq_epi8( block, _mm_set1_epi8( '\t' ) ) ),
+                    _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( '\r' ) ), is_nl ) );
+                s = static_cast<uint32_t>( _mm_movemask_epi8( is_sep ) );
+                n = static_cast<uint32_t>( _mm_movemask_epi8( is_nl ) );
+            };
+            uint32_t sep_lo, nl_lo, sep_hi, nl_hi;
+            half( src, sep_lo, nl_lo );
+            half( src + 16, sep_hi, nl_hi );
+            sep = sep_lo | ( sep_hi << 16 );
+            nl = nl_lo | ( nl_hi << 16 );
+            return;
+        }
+#endif
+        scalarMasks( src, BlockSize, sep, nl );
+    }
+
+    static void closeLine( const char* base, const uint32_t begin, uint32_t end, TokenBatch& out )
+    {
+        if ( end > begin && base[end - 1] == '\r' ) {
+            end--;
+        }
+        out.mLines.push_back( FieldSpan{ begin, end } );
+        out.mLineFields.push_back( static_cast<uint32_t>( out.mFields.size() ) );
+    }
+
+    template <SimdLevel Level>
+    static size_t run( std::string_view data, const size_t max_lines, TokenBatch& out )
+    {
+        out.reset( data.data() );
+        if ( max_lines == 0 ) {
+            return 0;
+        }
+        if ( data.size() > UINT32_MAX ) {
+            const auto last_nl = data.rfind( '\n', UINT32_MAX - 1 );
+            data = data.substr( 0, last_nl == std::string_view::npos ? 0 : last_nl + 1 );
+        }
+
+        const char* base = data.data();
+        const size_t size = data.size();
+        uint32_t in_field = 0;              // 1 if the byte before the block is part of a field
+        uint32_t field_begin = 0;
+        uint32_t line_begin = 0;
+
+        for ( size_t pos = 0; pos < size; pos += BlockSize ) {
+            const size_t n = std::min( BlockSize, size - pos );
+            uint32_t sep, nl;
+            if ( n == BlockSize ) {
+                blockMasks<Level>( base + pos, sep, nl );
+            } else {
+                scalarMasks( base + pos, n, sep, nl );
+            }
+
+            const uint32_t valid = ( n == BlockSize ) ? ~uint32_t{ 0 } : ( ( uint32_t{ 1 } << n ) - 1 );
+            const uint32_t word = ~sep & valid;
+            const uint32_t prev_word = ( word << 1 ) | in_field;
+            const uint32_t starts = word & ~prev_word;
+            const uint32_t ends = ~word & prev_word & valid;
+
+            uint32_t events = starts | ends | nl;
+            while ( events != 0 ) {
+                const uint32_t idx = static_cast<uint32_t>( __builtin_ctz( events ) );
+                const uint32_t bit = uint32_t{ 1 } << idx;
+                const uint32_t off = static_cast<uint32_t>( pos ) + idx;
+                if ( ends & bit ) {
+                    out.mFields.push_back( FieldSpan{ field_begin, off } );
+                }
+                if ( nl & bit ) {
+                    closeLine( base, line_begin, off, out );
+                    line_begin = off + 1;
+                    if ( out.mLines.size() == max_lines ) {
+                        return line_begin;
+                    }
+                }
+                if ( starts & bit ) {
+                    field_begin = off;
+                }
+                events &= events - 1;
+            }
+            in_field = ( word >> ( BlockSize - 1 ) ) & 1;
+        }
+
+        // the end of data ends the last field and the last line
+        if ( size != 0 && !isFieldSep( base[size - 1] ) ) {
+            out.mFields.push_back( FieldSpan{ field_begin, static_cast<uint32_t>( size ) } );
+        }
+        if ( line_begin < size ) {
+            closeLine( base, line_begin, static_cast<uint32_t>( size ), out );
+        }
+        return size;
+    }
+}; // class Tokenizer
+
+
+} // namespace sob
+
+
+#endif
@@ -6,6 +6,10 @@
 #include <numeric>
 #include <algorithm>
 #include <sstream>
+#include <string_view>
+#include <spdlog/fmt/fmt.h>
+#include <MsgParser.h>
+#include <Price.h>
 
 namespace sob {
 
@@ -16,7 +20,7 @@ namespace sob {
  */
 struct Trade
 {
-    std::vector<double> price;
+    std::vector<Price> price;
     std::vector<int> volume;
     bool isSell;    // true: the seller is the liquidity taker, false: the buyer is the liquidity taker
 
@@ -39,9 +43,15 @@ struct Trade
 
     double getAvgPrice() const
     {
-        return std::accumulate( price.begin(), price.end(), 0.0 ) / getTotalVol();
+        double px_sum{ 0.0 };
+        for ( const auto px: price ) {
+            px_sum += px.toDouble();
+        }
+        return px_sum / getTotalVol();
     }
 
+    Trade() = default;
+
     /**
      *  example msg:
      *      T 1(isSell) 0.9(first px) 10(first qty) 1.0 5 1.1 30
@@ -52,22 +62,57 @@ struct Trade
             throw std::runtime_error( "First char for a trade message must be T" );
         }
 
-        std::stringstream ss{ msg };
+        const auto err = parse( msg, *this );
+        if ( err != ParseError::Ok ) {
+            throw std::runtime_error( fmt::format( "[Trade::Trade] malformed trade message: {}, the error: {}",
+                                                   msg, sob::toString( err ) ) );
+        }
+    }
+
+    /**
+     *  @brief  decode a trade message in place, never throws
+     *  @NOTE   price and volume are cleared but keep their capacity, so reusing one Trade does not allocate
+     */
+    static ParseError parse( std::string_view msg, Trade& out )
+    {
+        FieldCursor cur{ msg };
+        return parseFields( cur, out );
+    }
+
+    // same as parse(), over any field cursor, e.g. the pre-tokenised TokenCursor
+    template <typename Cursor>
+    static ParseError parseFields( Cursor& cur, Trade& out )
+    {
+        const auto type = cur.next();
+        if ( type.empty() ) {
+            return ParseError::Empty;
+        }
+        if ( type != "T" ) {
+            return ParseError::UnknownType;
+        }
 
-        std::string _;
-        ss >> _;
-        
-        ss >> isSell;
+        out.price.clear();
+        out.volume.clear();
+        auto err = cur.read( out.isSell );
+        if ( err != ParseError::Ok ) {
+            return err;
+        }
 
-        while( !ss.eof() ) {
-            double px;
-            int vol;
-            ss >> px >> vol;
-            price.push_back( px );
-            volume.push_back( vol );
+        while( !cur.atEnd() ) {
+            Price px{};
+            int vol{};
+            err = cur.read( px, vol );
+            if ( err != ParseError::Ok ) {
+                return err;
+            }
+            out.price.push_back( px );
+            out.volume.push_back( vol );
         }
+        // a trade crosses at least one level
+        return out.price.empty() ? ParseError::MissingField : ParseError::Ok;
     }
 
+    // prices are written in their shortest exact form, so the message parses back to the same Trade
     std::string toString() const
     {
         std::stringstream ss;
@@ -76,10 +121,10 @@ struct Trade
             return ss.str();
         }
 
-        for( int i = 0; i < price.size() - 1; i++ ) {
-            ss << price[i] << " " << volume[i] << " ";
+        for( size_t i = 0; i + 1 < price.size(); i++ ) {
+            ss << fmt::format( "{}", price[i] ) << " " << volume[i] << " ";
         }
-        ss << price[price.size() - 1] << " " << volume[volume.size() - 1];
+        ss << fmt::format( "{}", price[price.size() - 1] ) << " " << volume[volume.size() - 1];
         return ss.str();
     }
 
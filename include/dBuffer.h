@@ -3,6 +3,8 @@
 
 
 #include <boost/circular_buffer.hpp>
+#include <OrderQueue.h>
+#include <SegmentedRing.h>
 #include <vector>
 #include <algorithm>
 #include <numeric>
@@ -17,22 +19,45 @@ namespace sob{
 /**
  *  @brief  Adaptor Pattern just like std::queue/std::stack
  *          Use different Engine type to construct the interface of a dBuffer: constant time for insertion/deletion on both ends and also automatically resizes itself when it overflows
- *          This will reallocated on itself, even if the engine is boost::circular_buffer
+ *          With boost::circular_buffer the elements are held in a SegmentedRing, which grows without moving them
  */
 template <typename T,
             template <typename EleT, typename AllocT = std::allocator<EleT>> 
-                class EngineT = boost::circular_buffer >
+                class EngineT = boost::circular_buffer,
+            typename Alloc = std::allocator<T> >
 class dBuffer
 {
 private:
-    mutable EngineT<T> mBuffer;
+    mutable EngineT<T, Alloc> mBuffer;
 
 public:
+    using allocator_type = Alloc;
+
     dBuffer() = default;
     template <typename... Args>
     dBuffer( Args&&... args ): mBuffer( std::forward<Args...>( args... ) )
     {}
 
+    explicit dBuffer( const Alloc& alloc ): mBuffer( alloc )
+    {}
+
+    dBuffer( const dBuffer& rhs ) = default;
+    dBuffer( dBuffer&& rhs ) = default;
+    dBuffer& operator=( const dBuffer& rhs ) = default;
+    dBuffer& operator=( dBuffer&& rhs ) = default;
+
+    // the copy allocates from alloc rather than from where rhs does
+    dBuffer( const dBuffer& rhs, const Alloc& alloc ): mBuffer( rhs.mBuffer, alloc )
+    {}
+
+    dBuffer( dBuffer&& rhs, const Alloc& alloc ): mBuffer( std::move( rhs.mBuffer ), alloc )
+    {}
+
+    Alloc get_allocator() const
+    {
+        return mBuffer.get_allocator();
+    }
+
     void push_back( const T& val )
     {
         mBuffer.push_back( val );
@@ -43,9 +68,9 @@ public:
         mBuffer.push_front( value );
     }
 
-    using iterator = typename EngineT<T>::iterator;
-    using const_iterator = typename EngineT<T>::const_iterator;
-    using value_type = typename EngineT<T>::value_type;
+    using iterator = typename EngineT<T, Alloc>::iterator;
+    using const_iterator = typename EngineT<T, Alloc>::const_iterator;
+    using value_type = typename EngineT<T, Alloc>::value_type;
 
     size_t size() const
     {
@@ -57,6 +82,11 @@ public:
         mBuffer.erase( it );
     }
 
+    void clear()
+    {
+        mBuffer.clear();
+    }
+
     void pop_front()
     {
         return mBuffer.pop_front();
@@ -111,149 +141,114 @@ public:
 
 /**
  *  @brief  This is a specialisation on EngineT = boost::circular_buffer
+ *          The elements are kept in a SegmentedRing rather than in a boost::circular_buffer: growing adds a segment
+ *              instead of reallocating, so the iterators handed out stay valid and nothing has to be remapped
  */
-template <typename T>
-class dBuffer< T, boost::circular_buffer>
+template <typename T, typename Alloc>
+class dBuffer< T, boost::circular_buffer, Alloc>
 {
 private:
-    mutable boost::circular_buffer<T> mBuffer;
-    // std::set<typename boost::circular_buffer<T>::iterator> InvalidIts;
+    mutable SegmentedRing<T, Alloc> mBuffer;
 
 public:
-    dBuffer()
-    : mBuffer( 4 )
-    {
-    }
+    using allocator_type = Alloc;
+
+    dBuffer() = default;
     template <typename... Args>
     dBuffer( Args&&... args ): mBuffer( std::forward<Args...>( args... ) )
     {}
 
-    std::map<typename boost::circular_buffer<T>::iterator, typename boost::circular_buffer<T>::iterator> push_back( const T& val )
-    // void push_back( const T& val )
+    explicit dBuffer( const Alloc& alloc ): mBuffer( alloc )
+    {}
+
+    dBuffer( const dBuffer& rhs ) = default;
+    dBuffer( dBuffer&& rhs ) = default;
+    dBuffer& operator=( const dBuffer& rhs ) = default;
+    dBuffer& operator=( dBuffer&& rhs ) = default;
+
+    // the copy allocates from alloc rather than from where rhs does
+    dBuffer( const dBuffer& rhs, const Alloc& alloc ): mBuffer( rhs.mBuffer, alloc )
+    {}
+
+    dBuffer( dBuffer&& rhs, const Alloc& alloc ): mBuffer( std::move( rhs.mBuffer ), alloc )
+    {}
+
+    Alloc get_allocator() const
+    {
+        return mBuffer.get_allocator();
+    }
+
+    void push_back( const T& val )
     {
-        std::map<typename boost::circular_buffer<T>::iterator, typename boost::circular_buffer<T>::iterator> itmaps;
-        if (mBuffer.full()) {
-            boost::circular_buffer<T> tmp( mBuffer.size() * 2 );
-            for( auto it = mBuffer.begin(); it != mBuffer.end(); ++it ) {
-                // if (InvalidIts.find( it ) == InvalidIts.end()) {
-                    tmp.push_back( *it );
-                    itmaps[it] = std::prev(tmp.end());
-                // }
-            }
-            // spdlog::warn( "[dBuffer::push_front] mBuffer full!, Got itmap size: {}", itmaps.size() );
-            mBuffer.swap( tmp );
-        }
         mBuffer.push_back( val );
-        return itmaps;
     }
 
-    std::map<typename boost::circular_buffer<T>::iterator, typename boost::circular_buffer<T>::iterator> push_front( const T& val )
-    // void push_front( const T& val )
+    void push_front( const T& val )
     {
-        std::map<typename boost::circular_buffer<T>::iterator, typename boost::circular_buffer<T>::iterator> itmaps;
-        if (mBuffer.full()) {
-            boost::circular_buffer<T> tmp( mBuffer.size() * 2 );
-            // std::copy( mBuffer.begin(), mBuffer.end(), std::back_inserter( tmp ) );
-            for( auto it = mBuffer.begin(); it != mBuffer.end(); ++it ) {
-                // if (InvalidIts.find( it ) == InvalidIts.end()) {
-                    tmp.push_back( *it );
-                    itmaps[it] = std::prev(tmp.end());
-                // }
-            }
-            mBuffer.swap( tmp );
-        }
-        // spdlog::warn( "[dBuffer::push_front] mBuffer full!, Got itmap size: {}", itmaps.size() );
         mBuffer.push_front( val );
-        return itmaps;
     }
 
-    using iterator = typename boost::circular_buffer<T>::iterator;
-    using const_iterator = typename boost::circular_buffer<T>::const_iterator;
-    using value_type = typename boost::circular_buffer<T>::value_type;
+    using iterator = typename SegmentedRing<T, Alloc>::iterator;
+    using const_iterator = typename SegmentedRing<T, Alloc>::const_iterator;
+    using value_type = typename SegmentedRing<T, Alloc>::value_type;
 
     size_t size() const
     {
-        // size deducting the size in the InvalidIts
-        // return mBuffer.size() - InvalidIts.size();
         return mBuffer.size();
     }
 
+    // the front and the back are popped, elsewhere the elements behind are shifted
     void erase( iterator it )
     {
-        // return mBuffer.erase( it );
-        // InvalidIts.insert( it );
         mBuffer.erase( it );
     }
 
+    // keeps the segments
+    void clear()
+    {
+        mBuffer.clear();
+    }
+
     void pop_front()
     {
-        // clean up the invalid iterattors in the beginnings
-        // while(InvalidIts.find( mBuffer.begin()) != InvalidIts.end()) {
-        //     mBuffer.pop_front();
-        // }
         return mBuffer.pop_front();
     }
 
+    void pop_back()
+    {
+        return mBuffer.pop_back();
+    }
+
     T& front() const
     {
-        // while(InvalidIts.find( mBuffer.begin()) != InvalidIts.end()) {
-        //     mBuffer.pop_front();
-        // }
         return mBuffer.front();
     }
 
+    T& back() const
+    {
+        return mBuffer.back();
+    }
+
     iterator begin() const
     {
-        // while(InvalidIts.find( mBuffer.begin()) != InvalidIts.end()) {
-        //     mBuffer.pop_front();
-        // }
         return mBuffer.begin();
     }
 
     iterator end() const
     {
-        // while(InvalidIts.find( std::prev(mBuffer.end())) != InvalidIts.end()) {
-        //     mBuffer.pop_back();
-        // }
         return mBuffer.end();
     }
 
     const_iterator cbegin() const
     {
-        // while(InvalidIts.find( mBuffer.begin()) != InvalidIts.end()) {
-        //     mBuffer.pop_front();
-        // }
         return mBuffer.cbegin();
     }
 
     const_iterator cend() const
     {
-        // while(InvalidIts.find( std::prev(mBuffer.end())) != InvalidIts.end()) {
-        //     mBuffer.pop_back();
-        // }
         return mBuffer.cend();
     }
 
-    // friend iterator begin( dBuffer& buf )
-    // {
-    //     return buf.begin();
-    // }
-    //
-    // friend const_iterator begin( const dBuffer& buf )
-    // {
-    //     return buf.cbegin();
-    // }
-    //
-    // friend iterator end( dBuffer& buf )
-    // {
-    //     return buf.end();
-    // }
-    //
-    // friend const_iterator cend( const dBuffer& buf )
-    // {
-    //     return buf.cend();
-    // }
-
 }; // class dBuffer
 
 } // namespace sob
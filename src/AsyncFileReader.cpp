@@ -0,0 +1,387 @@
+#include <AsyncFileReader.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#define SOB_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+
+namespace sob {
+
+/**
+ *  @brief  The bare minimum of io_uring, straight on top of the syscalls so that liburing is not needed:
+ *              one submission per read, completions reaped one at a time
+ */
+class IoUring
+{
+#if SOB_HAVE_IO_URING
+private:
+    int mFd{ -1 };
+    bool mFixed{ false };           // buffers registered, reads use IORING_OP_READ_FIXED
+
+    void* mSqRing{ MAP_FAILED };
+    size_t mSqRingSize{ 0 };
+    void* mCqRing{ MAP_FAILED };
+    size_t mCqRingSize{ 0 };
+    io_uring_sqe* mSqes{ nullptr };
+    size_t mSqesSize{ 0 };
+
+    unsigned* mSqTail{ nullptr };
+    unsigned* mSqMask{ nullptr };
+    unsigned* mSqArray{ nullptr };
+    unsigned* mCqHead{ nullptr };
+    unsigned* mCqTail{ nullptr };
+    unsigned* mCqMask{ nullptr };
+    io_uring_cqe* mCqes{ nullptr };
+
+    static int enter( const int fd, const unsigned to_submit, const unsigned min_complete, const unsigned flags )
+    {
+        return static_cast<int>( ::syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0 ) );
+    }
+
+    bool setup( const unsigned entries, const iovec* bufs, const unsigned buf_cnt )
+    {
+        io_uring_params params{};
+        mFd = static_cast<int>( ::syscall( __NR_io_uring_setup, entries, &params ) );
+        if ( mFd < 0 ) {
+            spdlog::debug( "[IoUring::setup] io_uring_setup failed: {}", std::strerror( errno ) );
+            return false;
+        }
+
+        mSqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+        mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+        const bool single_mmap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+        if ( single_mmap ) {
+            mSqRingSize = mCqRingSize = std::max( mSqRingSize, mCqRingSize );
+        }
+
+        mSqRing = ::mmap( nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQ_RING );
+        if ( mSqRing == MAP_FAILED ) {
+            return false;
+        }
+        mCqRing = single_mmap ? mSqRing
+                              : ::mmap( nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                        mFd, IORING_OFF_CQ_RING );
+        if ( mCqRing == MAP_FAILED ) {
+            return false;
+        }
+        mSqesSize = params.sq_entries * sizeof( io_uring_sqe );
+        void* sqes = ::mmap( nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQES );
+        if ( sqes == MAP_FAILED ) {
+            return false;
+        }
+        mSqes = static_cast<io_uring_sqe*>( sqes );
+
+        char* sq = static_cast<char*>( mSqRing );
+        mSqTail = reinterpret_cast<unsigned*>( sq + params.sq_off.tail );
+        mSqMask = reinterpret_cast<unsigned*>( sq + params.sq_off.ring_mask );
+        mSqArray = reinterpret_cast<unsigned*>( sq + params.sq_off.array );
+        char* cq = static_cast<char*>( mCqRing );
+        mCqHead = reinterpret_cast<unsigned*>( cq + params.cq_off.head );
+        mCqTail = reinterpret_cast<unsigned*>( cq + params.cq_off.tail );
+        mCqMask = reinterpret_cast<unsigned*>( cq + params.cq_off.ring_mask );
+        mCqes = reinterpret_cast<io_uring_cqe*>( cq + params.cq_off.cqes );
+
+        // registration counts against RLIMIT_MEMLOCK on older kernels, plain reads are the next best thing
+        mFixed = ::syscall( __NR_io_uring_register, mFd, IORING_REGISTER_BUFFERS, bufs, buf_cnt ) == 0;
+        if ( !mFixed ) {
+            spdlog::debug( "[IoUring::setup] cannot register the buffers: {}", std::strerror( errno ) );
+        }
+        return true;
+    }
+
+public:
+    static std::unique_ptr<IoUring> create( const unsigned entries, const iovec* bufs, const unsigned buf_cnt )
+    {
+        auto res = std::make_unique<IoUring>();
+        if ( !res->setup( entries, bufs, buf_cnt ) ) {
+            return nullptr;
+        }
+        return res;
+    }
+
+    ~IoUring()
+    {
+        if ( mSqes != nullptr ) {
+            ::munmap( mSqes, mSqesSize );
+        }
+        if ( mCqRing != MAP_FAILED && mCqRing != mSqRing ) {
+            ::munmap( mCqRing, mCqRingSize );
+        }
+        if ( mSqRing != MAP_FAILED ) {
+            ::munmap( mSqRing, mSqRingSize );
+        }
+        if ( mFd >= 0 ) {
+            ::close( mFd );
+        }
+    }
+
+    void read( const int fd, char* buf, const size_t len, const uint64_t offset,
+               const uint16_t buf_idx, const uint64_t user_data )
+    {
+        const unsigned tail = *mSqTail;         // only this thread writes the tail
+        const unsigned idx = tail & *mSqMask;
+        io_uring_sqe& sqe = mSqes[idx];
+        std::memset( &sqe, 0, sizeof( sqe ) );
+        sqe.opcode = mFixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>( buf );
+        sqe.len = static_cast<uint32_t>( len );
+        sqe.off = offset;
+        sqe.buf_index = mFixed ? buf_idx : 0;
+        sqe.user_data = user_data;
+        mSqArray[idx] = idx;
+        __atomic_store_n( mSqTail, tail + 1, __ATOMIC_RELEASE );
+
+        while ( enter( mFd, 1, 0, 0 ) < 0 ) {
+            if ( errno != EINTR && errno != EAGAIN ) {
+                throw std::runtime_error( std::string( "[IoUring::read] io_uring_enter failed: " ) + std::strerror( errno ) );
+            }
+        }
+    }
+
+    // block until a read completes, user_data and result of it
+    std::pair<uint64_t, int> wait()
+    {
+        while ( true ) {
+            const unsigned head = *mCqHead;
+            if ( head != __atomic_load_n( mCqTail, __ATOMIC_ACQUIRE ) ) {
+                const io_uring_cqe& cqe = mCqes[head & *mCqMask];
+                const std::pair<uint64_t, int> res{ cqe.user_data, cqe.res };
+                __atomic_store_n( mCqHead, head + 1, __ATOMIC_RELEASE );
+                return res;
+            }
+            if ( enter( mFd, 0, 1, IORING_ENTER_GETEVENTS ) < 0 && errno != EINTR ) {
+                throw std::runtime_error( std::string( "[IoUring::wait] io_uring_enter failed: " ) + std::strerror( errno ) );
+            }
+        }
+    }
+#else
+public:
+    static std::unique_ptr<IoUring> create( const unsigned, const iovec*, const unsigned )
+    {
+        return nullptr;
+    }
+
+    void read( const int, char*, const size_t, const uint64_t, const uint16_t, const uint64_t ) {}
+
+    std::pair<uint64_t, int> wait()
+    {
+        return { 0, -ENOSYS };
+    }
+#endif
+}; // class IoUring
+
+
+AsyncFileReader::AsyncFileReader( const std::string& path, const bool use_io_uring,
+                                  const size_t block_size, const size_t depth )
+: mBlockSize{ block_size }
+, mSlots( std::max<size_t>( depth, 1 ) )
+, mBuffers{ nullptr, std::free }
+{
+    if ( block_size == 0 ) {
+        throw std::runtime_error( "[AsyncFileReader::AsyncFileReader] block_size must be positive" );
+    }
+
+    mFd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( mFd < 0 ) {
+        throw std::runtime_error( "[AsyncFileReader::AsyncFileReader] cannot open " + path + ": " + std::strerror( errno ) );
+    }
+    struct stat st{};
+    if ( ::fstat( mFd, &st ) != 0 ) {
+        const int err = errno;
+        ::close( mFd );
+        throw std::runtime_error( "[AsyncFileReader::AsyncFileReader] cannot stat " + path + ": " + std::strerror( err ) );
+    }
+    mSize = static_cast<uint64_t>( st.st_size );
+    ::posix_fadvise( mFd, 0, 0, POSIX_FADV_SEQUENTIAL );
+
+    // page aligned, one contiguous allocation split into the slots
+    constexpr size_t page_size = 4096;
+    const size_t slot_size = ( block_size + page_size - 1 ) / page_size * page_size;
+    mBuffers.reset( static_cast<char*>( std::aligned_alloc( page_size, slot_size * mSlots.size() ) ) );
+    if ( !mBuffers ) {
+        ::close( mFd );
+        throw std::bad_alloc();
+    }
+
+    std::vector<iovec> iovecs( mSlots.size() );
+    for ( size_t i = 0; i < mSlots.size(); i++ ) {
+        mSlots[i].data = mBuffers.get() + i * slot_size;
+        iovecs[i] = iovec{ mSlots[i].data, slot_size };
+    }
+    if ( use_io_uring ) {
+        mRing = IoUring::create( static_cast<unsigned>( mSlots.size() ), iovecs.data(), static_cast<unsigned>( iovecs.size() ) );
+        if ( !mRing ) {
+            spdlog::info( "[AsyncFileReader::AsyncFileReader] io_uring is not available, falling back to pread" );
+        }
+    }
+
+    for ( size_t i = 0; i < mSlots.size(); i++ ) {
+        submit( i );
+    }
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    // the kernel may still be writing into the buffers, wait for every read in flight
+    if ( mRing ) {
+        try {
+            for ( auto& slot : mSlots ) {
+                while ( slot.pending && !slot.done ) {
+                    reapOne();
+                }
+            }
+        } catch ( const std::exception& e ) {
+            spdlog::error( "[AsyncFileReader::~AsyncFileReader] {}", e.what() );
+        }
+    }
+    mRing.reset();
+    if ( mFd >= 0 ) {
+        ::close( mFd );
+    }
+}
+
+void AsyncFileReader::submit( const size_t slot_idx )
+{
+    auto& slot = mSlots[slot_idx];
+    slot.done = false;
+    slot.filled = 0;
+    if ( mNextOffset >= mSize ) {
+        slot.pending = false;
+        return;
+    }
+    slot.offset = mNextOffset;
+    slot.len = static_cast<size_t>( std::min<uint64_t>( mBlockSize, mSize - mNextOffset ) );
+    slot.pending = true;
+    mNextOffset += slot.len;
+    if ( mRing ) {
+        submitRemainder( slot_idx );
+    }
+}
+
+void AsyncFileReader::submitRemainder( const size_t slot_idx )
+{
+    auto& slot = mSlots[slot_idx];
+    mRing->read( mFd, slot.data + slot.filled, slot.len - slot.filled, slot.offset + slot.filled,
+                 static_cast<uint16_t>( slot_idx ), slot_idx );
+}
+
+void AsyncFileReader::reapOne()
+{
+    const auto [ slot_idx, res ] = mRing->wait();
+    auto& slot = mSlots[slot_idx];
+    if ( res == -EINTR || res == -EAGAIN ) {
+        submitRemainder( slot_idx );
+        return;
+    }
+    if ( res < 0 ) {
+        slot.done = true;
+        throw std::runtime_error( std::string( "[AsyncFileReader::reapOne] read failed: " ) + std::strerror( -res ) );
+    }
+    slot.filled += static_cast<size_t>( res );
+    // a short read before the end of the block, or the file shrank under us
+    if ( res != 0 && slot.filled < slot.len ) {
+        submitRemainder( slot_idx );
+        return;
+    }
+    slot.done = true;
+}
+
+bool AsyncFileReader::next( std::string_view& block )
+{
+    if ( mHeld ) {
+        submit( mHead );
+        mHead = ( mHead + 1 ) % mSlots.size();
+        mHeld = false;
+    }
+
+    auto& slot = mSlots[mHead];
+    if ( !slot.pending ) {
+        return false;
+    }
+
+    if ( mRing ) {
+        while ( !slot.done ) {
+            reapOne();
+        }
+    } else {
+        while ( slot.filled < slot.len ) {
+            const ssize_t res = ::pread( mFd, slot.data + slot.filled, slot.len - slot.filled, slot.offset + slot.filled );
+            if ( res < 0 ) {
+                if ( errno == EINTR ) {
+                    continue;
+                }
+                throw std::runtime_error( std::string( "[AsyncFileReader::next] pread failed: " ) + std::strerror( errno ) );
+            }
+            if ( res == 0 ) {
+                break;
+            }
+            slot.filled += static_cast<size_t>( res );
+        }
+        slot.done = true;
+    }
+
+    if ( slot.filled == 0 ) {
+        return false;
+    }
+    block = std::string_view( slot.data, slot.filled );
+    mHeld = true;
+    return true;
+}
+
+
+bool AsyncTokenReader::next( TokenBatch& batch )
+{
+    while ( true ) {
+        if ( mPos < mEnd ) {
+            mPos += Tokenizer::tokenize( mBlock.substr( mPos, mEnd - mPos ), mBatchLines, batch, mLevel );
+            return true;
+        }
+
+        // the incomplete line at the end of the block waits for the next one
+        if ( mHasBlock ) {
+            mCarry.append( mBlock.substr( mEnd ) );
+        }
+        mHasBlock = mFile.next( mBlock );
+        if ( !mHasBlock ) {
+            if ( mCarry.empty() ) {
+                return false;
+            }
+            mStitch.swap( mCarry );
+            mCarry.clear();
+            Tokenizer::tokenize( mStitch, mBatchLines, batch, mLevel );
+            return true;
+        }
+
+        const auto first_eol = mBlock.find( '\n' );
+        if ( first_eol == std::string_view::npos ) {
+            mPos = mEnd = 0;        // no line ends in this block, all of it is carried over
+            continue;
+        }
+        mEnd = mBlock.rfind( '\n' ) + 1;
+        mPos = 0;
+        if ( !mCarry.empty() ) {
+            mStitch.assign( mCarry );
+            mStitch.append( mBlock.substr( 0, first_eol + 1 ) );
+            mCarry.clear();
+            mPos = first_eol + 1;
+            Tokenizer::tokenize( mStitch, 1, batch, mLevel );
+            return true;
+        }
+    }
+}
+
+} // namespace sob
@@ -0,0 +1,119 @@
+#include <GzipStream.h>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+
+namespace sob {
+
+GzipTokenReader::GzipTokenReader( const std::string& path, const size_t batch_lines, const SimdLevel level,
+                                  const size_t block_size, const size_t ring_size )
+: mBlockSize{ block_size }
+, mBatchLines{ batch_lines }
+, mLevel{ level }
+, mRing{ ring_size }
+{
+    if ( block_size == 0 ) {
+        throw std::runtime_error( "[GzipTokenReader::GzipTokenReader] block_size must be positive" );
+    }
+    // checked here, so that a missing file is reported by the constructor rather than by next()
+    if ( !std::ifstream{ path, std::ios::binary } ) {
+        throw std::runtime_error( "[GzipTokenReader::GzipTokenReader] cannot open " + path );
+    }
+    mInflater = std::thread{ [this, path]() { inflate( path ); } };
+}
+
+GzipTokenReader::~GzipTokenReader()
+{
+    mStop.store( true, std::memory_order_relaxed );
+    if ( mInflater.joinable() ) {
+        mInflater.join();
+    }
+}
+
+void GzipTokenReader::inflate( const std::string& path )
+{
+    try {
+        std::ifstream file{ path, std::ios::binary };
+        boost::iostreams::filtering_istream in;
+        in.push( boost::iostreams::gzip_decompressor{} );
+        in.push( file );
+        // a corrupt file would otherwise look like a short one
+        in.exceptions( std::ios::badbit );
+
+        std::string carry;          // the incomplete last line of the previous block
+        bool eof{ false };
+        while ( !eof ) {
+            Block* block = mRing.acquire();
+            if ( block == nullptr ) {
+                if ( mStop.load( std::memory_order_relaxed ) ) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+
+            auto& buf = block->data;
+            buf.assign( carry );
+            carry.clear();
+            while ( true ) {
+                const size_t old_size = buf.size();
+                buf.resize( old_size + mBlockSize );
+                in.read( buf.data() + old_size, mBlockSize );
+                buf.resize( old_size + static_cast<size_t>( in.gcount() ) );
+                if ( !in ) {
+                    eof = true;
+                    break;
+                }
+                // a line longer than the block keeps the block growing until it ends
+                const auto eol = buf.rfind( '\n' );
+                if ( eol != std::string::npos ) {
+                    carry.assign( buf, eol + 1, std::string::npos );
+                    buf.resize( eol + 1 );
+                    break;
+                }
+            }
+
+            if ( !buf.empty() ) {
+                mRing.publish();
+            }
+        }
+    } catch ( ... ) {
+        mError = std::current_exception();
+    }
+    mRing.close();
+}
+
+bool GzipTokenReader::next( TokenBatch& batch )
+{
+    while ( true ) {
+        if ( mCur != nullptr ) {
+            if ( mPos < mCur->data.size() ) {
+                mPos += Tokenizer::tokenize( std::string_view( mCur->data ).substr( mPos ), mBatchLines, batch, mLevel );
+                return true;
+            }
+            mRing.pop();
+            mCur = nullptr;
+        }
+
+        mCur = mRing.front();
+        mPos = 0;
+        if ( mCur != nullptr ) {
+            continue;
+        }
+        if ( mRing.drained() ) {
+            if ( mInflater.joinable() ) {
+                mInflater.join();
+            }
+            if ( mError ) {
+                std::rethrow_exception( std::exchange( mError, nullptr ) );
+            }
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
+
+} // namespace sob
@@ -7,28 +7,28 @@
 namespace sob {
 
 // new order but do not notify
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
-bool L3Book<BuffType>::pureNewOrder( Order& order )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType, typename Alloc>
+bool L3Book<BuffType, SideType, Alloc>::pureNewOrder( Order& order )
 {
     if( order.isSell ) {
-        if ( bidBook.empty() || order.price > getBestBid().price ) {
+        if ( bidBook.empty() || order.price > bidBook.begin()->first ) {
             // Not aggressive/cross/market Order, quote orders only
-            askSideSize += order.size;
             if ( askBook.find( order.price ) == askBook.end() ) {
-                askBook[order.price] = L3PriceLevel<BuffType>{ std::vector<Order>{ order } };
-                orderMap[ order.orderId ] = askBook[order.price].orders.begin();
+                addLevel( askBook, order );
             } else {
+                touch( askBook, order.price );
                 auto it = askBook[order.price].addNewOrder( order, orderMap );
                 orderMap[order.orderId] = it;
             }
+            // only once the order rests, the book is left as it was if placing it throws
+            askSideSize += order.size;
             return false;
         } else {
             // aggressive order
             for( auto it = bidBook.begin(); it != bidBook.end(); ) {
-                const auto best_bid_size = getBestBid().quantity;
+                const auto best_bid_size = it->second.quantity;
                 if( it->first < order.price ) {
-                    askBook[order.price] = L3PriceLevel<BuffType>{ std::vector<Order>{ order } };
-                    orderMap[order.orderId] = askBook[order.price].orders.begin();
+                    addLevel( askBook, order );
                     askSideSize += order.size;
                     return true;
                 } 
@@ -36,40 +36,43 @@ bool L3Book<BuffType>::pureNewOrder( Order& order )
                 if( best_bid_size <= order.size ) { // this level will be filled
                     order.size -= best_bid_size;
                     for( auto oit = it->second.orders.begin(); oit != it->second.orders.end(); ++oit ) {
-                        orderMap.erase( oit->orderId );
+                        if ( !oit->dead ) {
+                            orderMap.erase( oit->orderId );
+                        }
                     }
+                    touch( bidBook, it->first );
                     it = bidBook.erase(it);
                     bidSideSize -= best_bid_size;
                 } else {    // this level will not be filled
+                    touch( bidBook, it->first );
                     bidSideSize -= ( it->second ).matchOrder( order, orderMap );
                     return true;
                 }
             }
             // this order has consumed all bidBook
-            askBook[ order.price ] = L3PriceLevel<BuffType>{ std::vector<Order>{ order } };
-            orderMap[order.orderId] = askBook[order.price].orders.begin();
+            addLevel( askBook, order );
             askSideSize += order.size;
             return true;
         }
     } else {
-        if ( askBook.empty() || order.price < getBestAsk().price ) {
+        if ( askBook.empty() || order.price < askBook.begin()->first ) {
             // Not aggressive/cross/market Order, quote orders only
-            bidSideSize += order.size;
             if ( bidBook.find( order.price ) == bidBook.end() ) {
-                bidBook[order.price] = L3PriceLevel<BuffType>{ std::vector<Order>{ order } };
-                orderMap[ order.orderId ] = bidBook[order.price].orders.begin();
+                addLevel( bidBook, order );
             } else {
+                touch( bidBook, order.price );
                 auto it = bidBook[order.price].addNewOrder( order, orderMap );
                 orderMap[ order.orderId ] = it;
             }
+            // only once the order rests, the book is left as it was if placing it throws
+            bidSideSize += order.size;
             return false;
         } else {
             // aggressive order
             for( auto it = askBook.begin(); it != askBook.end(); ) {
-                const auto best_ask_size = getBestAsk().quantity;
+                const auto best_ask_size = it->second.quantity;
                 if( it->first > order.price ) {
-                    bidBook[order.price] = L3PriceLevel<BuffType>{ std::vector<Order>{ order } };
-                    orderMap[order.orderId] = bidBook[order.price].orders.begin();
+                    addLevel( bidBook, order );
                     bidSideSize += order.size;
                     return true;
                 } 
@@ -77,18 +80,21 @@ bool L3Book<BuffType>::pureNewOrder( Order& order )
                 if( best_ask_size <= order.size ) { // this level will be filled
                     order.size -= best_ask_size;
                     for( auto oit = it->second.orders.begin(); oit != it->second.orders.end(); ++oit ) {
-                        orderMap.erase( oit->orderId );
+                        if ( !oit->dead ) {
+                            orderMap.erase( oit->orderId );
+                        }
                     }
+                    touch( askBook, it->first );
                     it = askBook.erase(it);
                     askSideSize -= best_ask_size;
                 } else {    // this level will not be filled
+                    touch( askBook, it->first );
                     askSideSize -= ( it->second ).matchOrder( order, orderMap );
                     return true;
                 }
             }
             // this order has consumed all askBook
-            bidBook[ order.price ] = L3PriceLevel<BuffType>{ std::vector<Order>{ order } };
-            orderMap[order.orderId] = bidBook[order.price].orders.begin();
+            addLevel( bidBook, order );
             bidSideSize += order.size;
             return true;
         }
@@ -97,8 +103,8 @@ bool L3Book<BuffType>::pureNewOrder( Order& order )
 
 
 // true: aggressive, false: not aggressive
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
-bool L3Book<BuffType>::newOrder( Order& order )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType, typename Alloc>
+bool L3Book<BuffType, SideType, Alloc>::newOrder( Order& order )
 {
     assert( !order.isCancel() );
     // assert( !order.isReprice() );
@@ -115,8 +121,8 @@ bool L3Book<BuffType>::newOrder( Order& order )
 
 
 // true: reprice success, false: reprice fail
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
-bool L3Book<BuffType>::modifyOrder( const Order& order )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType, typename Alloc>
+bool L3Book<BuffType, SideType, Alloc>::modifyOrder( const Order& order )
 {
     if ( (!order.isReprice()) || ( orderMap.find( *order.oldId ) == orderMap.end() ) ) {
         return false;
@@ -142,8 +148,8 @@ bool L3Book<BuffType>::modifyOrder( const Order& order )
 }
 
 // true: cancelled, false: cancel fail
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
-bool L3Book<BuffType>::cancelOrder( const Order& order )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType, typename Alloc>
+bool L3Book<BuffType, SideType, Alloc>::cancelOrder( const Order& order )
 {
     if (!order.isCancel()) {
         return false;
@@ -161,6 +167,16 @@ bool L3Book<BuffType>::cancelOrder( const Order& order )
 
 template class L3Book<std::list>;
 template class L3Book<boost::circular_buffer>;
+template class L3Book<std::list, LadderSide>;
+template class L3Book<boost::circular_buffer, LadderSide>;
+template class L3Book<std::list, HybridSide>;
+template class L3Book<boost::circular_buffer, HybridSide>;
+template class L3Book<OrderQueue>;
+template class L3Book<OrderQueue, LadderSide>;
+template class L3Book<OrderQueue, HybridSide>;
+template class L3Book<std::list, MapSide, PoolAlloc>;
+template class L3Book<boost::circular_buffer, MapSide, PoolAlloc>;
+template class L3Book<OrderQueue, MapSide, PoolAlloc>;
 
 
 } // namespace sob
@@ -0,0 +1,131 @@
+#include <MappedFile.h>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+
+namespace sob {
+
+MappedFile::MappedFile( const std::string& path )
+{
+    mFd = ::open( path.c_str(), O_RDONLY );
+    if ( mFd < 0 ) {
+        throw std::runtime_error( "[MappedFile::MappedFile] cannot open " + path + ": " + std::strerror( errno ) );
+    }
+
+    struct stat st{};
+    if ( ::fstat( mFd, &st ) != 0 ) {
+        const int err = errno;
+        ::close( mFd );
+        throw std::runtime_error( "[MappedFile::MappedFile] cannot stat " + path + ": " + std::strerror( err ) );
+    }
+    mSize = static_cast<size_t>( st.st_size );
+
+    // mmap refuses zero-length mappings, an empty file is simply an empty view
+    if ( mSize == 0 ) {
+        return;
+    }
+
+    void* addr = ::mmap( nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0 );
+    if ( addr == MAP_FAILED ) {
+        const int err = errno;
+        ::close( mFd );
+        throw std::runtime_error( "[MappedFile::MappedFile] cannot map " + path + ": " + std::strerror( err ) );
+    }
+    ::madvise( addr, mSize, MADV_SEQUENTIAL );
+    mData = static_cast<const char*>( addr );
+}
+
+MappedFile::~MappedFile()
+{
+    if ( mData != nullptr ) {
+        ::munmap( const_cast<char*>( mData ), mSize );
+    }
+    if ( mFd >= 0 ) {
+        ::close( mFd );
+    }
+}
+
+MappedFile::MappedFile( MappedFile&& rhs ) noexcept
+: mFd{ rhs.mFd }
+, mData{ rhs.mData }
+, mSize{ rhs.mSize }
+{
+    rhs.mFd = -1;
+    rhs.mData = nullptr;
+    rhs.mSize = 0;
+}
+
+MappedFile& MappedFile::operator=( MappedFile&& rhs ) noexcept
+{
+    if ( this != &rhs ) {
+        this->~MappedFile();
+        mFd = rhs.mFd;
+        mData = rhs.mData;
+        mSize = rhs.mSize;
+        rhs.mFd = -1;
+        rhs.mData = nullptr;
+        rhs.mSize = 0;
+    }
+    return *this;
+}
+
+void MappedFile::release( const size_t end ) const
+{
+    if ( mData == nullptr ) {
+        return;
+    }
+    static const size_t page_size = static_cast<size_t>( ::sysconf( _SC_PAGESIZE ) );
+    const size_t len = ( std::min( end, mSize ) / page_size ) * page_size;
+    if ( len != 0 ) {
+        ::madvise( const_cast<char*>( mData ), len, MADV_DONTNEED );
+    }
+}
+
+
+bool LineReader::next( std::string_view& line )
+{
+    const auto data = mFile.view();
+    if ( mPos >= data.size() ) {
+        return false;
+    }
+
+    if ( mPos - mReleased >= ReleaseStride ) {
+        mFile.release( mPos );
+        mReleased = mPos;
+    }
+
+    const auto eol = data.find( '\n', mPos );
+    const size_t end = ( eol == std::string_view::npos ) ? data.size() : eol;
+    line = data.substr( mPos, end - mPos );
+    if ( !line.empty() && line.back() == '\r' ) {
+        line.remove_suffix( 1 );
+    }
+    mPos = end + 1;
+    return true;
+}
+
+
+bool TokenReader::next( TokenBatch& batch )
+{
+    const auto data = mFile.view();
+    if ( mPos >= data.size() ) {
+        return false;
+    }
+
+    if ( mPos - mReleased >= ReleaseStride ) {
+        mFile.release( mPos );
+        mReleased = mPos;
+    }
+
+    mPos += Tokenizer::tokenize( data.substr( mPos ), mBatchLines, batch, mLevel );
+    return batch.lines() != 0;
+}
+
+} // namespace sob
@@ -0,0 +1,161 @@
+#include <StreamIndex.h>
+#include <BinaryFormat.h>
+#include <spdlog/spdlog.h>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+
+namespace sob {
+
+namespace {
+
+constexpr char IndexMagic[4] = { 'S', 'O', 'B', 'I' };
+constexpr uint32_t IndexVersion = 1;
+
+#pragma pack(push, 1)
+struct IndexHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t stride;
+    uint32_t reserved;
+    uint64_t streamSize;
+    uint64_t messages;
+    uint64_t entries;
+}; // struct IndexHeader
+#pragma pack(pop)
+
+} // namespace
+
+
+StreamIndex StreamIndex::build( std::string_view data, const uint32_t stride )
+{
+    if ( stride == 0 ) {
+        throw std::runtime_error( "[StreamIndex::build] stride must be positive" );
+    }
+
+    StreamIndex res;
+    res.mStride = stride;
+    res.mStreamSize = data.size();
+
+    if ( bin::isBinaryStream( data ) ) {
+        bin::Reader reader{ data };
+        bin::RecordView rec;
+        size_t pos = reader.position();
+        while ( reader.next( rec ) ) {
+            if ( res.mMessages % stride == 0 ) {
+                res.mOffsets.push_back( pos );
+            }
+            res.mMessages++;
+            pos = reader.position();
+        }
+        return res;
+    }
+
+    size_t pos{ 0 };
+    while ( pos < data.size() ) {
+        if ( res.mMessages % stride == 0 ) {
+            res.mOffsets.push_back( pos );
+        }
+        res.mMessages++;
+        const void* eol = std::memchr( data.data() + pos, '\n', data.size() - pos );
+        pos = ( eol == nullptr ) ? data.size() : static_cast<const char*>( eol ) - data.data() + 1;
+    }
+    return res;
+}
+
+uint64_t StreamIndex::offsetOf( std::string_view data, const uint64_t msg_no ) const
+{
+    const size_t entry = entryFor( msg_no );
+    if ( entry >= mOffsets.size() ) {
+        return data.size();
+    }
+    size_t pos = mOffsets[entry];
+    uint64_t left = msg_no - static_cast<uint64_t>( entry ) * mStride;
+
+    if ( bin::isBinaryStream( data ) ) {
+        bin::Reader reader{ data };
+        reader.seek( pos );
+        bin::RecordView rec;
+        while ( left > 0 && reader.next( rec ) ) {
+            left--;
+        }
+        return left == 0 ? reader.position() : data.size();
+    }
+
+    while ( left > 0 && pos < data.size() ) {
+        const void* eol = std::memchr( data.data() + pos, '\n', data.size() - pos );
+        pos = ( eol == nullptr ) ? data.size() : static_cast<const char*>( eol ) - data.data() + 1;
+        left--;
+    }
+    return pos;
+}
+
+std::optional<StreamIndex> StreamIndex::load( const std::string& path, const uint64_t stream_size )
+{
+    std::ifstream ifs{ path, std::ios::binary };
+    if ( !ifs ) {
+        return std::nullopt;
+    }
+
+    IndexHeader header{};
+    if ( !ifs.read( reinterpret_cast<char*>( &header ), sizeof( header ) )
+         || std::memcmp( header.magic, IndexMagic, sizeof( IndexMagic ) ) != 0
+         || header.version != IndexVersion || header.stride == 0
+         || header.streamSize != stream_size ) {
+        return std::nullopt;
+    }
+
+    StreamIndex res;
+    res.mStride = header.stride;
+    res.mStreamSize = header.streamSize;
+    res.mMessages = header.messages;
+    res.mOffsets.resize( header.entries );
+    if ( !ifs.read( reinterpret_cast<char*>( res.mOffsets.data() ), header.entries * sizeof( uint64_t ) ) ) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+void StreamIndex::save( const std::string& path ) const
+{
+    std::ofstream ofs{ path, std::ios::binary | std::ios::trunc };
+    if ( !ofs ) {
+        throw std::runtime_error( "[StreamIndex::save] cannot open " + path );
+    }
+
+    IndexHeader header{};
+    std::memcpy( header.magic, IndexMagic, sizeof( IndexMagic ) );
+    header.version = IndexVersion;
+    header.stride = mStride;
+    header.streamSize = mStreamSize;
+    header.messages = mMessages;
+    header.entries = mOffsets.size();
+    ofs.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    ofs.write( reinterpret_cast<const char*>( mOffsets.data() ), mOffsets.size() * sizeof( uint64_t ) );
+    if ( !ofs ) {
+        throw std::runtime_error( "[StreamIndex::save] cannot write " + path );
+    }
+}
+
+StreamIndex StreamIndex::loadOrBuild( const std::string& stream_path, const MappedFile& file, const uint32_t stride )
+{
+    const auto path = sidecarPath( stream_path );
+    if ( auto res = load( path, file.size() ); res && res->stride() == stride ) {
+        spdlog::info( "[StreamIndex::loadOrBuild] using {}, {} messages", path, res->messageCount() );
+        return *std::move( res );
+    }
+
+    auto res = build( file.view(), stride );
+    try {
+        res.save( path );
+        spdlog::info( "[StreamIndex::loadOrBuild] built {}, {} messages", path, res.messageCount() );
+    } catch ( const std::exception& e ) {
+        // a read-only directory only costs us the rebuild next time
+        spdlog::warn( "[StreamIndex::loadOrBuild] {}, the index is kept in memory only", e.what() );
+    }
+    return res;
+}
+
+} // namespace sob
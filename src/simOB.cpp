@@ -3,7 +3,11 @@
 #include <vector>
 #include <spdlog/spdlog.h>
 #include <boost/program_options.hpp>
-#include <fstream>
+#include <MappedFile.h>
+#include <BinaryFormat.h>
+#include <ColumnarFormat.h>
+#include <GzipStream.h>
+#include <AsyncFileReader.h>
 
 namespace po = boost::program_options;
 
@@ -11,33 +15,141 @@ namespace sob {
 
 
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
-L3Book<BuffType> runSimL3( std::vector<Order>& orders )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide>
+L3Book<BuffType, SideType> runSimL3( std::vector<Order>& orders )
 {
-    L3Book<BuffType> res{ orders };
+    L3Book<BuffType, SideType> res{ orders };
     return res;
 }
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
-L3Book<BuffType> runSimL3( std::vector<std::string>& order_strs )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide>
+L3Book<BuffType, SideType> runSimL3( std::vector<std::string>& order_strs )
 {
     std::vector<Order> orders;
+    Order order;
     for( const auto& str : order_strs ) {
-        orders.push_back( Order{ str } );
+        const auto err = Order::parse( str, order );
+        if ( err != ParseError::Ok ) {
+            spdlog::warn( "[sob::runSim] skipping line \"{}\", the error: {}", str, toString( err ) );
+            continue;
+        }
+        orders.push_back( order );
+    }
+    return runSimL3<BuffType, SideType>( orders );
+}
+
+// the text path of forEachOrder, Reader is a TokenReader, a GzipTokenReader or an AsyncTokenReader
+template <typename Reader, typename OnOrder>
+void forEachTextOrder( Reader& reader, OnOrder&& on_order )
+{
+    Order order;
+    TokenBatch batch;
+    while( reader.next( batch ) ) {
+        for ( size_t i = 0; i < batch.lines(); i++ ) {
+            auto cur = batch.cursor( i );
+            const auto err = Order::parseFields( cur, order );
+            if ( err != ParseError::Ok ) {
+                spdlog::warn( "[sob::forEachOrder] skipping line \"{}\", the error: {}", batch.line( i ), toString( err ) );
+                continue;
+            }
+            on_order( order );
+        }
     }
-    return runSimL3<BuffType>( orders );
 }
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
-L3Book<BuffType> runSimL3( const std::string& file_name )
+/**
+ *  @brief  call on_order for every order in the file, text, gzipped text, binary or columnar archive
+ *          the file is memory-mapped, so neither the lines nor the decoded orders are ever materialised
+ *          unless read_mode asks for text to be read in blocks, through io_uring or pread
+ */
+template <typename OnOrder>
+void forEachOrder( const std::string& file_name, OnOrder&& on_order, const ReadMode read_mode = ReadMode::Mmap )
+{
+    MappedFile file{ file_name };
+
+    if ( bin::isBinaryStream( file.view() ) ) {
+        Order order;
+        bin::Reader reader{ file.view() };
+        bin::RecordView rec;
+        while( reader.next( rec ) ) {
+            if ( !rec.isOrder() ) {
+                spdlog::warn( "[sob::forEachOrder] skipping non-order record with tag '{}'", rec.tag );
+                continue;
+            }
+            const auto err = reader.decode( rec, order );
+            if ( err != ParseError::Ok ) {
+                spdlog::warn( "[sob::forEachOrder] skipping record with tag '{}', the error: {}", rec.tag, toString( err ) );
+                continue;
+            }
+            on_order( order );
+        }
+        return;
+    }
+
+    if ( col::isArchive( file.view() ) ) {
+        col::Reader reader{ file.view() };
+        Message msg;
+        while( reader.next( msg ) ) {
+            if ( !std::holds_alternative<Order>( msg ) ) {
+                spdlog::warn( "[sob::forEachOrder] skipping non-order message" );
+                continue;
+            }
+            on_order( std::get<Order>( msg ) );
+        }
+        return;
+    }
+
+    if ( isGzipStream( file.view() ) ) {
+        GzipTokenReader reader{ file_name };
+        forEachTextOrder( reader, on_order );
+        return;
+    }
+
+    if ( read_mode != ReadMode::Mmap ) {
+        AsyncTokenReader reader{ file_name, read_mode == ReadMode::IoUring };
+        spdlog::info( "[sob::forEachOrder] reading through {}", reader.usingIoUring() ? "io_uring" : "pread" );
+        forEachTextOrder( reader, on_order );
+        return;
+    }
+
+    TokenReader reader{ file };
+    forEachTextOrder( reader, on_order );
+}
+
+/**
+ *  @brief  stream the file through the book, one order at a time
+ */
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
+L3Book<BuffType, SideType, Alloc> runSimL3( const std::string& file_name, const ReadMode read_mode = ReadMode::Mmap,
+                                            const size_t reserve_orders = 0 )
+{
+    L3Book<BuffType, SideType, Alloc> res;
+    res.reserveOrders( reserve_orders );
+    forEachOrder( file_name, [&res]( Order& order ) { res.applyOrder( order ); }, read_mode );
+    return res;
+}
+
+// the side container and the allocator are types, pick them from the --book_side and --allocator names
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+void runSimL3AndReport( const std::string& file_name, const ReadMode read_mode, const std::string& book_side,
+                        const std::string& allocator, const size_t reserve_orders )
 {
-    std::vector<std::string> order_strs;
-    std::ifstream ifs{ file_name };
-    std::string line;
-    while( std::getline( ifs, line ) ) {
-        order_strs.push_back( line );
+    if ( allocator == "pool" ) {
+        auto res_book = runSimL3<BuffType, MapSide, PoolAlloc>( file_name, read_mode, reserve_orders );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
+    } else if ( book_side == "hybrid" ) {
+        auto res_book = runSimL3<BuffType, HybridSide>( file_name, read_mode, reserve_orders );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
+    } else if ( book_side == "ladder" ) {
+        auto res_book = runSimL3<BuffType, LadderSide>( file_name, read_mode, reserve_orders );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
+    } else {
+        auto res_book = runSimL3<BuffType, MapSide>( file_name, read_mode, reserve_orders );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
     }
-    return runSimL3<BuffType>( order_strs );
 }
 
 L2Book runSim( std::vector<Order>& orders )
@@ -49,21 +161,23 @@ L2Book runSim( std::vector<Order>& orders )
 L2Book runSim( std::vector<std::string>& order_strs )
 {
     std::vector<Order> orders;
+    Order order;
     for( const auto& str : order_strs ) {
-        orders.push_back( Order{ str } );
+        const auto err = Order::parse( str, order );
+        if ( err != ParseError::Ok ) {
+            spdlog::warn( "[sob::runSim] skipping line \"{}\", the error: {}", str, toString( err ) );
+            continue;
+        }
+        orders.push_back( order );
     }
     return runSim( orders );
 }
 
-L2Book runSim( const std::string& file_name )
+L2Book runSim( const std::string& file_name, const ReadMode read_mode = ReadMode::Mmap )
 {
-    std::vector<std::string> order_strs;
-    std::ifstream ifs{ file_name };
-    std::string line;
-    while( std::getline( ifs, line ) ) {
-        order_strs.push_back( line );
-    }
-    return runSim( order_strs );
+    L2Book res;
+    forEachOrder( file_name, [&res]( Order& order ) { res.newOrder( order ); }, read_mode );
+    return res;
 }
 
 } // namespace sob
@@ -76,14 +190,39 @@ int main( int argc, char** argv )
         ("help", "produce help message")
         ("L2", "use L2Book, if unspecified, will use L3Book")
         ("test", "will run both L2Book and L3Book and test if the aggregated L3Book result is the same as the L2Book")
-        ("sim_file", po::value<std::string>(), "the simulation file you would like to input")
+        ("sim_file", po::value<std::string>(), "the simulation file you would like to input, .stream text, gzipped .stream.gz, the binary format or a columnar archive")
         ("dBufferType", po::value<std::string>(),
                  "what type of dBuffer you would like to use, "
                  "which is the buffer type used in the L3PriceLevel, "
-                 "\nchoose from: [ list, circular_buffer ], "
+                 "\nchoose from: [ list, circular_buffer, queue ], "
+                 "\nqueue is a linked list of pooled nodes, orders are canceled in O(1) and never move, "
                  "\ndefault to: circular_buffer"
                  "\n**More of a perf consideration, result is unaffected**"
          )
+        ("reader", po::value<std::string>()->default_value( "mmap" ),
+                 "how text streams are read, choose from: [ mmap, io_uring, pread ]; "
+                 "io_uring keeps several large reads in flight and falls back to pread when unavailable"
+         )
+        ("ticks_per_unit", po::value<uint32_t>()->default_value( 10000 ),
+                 "the instrument's tick size as ticks per price unit, i.e. a tick is 1 / ticks_per_unit; "
+                 "prices are held as integer ticks, rounded to the nearest one"
+         )
+        ("book_side", po::value<std::string>()->default_value( "map" ),
+                 "the container holding the levels of each L3Book side, choose from: [ map, ladder, hybrid ]; "
+                 "ladder is a dense array indexed by tick, for books dense around the touch, "
+                 "hybrid keeps such an array for the ticks at the touch and a map for the sparse tail"
+                 "\n**More of a perf consideration, result is unaffected**"
+         )
+        ("reserve_orders", po::value<size_t>()->default_value( 0 ),
+                 "the resting orders expected, the order map of the L3Book is sized for them up front "
+                 "so that it does not rehash as the book fills up"
+         )
+        ("allocator", po::value<std::string>()->default_value( "std" ),
+                 "where an L3Book allocates its levels, orders and order map entries from, choose from: [ std, pool ]; "
+                 "pool gives each book a pool of its own, recycling what canceled orders and consumed levels free, "
+                 "it only applies to the map book_side"
+                 "\n**More of a perf consideration, result is unaffected**"
+         )
     ;
 
     po::variables_map vm;
@@ -103,21 +242,53 @@ int main( int argc, char** argv )
         throw std::runtime_error("sim_file not specified");
     }
 
+    sob::TickSize::set( vm["ticks_per_unit"].as<uint32_t>() );
+
+    const auto read_mode = sob::toReadMode( vm["reader"].as<std::string>() );
+    if ( !read_mode ) {
+        throw std::runtime_error("unknown reader " + vm["reader"].as<std::string>());
+    }
+
+    const auto book_side = vm["book_side"].as<std::string>();
+    if ( book_side != "map" && book_side != "ladder" && book_side != "hybrid" ) {
+        throw std::runtime_error("unknown book_side " + book_side);
+    }
+
+    const auto reserve_orders = vm["reserve_orders"].as<size_t>();
+
+    const auto allocator = vm["allocator"].as<std::string>();
+    if ( allocator != "std" && allocator != "pool" ) {
+        throw std::runtime_error("unknown allocator " + allocator);
+    }
+    if ( allocator == "pool" && book_side != "map" ) {
+        throw std::runtime_error("allocator pool only applies to book_side map, the ladders keep their own pages");
+    }
+
     if ( vm.count("test") ) {
-        auto l3_res_book = sob::runSimL3<boost::circular_buffer>( sim_file );
-        auto l2_res_book = sob::runSim( sim_file );
-        if ( l3_res_book.agg() == l2_res_book ) {
-            spdlog::info( "[::main] -- test passed --" );
+        auto l2_res_book = sob::runSim( sim_file, *read_mode );
+        const auto check = [&l2_res_book]( const auto& l3_res_book ) {
+            if ( l3_res_book.agg() == l2_res_book ) {
+                spdlog::info( "[::main] -- test passed --" );
+            } else {
+                spdlog::error( "[::main] -- test failed --" );
+                spdlog::error( "[::main] L3 res book: \n{}", l3_res_book.toString() );
+                spdlog::error( "[::main] aggregated L2 res book: \n{}", l3_res_book.agg().toString() );
+                spdlog::error( "[::main] L2 res book: \n{}", l2_res_book.toString() );
+            }
+        };
+        if ( book_side == "hybrid" ) {
+            check( sob::runSimL3<boost::circular_buffer, sob::HybridSide>( sim_file, *read_mode ) );
+        } else if ( book_side == "ladder" ) {
+            check( sob::runSimL3<boost::circular_buffer, sob::LadderSide>( sim_file, *read_mode ) );
+        } else if ( allocator == "pool" ) {
+            check( sob::runSimL3<boost::circular_buffer, sob::MapSide, sob::PoolAlloc>( sim_file, *read_mode ) );
         } else {
-            spdlog::error( "[::main] -- test failed --" );
-            spdlog::error( "[::main] L3 res book: \n{}", l3_res_book.toString() );
-            spdlog::error( "[::main] aggregated L2 res book: \n{}", l3_res_book.agg().toString() );
-            spdlog::error( "[::main] L2 res book: \n{}", l2_res_book.toString() );
+            check( sob::runSimL3<boost::circular_buffer>( sim_file, *read_mode ) );
         }
     } else {
         if (vm.count("L2")) {
             spdlog::info("[::main] using L2OrderBook" );
-            auto res_book = sob::runSim( sim_file );
+            auto res_book = sob::runSim( sim_file, *read_mode );
             spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
         } else {
             std::string dBufferType;
@@ -131,11 +302,11 @@ int main( int argc, char** argv )
 
             spdlog::info("[::main] using L3OrderBook" );
             if (dBufferType == "list") {
-                auto res_book = sob::runSimL3<std::list>( sim_file );
-                spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
+                sob::runSimL3AndReport<std::list>( sim_file, *read_mode, book_side, allocator, reserve_orders );
             } else if (dBufferType == "circular_buffer") {  
-                auto res_book = sob::runSimL3<boost::circular_buffer>( sim_file );
-                spdlog::info( "[::main] Got result book: \n{}", res_book.toString() );
+                sob::runSimL3AndReport<boost::circular_buffer>( sim_file, *read_mode, book_side, allocator, reserve_orders );
+            } else if (dBufferType == "queue") {
+                sob::runSimL3AndReport<sob::OrderQueue>( sim_file, *read_mode, book_side, allocator, reserve_orders );
             }
         }
     }
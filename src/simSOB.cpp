@@ -4,38 +4,270 @@
 #include <vector>
 #include <spdlog/spdlog.h>
 #include <boost/program_options.hpp>
-#include <fstream>
+#include <MappedFile.h>
+#include <BinaryFormat.h>
+#include <ColumnarFormat.h>
+#include <StreamIndex.h>
+#include <ChunkedDecoder.h>
+#include <GzipStream.h>
+#include <AsyncFileReader.h>
 #include <Strategy.h>
 
 namespace po = boost::program_options;
 
 namespace sob {
 
+/**
+ *  @brief  how runSimSOB replays a file
+ *  @member threads: > 1 decodes index-aligned chunks of the file in parallel, the book is still updated in order
+ *  @member startMsg: replay from this message on, located through the sidecar index
+ *  @member readMode: how a text stream is read, in blocks through io_uring or pread rather than mmap
+ */
+struct ReplayOptions
+{
+    bool verbose{ false };
+    bool pipeline{ false };
+    size_t threads{ 1 };
+    uint64_t startMsg{ 0 };
+    ReadMode readMode{ ReadMode::Mmap };
+    size_t reserveOrders{ 0 };
+}; // struct ReplayOptions
+
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
-SmartOrderBook<BuffType> runSimSOB( std::vector<std::string>& order_strs, bool verbose = false )
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide>
+SmartOrderBook<BuffType, SideType> runSimSOB( std::vector<std::string>& order_strs, bool verbose = false )
 {
-    SmartOrderBook<BuffType> sob;
+    SmartOrderBook<BuffType, SideType> sob;
+    LoggingStrategy<BuffType, SideType> strategy;
     if( verbose ) {
-        LoggingStrategy<BuffType> strategy;
         sob.acceptSubscription( &strategy );
     }
     for( const auto& str : order_strs ) {
         sob.applyMessage( str );
     }
+    sob.cancelSubscription( &strategy );
     return sob;
 }
 
-template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer>
-SmartOrderBook<BuffType> runSimSOB( const std::string& file_name, bool verbose = false )
+// the text path of runPipelined, Reader is a TokenReader, a GzipTokenReader or an AsyncTokenReader
+template <typename Reader, template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType,
+          typename Alloc>
+void applyTextPipelined( Reader& reader, SmartOrderBook<BuffType, SideType, Alloc>& sob )
+{
+    TokenBatch batch;
+    size_t idx{ 0 };
+    sob.applyMessagesPipelined( [&reader, &batch, &idx]( Message& msg ) {
+        while ( true ) {
+            if ( idx == batch.lines() ) {
+                if ( !reader.next( batch ) ) {
+                    return false;
+                }
+                idx = 0;
+            }
+            const size_t i = idx++;
+            const auto err = decodeMessage( batch, i, msg );
+            if ( err == ParseError::Ok ) {
+                return true;
+            }
+            if ( err != ParseError::Empty ) {
+                spdlog::warn( "[sob::runPipelined] skipping line \"{}\", the error: {}", batch.line( i ), toString( err ) );
+            }
+        }
+    } );
+}
+
+// one message at a time, Reader is a TokenReader, a GzipTokenReader or an AsyncTokenReader
+template <typename Reader, template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType,
+          typename Alloc>
+void applyText( Reader& reader, SmartOrderBook<BuffType, SideType, Alloc>& sob )
+{
+    TokenBatch batch;
+    Message msg;
+    while( reader.next( batch ) ) {
+        for ( size_t i = 0; i < batch.lines(); i++ ) {
+            const auto err = decodeMessage( batch, i, msg );
+            if ( err == ParseError::Ok ) {
+                sob.applyMessage( msg );
+            } else if ( err != ParseError::Empty ) {
+                spdlog::warn( "[sob::runSimSOB] skipping line \"{}\", the error: {}", batch.line( i ), toString( err ) );
+            }
+        }
+    }
+}
+
+/**
+ *  @brief  decode the file on a helper thread while the SmartOrderBook applies on this one
+ *          malformed messages are skipped by the decoder, so only valid messages cross the ring
+ */
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType,
+          typename Alloc>
+void runPipelined( const MappedFile& file, const size_t start, SmartOrderBook<BuffType, SideType, Alloc>& sob )
 {
-    std::vector<std::string> order_strs;
-    std::ifstream ifs{ file_name };
-    std::string line;
-    while( std::getline( ifs, line ) ) {
-        order_strs.push_back( line );
+    if ( bin::isBinaryStream( file.view() ) ) {
+        bin::Reader reader{ file.view() };
+        if ( start != 0 ) {
+            reader.seek( start );
+        }
+        bin::RecordView rec;
+        sob.applyMessagesPipelined( [&reader, &rec]( Message& msg ) {
+            while ( reader.next( rec ) ) {
+                const auto err = reader.decode( rec, msg );
+                if ( err == ParseError::Ok ) {
+                    return true;
+                }
+                spdlog::warn( "[sob::runPipelined] skipping record with tag '{}', the error: {}", rec.tag, toString( err ) );
+            }
+            return false;
+        } );
+        return;
+    }
+
+    TokenReader reader{ file };
+    reader.seek( start );
+    applyTextPipelined( reader, sob );
+}
+
+/**
+ *  @brief  stream the memory-mapped file through the SmartOrderBook, one message at a time
+ *          the file is .stream text, gzipped text or the binary format
+ */
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType,
+          typename Alloc>
+void replay( const std::string& file_name, const ReplayOptions& opts, SmartOrderBook<BuffType, SideType, Alloc>& sob )
+{
+    MappedFile file{ file_name };
+    if ( isGzipStream( file.view() ) ) {
+        if ( opts.threads > 1 || opts.startMsg != 0 ) {
+            spdlog::warn( "[sob::runSimSOB] gzipped streams can only be replayed from the start, "
+                          "ignoring --threads and --start_msg" );
+        }
+        GzipTokenReader reader{ file_name };
+        if ( opts.pipeline ) {
+            applyTextPipelined( reader, sob );
+        } else {
+            applyText( reader, sob );
+        }
+        return;
+    }
+
+    if ( col::isArchive( file.view() ) ) {
+        if ( opts.threads > 1 ) {
+            spdlog::warn( "[sob::runSimSOB] columnar archives are decoded on one thread, ignoring --threads" );
+        }
+        col::Reader reader{ file.view() };
+        if ( opts.startMsg != 0 ) {
+            const auto skipped = reader.skip( opts.startMsg );
+            spdlog::info( "[sob::runSimSOB] starting from message {}", skipped );
+        }
+        if ( opts.pipeline ) {
+            sob.applyMessagesPipelined( [&reader]( Message& msg ) { return reader.next( msg ); } );
+        } else {
+            Message msg;
+            while( reader.next( msg ) ) {
+                sob.applyMessage( msg );
+            }
+        }
+        return;
+    }
+
+    if ( opts.readMode != ReadMode::Mmap ) {
+        if ( bin::isBinaryStream( file.view() ) || opts.threads > 1 || opts.startMsg != 0 ) {
+            spdlog::warn( "[sob::runSimSOB] --reader only applies to text streams replayed from the start, "
+                          "reading through mmap" );
+        } else {
+            AsyncTokenReader reader{ file_name, opts.readMode == ReadMode::IoUring };
+            spdlog::info( "[sob::runSimSOB] reading through {}", reader.usingIoUring() ? "io_uring" : "pread" );
+            if ( opts.pipeline ) {
+                applyTextPipelined( reader, sob );
+            } else {
+                applyText( reader, sob );
+            }
+            return;
+        }
+    }
+
+    size_t start{ 0 };
+    if ( opts.threads > 1 || opts.startMsg != 0 ) {
+        const auto index = StreamIndex::loadOrBuild( file_name, file );
+        if ( opts.threads > 1 ) {
+            ChunkedDecoder decoder{ file.view(), index, opts.threads };
+            decoder.run( [&sob]( Message* msgs, const size_t cnt ) {
+                for ( size_t i = 0; i < cnt; i++ ) {
+                    sob.applyMessage( msgs[i] );
+                }
+            }, opts.startMsg );
+            return;
+        }
+        start = index.offsetOf( file.view(), opts.startMsg );
+        spdlog::info( "[sob::runSimSOB] starting from message {} at byte {}", opts.startMsg, start );
+    }
+
+    if ( opts.pipeline ) {
+        runPipelined( file, start, sob );
+        return;
+    }
+
+    if ( bin::isBinaryStream( file.view() ) ) {
+        bin::Reader reader{ file.view() };
+        if ( start != 0 ) {
+            reader.seek( start );
+        }
+        bin::RecordView rec;
+        Message msg;
+        while( reader.next( rec ) ) {
+            const auto err = reader.decode( rec, msg );
+            if ( err != ParseError::Ok ) {
+                spdlog::warn( "[sob::runSimSOB] skipping record with tag '{}', the error: {}", rec.tag, toString( err ) );
+                continue;
+            }
+            sob.applyMessage( msg );
+        }
+        return;
+    }
+
+    TokenReader reader{ file };
+    reader.seek( start );
+    applyText( reader, sob );
+}
+
+/**
+ *  @brief  replay the file into a new SmartOrderBook, see replay()
+ *          the logging strategy only lives as long as the replay, it is unsubscribed before the book is handed out
+ */
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType = boost::circular_buffer,
+          typename SideType = MapSide, typename Alloc = std::allocator<RestingOrder>>
+SmartOrderBook<BuffType, SideType, Alloc> runSimSOB( const std::string& file_name, const ReplayOptions& opts = {} )
+{
+    SmartOrderBook<BuffType, SideType, Alloc> sob;
+    sob.reserveOrders( opts.reserveOrders );
+    LoggingStrategy<BuffType, SideType, Alloc> strategy;
+    if( opts.verbose ) {
+        sob.acceptSubscription( &strategy );
+    }
+    replay( file_name, opts, sob );
+    sob.cancelSubscription( &strategy );
+    return sob;
+}
+
+// the side container and the allocator are types, pick them from the --book_side and --allocator names
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+void runSimSOBAndReport( const std::string& file_name, const ReplayOptions& opts, const std::string& book_side,
+                         const std::string& allocator )
+{
+    if ( allocator == "pool" ) {
+        auto res_book = runSimSOB<BuffType, MapSide, PoolAlloc>( file_name, opts );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.getLeaderBook()->toString() );
+    } else if ( book_side == "hybrid" ) {
+        auto res_book = runSimSOB<BuffType, HybridSide>( file_name, opts );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.getLeaderBook()->toString() );
+    } else if ( book_side == "ladder" ) {
+        auto res_book = runSimSOB<BuffType, LadderSide>( file_name, opts );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.getLeaderBook()->toString() );
+    } else {
+        auto res_book = runSimSOB<BuffType, MapSide>( file_name, opts );
+        spdlog::info( "[::main] Got result book: \n{}", res_book.getLeaderBook()->toString() );
     }
-    return runSimSOB<BuffType>( order_strs, verbose );
 }
 
 } // namespace sob
@@ -47,15 +279,45 @@ int main( int argc, char** argv )
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help", "produce help message")
-        ("sim_file", po::value<std::string>(), "the simulation file you would like to input")
+        ("sim_file", po::value<std::string>(), "the simulation file you would like to input, .stream text, gzipped .stream.gz, the binary format or a columnar archive")
         ("verbose", "you want to be loud or not")
+        ("pipeline", "decode the stream on a separate thread while the book is updated on the main one")
+        ("threads", po::value<size_t>()->default_value( 1 ),
+                 "decode chunks of the stream on that many threads, the book is still updated in stream order; "
+                 "uses, or builds, the <sim_file>.idx sidecar index")
+        ("start_msg", po::value<uint64_t>()->default_value( 0 ),
+                 "replay from this message on ( 0 based, every line of a text stream counts ), "
+                 "located through the <sim_file>.idx sidecar index, or the block headers of a columnar archive")
+        ("reader", po::value<std::string>()->default_value( "mmap" ),
+                 "how text streams are read, choose from: [ mmap, io_uring, pread ]; "
+                 "io_uring keeps several large reads in flight and falls back to pread when unavailable")
+        ("ticks_per_unit", po::value<uint32_t>()->default_value( 10000 ),
+                 "the instrument's tick size as ticks per price unit, i.e. a tick is 1 / ticks_per_unit; "
+                 "prices are held as integer ticks, rounded to the nearest one"
+         )
         ("dBufferType", po::value<std::string>(),
                  "what type of dBuffer you would like to use, "
                  "which is the buffer type used in the L3PriceLevel, "
-                 "\nchoose from: [ list, circular_buffer ], "
+                 "\nchoose from: [ list, circular_buffer, queue ], "
+                 "\nqueue is a linked list of pooled nodes, orders are canceled in O(1) and never move, "
                  "\ndefault to: circular_buffer"
                  "\n**More of a perf consideration, result is unaffected**"
          )
+        ("book_side", po::value<std::string>()->default_value( "map" ),
+                 "the container holding the levels of each book side, choose from: [ map, ladder, hybrid ]; "
+                 "ladder is a dense array indexed by tick, for books dense around the touch, "
+                 "hybrid keeps such an array for the ticks at the touch and a map for the sparse tail"
+                 "\n**More of a perf consideration, result is unaffected**"
+         )
+        ("reserve_orders", po::value<size_t>()->default_value( 0 ),
+                 "the resting orders expected, the order map of each book is sized for them up front "
+                 "so that it does not rehash as the book fills up")
+        ("allocator", po::value<std::string>()->default_value( "std" ),
+                 "where each L3Book allocates its levels, orders and order map entries from, choose from: [ std, pool ]; "
+                 "pool gives each book a pool of its own, recycling what canceled orders and consumed levels free, "
+                 "it only applies to the map book_side"
+                 "\n**More of a perf consideration, result is unaffected**"
+         )
     ;
 
     po::variables_map vm;
@@ -84,18 +346,40 @@ int main( int argc, char** argv )
         dBufferType = "circular_buffer";
     }
 
-    bool verbose = false;
-    if (vm.count("verbose")) {
-        verbose = true;
+    sob::TickSize::set( vm["ticks_per_unit"].as<uint32_t>() );
+
+    sob::ReplayOptions opts;
+    opts.verbose = vm.count("verbose") > 0;
+    opts.pipeline = vm.count("pipeline") > 0;
+    opts.threads = vm["threads"].as<size_t>();
+    opts.startMsg = vm["start_msg"].as<uint64_t>();
+    opts.reserveOrders = vm["reserve_orders"].as<size_t>();
+    const auto read_mode = sob::toReadMode( vm["reader"].as<std::string>() );
+    if ( !read_mode ) {
+        throw std::runtime_error("unknown reader " + vm["reader"].as<std::string>());
+    }
+    opts.readMode = *read_mode;
+
+    const auto book_side = vm["book_side"].as<std::string>();
+    if ( book_side != "map" && book_side != "ladder" && book_side != "hybrid" ) {
+        throw std::runtime_error("unknown book_side " + book_side);
+    }
+
+    const auto allocator = vm["allocator"].as<std::string>();
+    if ( allocator != "std" && allocator != "pool" ) {
+        throw std::runtime_error("unknown allocator " + allocator);
+    }
+    if ( allocator == "pool" && book_side != "map" ) {
+        throw std::runtime_error("allocator pool only applies to book_side map, the ladders keep their own pages");
     }
 
     spdlog::info("[::main] using L3OrderBook" );
     if (dBufferType == "list") {
-        auto res_book = sob::runSimSOB<std::list>( sim_file, verbose );
-        spdlog::info( "[::main] Got result book: \n{}", res_book.getLeaderBook()->toString() );
+        sob::runSimSOBAndReport<std::list>( sim_file, opts, book_side, allocator );
     } else if (dBufferType == "circular_buffer") {  
-        auto res_book = sob::runSimSOB<boost::circular_buffer>( sim_file, verbose );
-        spdlog::info( "[::main] Got result book: \n{}", res_book.getLeaderBook()->toString() );
+        sob::runSimSOBAndReport<boost::circular_buffer>( sim_file, opts, book_side, allocator );
+    } else if (dBufferType == "queue") {
+        sob::runSimSOBAndReport<sob::OrderQueue>( sim_file, opts, book_side, allocator );
     }
 
     return 0;
@@ -0,0 +1,198 @@
+#include <BinaryFormat.h>
+#include <ColumnarFormat.h>
+#include <MappedFile.h>
+#include <common.h>
+#include <spdlog/spdlog.h>
+#include <boost/program_options.hpp>
+#include <fstream>
+
+namespace po = boost::program_options;
+
+namespace sob {
+
+/**
+ *  @brief  .stream text -> binary records or columnar archive, Writer is a bin::Writer or a col::Writer
+ *          lines that do not parse are skipped with a warning
+ */
+template <typename Writer>
+size_t textToRecords( std::string_view data, Writer& writer )
+{
+    Order order;
+    Trade trade;
+    L2Book snapshot;
+    size_t cnt{};
+
+    size_t pos{};
+    while ( pos < data.size() ) {
+        auto eol = data.find( '\n', pos );
+        if ( eol == std::string_view::npos ) {
+            eol = data.size();
+        }
+        const auto line = data.substr( pos, eol - pos );
+        pos = eol + 1;
+
+        FieldCursor cur{ line };
+        const auto type = cur.next();
+        if ( type.empty() ) {
+            continue;
+        }
+
+        ParseError err{ ParseError::UnknownType };
+        if ( type == "N" || type == "C" || type == "R" ) {
+            if ( ( err = Order::parse( line, order ) ) == ParseError::Ok ) {
+                writer.write( order );
+            }
+        } else if ( type == "T" ) {
+            if ( ( err = Trade::parse( line, trade ) ) == ParseError::Ok ) {
+                writer.write( trade );
+            }
+        } else if ( type == "S" ) {
+            if ( ( err = L2Book::parse( line, snapshot ) ) == ParseError::Ok ) {
+                writer.write( snapshot );
+            }
+        }
+
+        if ( err != ParseError::Ok ) {
+            spdlog::warn( "[sob::textToRecords] skipping line \"{}\", the error: {}", line, toString( err ) );
+            continue;
+        }
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ *  @brief  one decoded message -> its .stream text line
+ */
+void writeText( Message& msg, std::ostream& os )
+{
+    std::visit( [&os]( auto& m ) {
+        using T = std::decay_t<decltype( m )>;
+        if constexpr ( std::is_same_v<T, Order> || std::is_same_v<T, L2Book> ) {
+            os << m.to_simple_string() << '\n';
+        } else {
+            os << m.toString() << '\n';
+        }
+    }, msg );
+}
+
+/**
+ *  @brief  columnar archive -> .stream text, one message per line
+ */
+size_t archiveToText( std::string_view data, std::ostream& os )
+{
+    col::Reader reader{ data };
+    Message msg;
+    size_t cnt{};
+    while ( reader.next( msg ) ) {
+        writeText( msg, os );
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ *  @brief  binary records -> .stream text, one message per line
+ */
+size_t binaryToText( std::string_view data, std::ostream& os )
+{
+    bin::Reader reader{ data };
+    bin::RecordView rec;
+    Order order;
+    Trade trade;
+    L2Book snapshot;
+    size_t cnt{};
+
+    while ( reader.next( rec ) ) {
+        ParseError err{};
+        if ( rec.isOrder() ) {
+            if ( ( err = reader.decode( rec, order ) ) == ParseError::Ok ) {
+                os << order.to_simple_string() << '\n';
+            }
+        } else if ( rec.tag == 'T' ) {
+            if ( ( err = reader.decode( rec, trade ) ) == ParseError::Ok ) {
+                os << trade.toString() << '\n';
+            }
+        } else if ( rec.tag == 'S' ) {
+            if ( ( err = reader.decode( rec, snapshot ) ) == ParseError::Ok ) {
+                os << snapshot.to_simple_string() << '\n';
+            }
+        } else {
+            err = ParseError::UnknownType;
+        }
+
+        if ( err != ParseError::Ok ) {
+            spdlog::warn( "[sob::binaryToText] skipping record with tag '{}', the error: {}", rec.tag, toString( err ) );
+            continue;
+        }
+        cnt++;
+    }
+    return cnt;
+}
+
+} // namespace sob
+
+
+int main( int argc, char** argv )
+{
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("input", po::value<std::string>(), "the stream file to convert, text or binary is detected from its header")
+        ("output", po::value<std::string>(), "where to write the converted stream")
+        ("format", po::value<std::string>()->default_value( "binary" ),
+                 "what text is converted to, choose from: [ binary, columnar ]; "
+                 "columnar is the compact archive format, for long-term storage")
+        ("px_scale", po::value<uint32_t>()->default_value( sob::bin::DefaultPxScale ),
+                 "ticks per price unit used when writing binary or columnar, prices are rounded to 1 / px_scale")
+    ;
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help") || !vm.count("input") || !vm.count("output")) {
+        std::cout << "convert a .stream file between the text and the binary or columnar format\n" << desc << "\n";
+        return 1;
+    }
+
+    const auto input = vm["input"].as<std::string>();
+    const auto output = vm["output"].as<std::string>();
+
+    sob::MappedFile file{ input };
+    std::ofstream ofs{ output, std::ios::binary };
+    if ( !ofs ) {
+        throw std::runtime_error( "cannot open output file " + output );
+    }
+
+    const auto format = vm["format"].as<std::string>();
+    if ( format != "binary" && format != "columnar" ) {
+        throw std::runtime_error( "unknown format " + format );
+    }
+    const auto px_scale = vm["px_scale"].as<uint32_t>();
+
+    size_t cnt{};
+    if ( sob::bin::isBinaryStream( file.view() ) ) {
+        spdlog::info( "[::main] converting binary {} to text {}", input, output );
+        cnt = sob::binaryToText( file.view(), ofs );
+    } else if ( sob::col::isArchive( file.view() ) ) {
+        spdlog::info( "[::main] converting columnar {} to text {}", input, output );
+        cnt = sob::archiveToText( file.view(), ofs );
+    } else {
+        spdlog::info( "[::main] converting text {} to {} {}", input, format, output );
+        std::string out;
+        if ( format == "columnar" ) {
+            sob::col::Writer writer{ out, px_scale };
+            cnt = sob::textToRecords( file.view(), writer );
+            writer.flush();
+        } else {
+            sob::bin::Writer writer{ out, px_scale };
+            cnt = sob::textToRecords( file.view(), writer );
+        }
+        spdlog::info( "[::main] {} bytes of text -> {} bytes", file.view().size(), out.size() );
+        ofs.write( out.data(), out.size() );
+    }
+    spdlog::info( "[::main] converted {} messages", cnt );
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <AsyncFileReader.h>
+#include <MappedFile.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+std::string writeFile( const std::string& name, const std::string& content )
+{
+    const std::string path = "/tmp/sob_test_" + name;
+    std::ofstream{ path, std::ios::binary } << content;
+    return path;
+}
+
+template <typename Reader>
+std::vector<std::vector<std::string>> readAllFields( Reader& reader )
+{
+    std::vector<std::vector<std::string>> res;
+    sob::TokenBatch batch;
+    while ( reader.next( batch ) ) {
+        for ( size_t i = 0; i < batch.lines(); i++ ) {
+            auto cur = batch.cursor( i );
+            auto& fields = res.emplace_back();
+            while ( !cur.atEnd() ) {
+                fields.emplace_back( cur.next() );
+            }
+        }
+    }
+    return res;
+}
+
+} // namespace
+
+
+TEST_CASE( "test_AsyncFileReader_blocks", "1" )
+{
+    std::string content;
+    for ( int i = 0; i < 5000; i++ ) {
+        content += std::to_string( i * 7919 ) + ( i % 13 == 0 ? "\n" : " " );
+    }
+    const auto path = writeFile( "async_blocks.bin", content );
+
+    for ( const bool use_io_uring : { true, false } ) {
+        for ( const size_t block_size : { size_t{ 1 }, size_t{ 100 }, size_t{ 4096 }, content.size() * 2 } ) {
+            for ( const size_t depth : { size_t{ 1 }, size_t{ 3 } } ) {
+                sob::AsyncFileReader reader{ path, use_io_uring, block_size, depth };
+                REQUIRE( reader.size() == content.size() );
+                std::string read;
+                std::string_view block;
+                while ( reader.next( block ) ) {
+                    REQUIRE( !block.empty() );
+                    REQUIRE( block.size() <= block_size );
+                    read.append( block );
+                }
+                REQUIRE( read == content );
+                REQUIRE_FALSE( reader.next( block ) );
+            }
+        }
+    }
+
+    // a reader dropped halfway waits for the reads still in flight
+    sob::AsyncFileReader reader{ path, true, 64, 4 };
+    std::string_view block;
+    REQUIRE( reader.next( block ) );
+    REQUIRE( block == std::string_view( content ).substr( 0, 64 ) );
+}
+
+TEST_CASE( "test_AsyncTokenReader", "1" )
+{
+    std::string content;
+    for ( int i = 0; i < 2000; i++ ) {
+        content += "N " + std::to_string( i ) + " 1 100 1.5\n";
+        if ( i % 100 == 0 ) {
+            content += "T 0";                       // lines much longer than the small blocks
+            for ( int j = 0; j < 20; j++ ) {
+                content += " 1.5 " + std::to_string( j );
+            }
+            content += "\r\n\n";
+        }
+    }
+    content += "S 0 1 1.5 100";                     // no trailing newline
+
+    const auto path = writeFile( "async.stream", content );
+    sob::MappedFile file{ path };
+    sob::TokenReader mapped_reader{ file };
+    const auto expected = readAllFields( mapped_reader );
+    REQUIRE( expected.size() == 2000 + 20 * 2 + 1 );
+
+    for ( const bool use_io_uring : { true, false } ) {
+        for ( const size_t block_size : { size_t{ 16 }, size_t{ 1000 }, sob::AsyncFileReader::DefaultBlockSize } ) {
+            for ( const size_t depth : { size_t{ 1 }, size_t{ 2 }, size_t{ 3 } } ) {
+                sob::AsyncTokenReader reader{ path, use_io_uring, 7, sob::BestSimdLevel, block_size, depth };
+                REQUIRE( readAllFields( reader ) == expected );
+            }
+        }
+    }
+}
+
+TEST_CASE( "test_AsyncTokenReader_edges", "1" )
+{
+    const auto empty_path = writeFile( "async_empty.stream", "" );
+    for ( const bool use_io_uring : { true, false } ) {
+        sob::AsyncTokenReader reader{ empty_path, use_io_uring };
+        sob::TokenBatch batch;
+        REQUIRE_FALSE( reader.next( batch ) );
+    }
+
+    const auto one_path = writeFile( "async_one.stream", "N 1 1 100 1.5" );
+    sob::AsyncTokenReader reader{ one_path, true, 1024, sob::BestSimdLevel, 4, 2 };
+    const auto fields = readAllFields( reader );
+    REQUIRE( fields == std::vector<std::vector<std::string>>{ { "N", "1", "1", "100", "1.5" } } );
+
+    REQUIRE_THROWS_AS( sob::AsyncFileReader( "/tmp/sob_test_does_not_exist.stream" ), std::runtime_error );
+}
@@ -0,0 +1,82 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <BinaryFormat.h>
+#include <vector>
+#include <string>
+
+
+TEST_CASE( "test_BinaryFormat_roundtrip", "1" )
+{
+    const std::vector<std::string> msgs {
+        "N 0 1 100 1.5",
+        "C 6 0 0 0 1 0 0",
+        "R 6 1 250 1.5 2 1.4 250",
+        "T 1 0.9 10 1.1 5 1.2 30",
+        "S 2 3 1.2 100 1.3 150 1.35 50 1.4 50 1.5 100",
+    };
+
+    std::string buf;
+    sob::bin::Writer writer{ buf };
+    writer.write( sob::Order{ msgs[0] } );
+    writer.write( sob::Order{ msgs[1] } );
+    writer.write( sob::Order{ msgs[2] } );
+    writer.write( sob::Trade{ msgs[3] } );
+    sob::L2Book snapshot{ msgs[4] };
+    writer.write( snapshot );
+
+    REQUIRE( sob::bin::isBinaryStream( buf ) );
+    REQUIRE( buf.size() == sizeof( sob::bin::FileHeader )
+                         + 3 * sizeof( sob::bin::RecordHeader ) + sizeof( sob::bin::OrderBody ) + sizeof( sob::bin::CancelBody ) + sizeof( sob::bin::RepriceBody )
+                         + sizeof( sob::bin::RecordHeader ) + sizeof( sob::bin::TradeBody ) + 3 * sizeof( sob::bin::LevelBody )
+                         + sizeof( sob::bin::RecordHeader ) + sizeof( sob::bin::SnapShotBody ) + 5 * sizeof( sob::bin::LevelBody ) );
+
+    sob::bin::Reader reader{ buf };
+    sob::bin::RecordView rec;
+    sob::Order order;
+    sob::Trade trade;
+    sob::L2Book decoded;
+
+    for ( int i = 0; i < 3; i++ ) {
+        REQUIRE( reader.next( rec ) );
+        REQUIRE( rec.isOrder() );
+        REQUIRE( reader.decode( rec, order ) == sob::ParseError::Ok );
+        REQUIRE( order.to_simple_string() == msgs[i] );
+    }
+
+    REQUIRE( reader.next( rec ) );
+    REQUIRE( reader.decode( rec, order ) == sob::ParseError::UnknownType );
+    REQUIRE( reader.decode( rec, trade ) == sob::ParseError::Ok );
+    REQUIRE( trade == sob::Trade{ msgs[3] } );
+
+    REQUIRE( reader.next( rec ) );
+    REQUIRE( reader.decode( rec, decoded ) == sob::ParseError::Ok );
+    REQUIRE( decoded == snapshot );
+
+    REQUIRE( !reader.next( rec ) );
+}
+
+TEST_CASE( "test_BinaryFormat_truncated", "1" )
+{
+    std::string buf;
+    sob::bin::Writer writer{ buf };
+    writer.write( sob::Order{ "N 0 1 100 1.5" } );
+    buf.pop_back();
+
+    sob::bin::Reader reader{ buf };
+    sob::bin::RecordView rec;
+    REQUIRE( !reader.next( rec ) );
+
+    // a trade record without a level decodes to nothing
+    std::string empty_buf;
+    sob::bin::Writer empty_writer{ empty_buf };
+    sob::Trade empty;
+    empty.isSell = true;
+    empty_writer.write( empty );
+    sob::bin::Reader empty_reader{ empty_buf };
+    REQUIRE( empty_reader.next( rec ) );
+    sob::Trade trade;
+    REQUIRE( empty_reader.decode( rec, trade ) == sob::ParseError::MissingField );
+
+    REQUIRE( !sob::bin::isBinaryStream( "N 0 1 100 1.5" ) );
+    REQUIRE_THROWS( sob::bin::Reader{ "N 0 1 100 1.5\nN 1 1 100 1.4" } );
+}
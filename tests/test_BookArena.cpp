@@ -0,0 +1,145 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <L3OrderBook.h>
+#include <memory_resource>
+#include <list>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+// cancels at the back of a level, a reprice and a sweep
+const std::vector<std::string> Orders {
+    "N 0 1 100 1.5",
+    "N 1 1 100 1.4",
+    "N 2 1 200 1.4",
+    "N 3 1 150 1.4",
+    "N 4 1 250 1.4",
+    "N 5 1 50 1.4",
+    "N 6 0 50 1.3",
+    "N 7 0 100 1.3",
+    "N 8 0 100 1.2",
+    "C 20 0 0 0 5 0 0",
+    "R 9 1 60 1.45 4 1.4 250",
+    "C 21 0 0 0 7 0 0",
+    "N 10 0 120 1.4",
+    "N 11 1 30 1.4",
+    "C 22 0 0 0 11 0 0",
+    "N 12 0 400 1.6",
+};
+
+// counts what the pools draw from upstream
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    size_t allocations{ 0 };
+
+private:
+    void* do_allocate( size_t bytes, size_t alignment ) override
+    {
+        allocations++;
+        return std::pmr::new_delete_resource()->allocate( bytes, alignment );
+    }
+
+    void do_deallocate( void* p, size_t bytes, size_t alignment ) override
+    {
+        std::pmr::new_delete_resource()->deallocate( p, bytes, alignment );
+    }
+
+    bool do_is_equal( const std::pmr::memory_resource& rhs ) const noexcept override
+    {
+        return this == &rhs;
+    }
+}; // class CountingResource
+
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+void requireSameAsStd()
+{
+    sob::L3Book<BuffType> std_book;
+    sob::L3Book<BuffType, sob::MapSide, sob::PoolAlloc> pool_book;
+    for ( const auto& str: Orders ) {
+        sob::Order std_order{ str };
+        sob::Order pool_order{ str };
+        REQUIRE( std_book.applyOrder( std_order ) == pool_book.applyOrder( pool_order ) );
+        REQUIRE( pool_book.toString() == std_book.toString() );
+        REQUIRE( pool_book.agg() == std_book.agg() );
+    }
+    REQUIRE( ( *pool_book.queryOrderId( 0 ) )->size == 90 );
+
+    // the copy draws from a pool of its own and outlives the book it was copied from
+    auto source = std::make_unique<sob::L3Book<BuffType, sob::MapSide, sob::PoolAlloc>>( pool_book );
+    sob::L3Book<BuffType, sob::MapSide, sob::PoolAlloc> copy{ *source };
+    source.reset();
+    REQUIRE( copy.toString() == std_book.toString() );
+    sob::Order cancel{ "C 23 0 0 0 0 0 0" };
+    REQUIRE( copy.applyOrder( cancel ).second );
+    REQUIRE( !copy.queryOrderId( 0 ) );
+    REQUIRE( pool_book.queryOrderId( 0 ) );
+
+    copy = pool_book;
+    REQUIRE( copy.toString() == std_book.toString() );
+    REQUIRE( ( *copy.queryOrderId( 0 ) )->size == 90 );
+}
+
+// quotes on both sides, the bids canceled, the asks swept by a buy which rests and is canceled
+template <typename Book>
+void cycle( Book& book, int& id )
+{
+    const int first = id;
+    for ( int lvl = 0; lvl < 20; lvl++ ) {
+        for ( int i = 0; i < 4; i++ ) {
+            sob::Order bid{ "N " + std::to_string( id++ ) + " 0 10 " + std::to_string( 1.0 - 0.01 * lvl ) };
+            book.applyOrder( bid );
+            sob::Order ask{ "N " + std::to_string( id++ ) + " 1 10 " + std::to_string( 1.1 + 0.01 * lvl ) };
+            book.applyOrder( ask );
+        }
+    }
+    for ( int bid_id = id - 2; bid_id >= first; bid_id -= 2 ) {
+        sob::Order cancel{ "C " + std::to_string( id ) + " 0 0 0 " + std::to_string( bid_id ) + " 0 0" };
+        book.applyOrder( cancel );
+    }
+    sob::Order sweep{ "N " + std::to_string( id++ ) + " 0 900 2.0" };
+    book.applyOrder( sweep );
+    sob::Order cancel{ "C " + std::to_string( id ) + " 0 0 0 " + std::to_string( id - 1 ) + " 0 0" };
+    book.applyOrder( cancel );
+}
+
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+void requireSteadyState()
+{
+    CountingResource upstream;
+    auto* const prev = std::pmr::set_default_resource( &upstream );
+    {
+        sob::L3Book<BuffType, sob::MapSide, sob::PoolAlloc> book;
+        int id = 0;
+        for ( int i = 0; i < 3; i++ ) {
+            cycle( book, id );
+        }
+        const size_t warm = upstream.allocations;
+        REQUIRE( warm > 0 );
+        for ( int i = 0; i < 50; i++ ) {
+            cycle( book, id );
+        }
+        REQUIRE( upstream.allocations == warm );
+        REQUIRE( book.getAskSideSize() == 0 );
+    }
+    std::pmr::set_default_resource( prev );
+}
+
+} // namespace
+
+
+TEST_CASE( "test_BookArena_same_as_std", "1" )
+{
+    requireSameAsStd<std::list>();
+    requireSameAsStd<boost::circular_buffer>();
+    requireSameAsStd<sob::OrderQueue>();
+}
+
+TEST_CASE( "test_BookArena_steady_state", "1" )
+{
+    requireSteadyState<std::list>();
+    requireSteadyState<boost::circular_buffer>();
+    requireSteadyState<sob::OrderQueue>();
+}
@@ -0,0 +1,105 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/fmt.h>
+#include <Message.h>
+#include <SmartOrderBook.h>
+#include <BookMirror.h>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// orders around 1.0, some of them crossing, cancels, and now and then a trade or a snapshot
+std::vector<std::string> randomStream( const int cnt )
+{
+    std::mt19937 gen{ 7 };
+    std::uniform_int_distribution<int> op{ 0, 19 };
+    std::uniform_int_distribution<int> tick{ 0, 8 };
+    std::vector<std::string> msgs;
+    for ( int id = 0; id < cnt; id++ ) {
+        const int o = op( gen );
+        if ( o < 6 && id > 0 ) {
+            const int old_id = std::uniform_int_distribution<int>{ 0, id - 1 }( gen );
+            msgs.push_back( fmt::format( "C {} 0 0 0 {} 0 0", id, old_id ) );
+        } else if ( o == 6 ) {
+            msgs.push_back( fmt::format( "T {} {} {}", id % 2, 0.95 + 0.01 * tick( gen ), 10 ) );
+        } else if ( o == 7 ) {
+            msgs.push_back( fmt::format( "S 1 1 {} {} {} {}", 0.95 - 0.01 * tick( gen ), 50, 1.05 + 0.01 * tick( gen ), 50 ) );
+        } else {
+            const bool is_sell = o % 2 == 0;
+            const int t = o == 8 ? -tick( gen ) : tick( gen );
+            const double px = is_sell ? 1.0 + 0.01 * t : 0.99 - 0.01 * t;
+            msgs.push_back( fmt::format( "N {} {} {} {}", id, is_sell ? 1 : 0, 10 + 10 * tick( gen ), px ) );
+        }
+    }
+    return msgs;
+}
+
+} // namespace
+
+
+TEST_CASE("test_BookMirror", "1")
+{
+    spdlog::set_level( spdlog::level::err );
+    const auto stream = randomStream( 20000 );
+
+    sob::SmartOrderBook<> book;
+    sob::BookMirror<> mirror{ 256 };
+
+    // a reader on a thread of its own, the copies it gets only ever move forward
+    std::atomic<bool> done{ false };
+    size_t reads = 0;
+    bool in_order = true;
+    std::thread reader{ [&]() {
+        size_t last = 0;
+        while ( !done.load() ) {
+            const auto copy = mirror.latest();
+            in_order = in_order && copy->messages() >= last;
+            last = copy->messages();
+            copy->leader().getBestBid();
+            reads++;
+        }
+    } };
+
+    sob::Message msg;
+    size_t pushed = 0;
+    for ( const auto& str: stream ) {
+        if ( sob::decodeMessage( str, msg ) != sob::ParseError::Ok ) {
+            continue;
+        }
+        mirror.push( msg );
+        book.applyMessage( msg );
+        pushed++;
+    }
+    mirror.close();
+    done.store( true );
+    reader.join();
+
+    REQUIRE( in_order );
+    REQUIRE( reads > 0 );
+
+    const auto copy = mirror.latest();
+    REQUIRE( copy->messages() == pushed );
+    REQUIRE( copy->groundTruth().toString() == book.getGroundTruth()->toString() );
+    REQUIRE( copy->leader().toString() == book.getLeaderView().toString() );
+    REQUIRE( copy->leader().agg() == book.getLeaderView().agg() );
+
+    spdlog::set_level( spdlog::level::info );
+}
+
+TEST_CASE("test_BookMirror_held_copy", "1")
+{
+    sob::BookMirror<> mirror;
+    sob::Order first{ "N 0 1 100 1.5" };
+    mirror.push( first );
+    mirror.close();
+
+    // what a reader holds stays as it was
+    const auto held = mirror.latest();
+    REQUIRE( held->messages() == 1 );
+    REQUIRE( held->groundTruth().getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.5 }, 100 } );
+}
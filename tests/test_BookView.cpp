@@ -0,0 +1,83 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <L3OrderBook.h>
+#include <list>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+const std::vector<std::string> Orders {
+    "N 0 1 100 1.5",
+    "N 1 1 100 1.4",
+    "N 2 1 200 1.4",
+    "N 3 1 150 1.4",
+    "N 4 0 50 1.3",
+    "N 5 0 100 1.3",
+    "N 6 0 100 1.2",
+    "C 20 0 0 0 2 0 0",
+};
+
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType>
+void requireViews()
+{
+    sob::L3Book<BuffType> book;
+    const auto& const_book = book;
+    REQUIRE( !const_book.bestBidView() );
+    REQUIRE( !const_book.topOfBook().bid );
+    REQUIRE( const_book.bestAskView().toL2PriceLevel() == sob::L2PriceLevel{} );
+
+    for ( const auto& str: Orders ) {
+        sob::Order order{ str };
+        book.applyOrder( order );
+    }
+
+    // order 2 was canceled from the middle of its level, the view steps over it
+    const auto ask = const_book.bestAskView();
+    REQUIRE( ask );
+    REQUIRE( ask.price() == 1.4 );
+    REQUIRE( ask.quantity() == 250 );
+    REQUIRE( ask.numOrders() == 2 );
+    std::vector<int> ids;
+    for ( const auto& order: ask.orders() ) {
+        ids.push_back( order.orderId );
+    }
+    REQUIRE( ids == std::vector<int>{ 1, 3 } );
+    REQUIRE( ask.front().orderId == 1 );
+
+    // read in place, nothing copied
+    REQUIRE( &ask.level() == &const_book.getAskSide().begin()->second );
+    REQUIRE( &ask.front() == &*( *book.queryOrderId( 1 ) ) );
+
+    const auto top = const_book.topOfBook();
+    REQUIRE( *top.bid == sob::L2PriceLevel( 1.3, 150 ) );
+    REQUIRE( *top.ask == sob::L2PriceLevel( 1.4, 250 ) );
+    REQUIRE( book.getBestMarket().toString() == book.getBestMarketL3().toString() );
+
+    // the depth, read off the const sides
+    int bid_qty = 0;
+    for ( const auto& [px, level]: const_book.getBidSide() ) {
+        bid_qty += sob::LevelView<typename sob::L3Book<BuffType>::Level>{ level }.quantity();
+    }
+    REQUIRE( bid_qty == 250 );
+
+    // a value of its own, the book moving on does not change it
+    sob::Order sweep{ "N 7 0 300 1.4" };
+    book.applyOrder( sweep );
+    REQUIRE( *top.bid == sob::L2PriceLevel( 1.3, 150 ) );
+    const auto next = const_book.topOfBook();
+    REQUIRE( *next.bid == sob::L2PriceLevel( 1.4, 50 ) );
+    REQUIRE( *next.ask == sob::L2PriceLevel( 1.5, 100 ) );
+    REQUIRE( const_book.bestBidView().orders().begin()->orderId == 7 );
+}
+
+} // namespace
+
+
+TEST_CASE( "test_BookView", "1" )
+{
+    requireViews<std::list>();
+    requireViews<boost::circular_buffer>();
+    requireViews<sob::OrderQueue>();
+}
@@ -0,0 +1,168 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <ColumnarFormat.h>
+#include <BinaryFormat.h>
+#include <vector>
+#include <string>
+#include <cstring>
+
+
+namespace {
+
+const std::vector<std::string> Msgs {
+    "N 0 1 100 1.5",
+    "C 6 0 0 0 1 0 0",
+    "R 6 1 250 1.5 2 1.4 250",
+    "T 1 0.9 10 1.1 5 1.2 30",
+    "S 2 3 1.2 100 1.3 150 1.35 50 1.4 50 1.5 100",
+    "N 7 0 20 1.3",
+    "T 0 1.4 20",
+};
+
+void write( sob::col::Writer& writer, const std::string& msg )
+{
+    switch ( msg[0] )
+    {
+        case 'T':
+            writer.write( sob::Trade{ msg } );
+            break;
+        case 'S': {
+            sob::L2Book snapshot{ msg };
+            writer.write( snapshot );
+            break;
+        }
+        default:
+            writer.write( sob::Order{ msg } );
+    }
+}
+
+void requireMessage( const sob::Message& msg, const std::string& expected )
+{
+    switch ( expected[0] )
+    {
+        case 'T':
+            REQUIRE( std::holds_alternative<sob::Trade>( msg ) );
+            REQUIRE( std::get<sob::Trade>( msg ) == sob::Trade{ expected } );
+            break;
+        case 'S':
+            REQUIRE( std::holds_alternative<sob::L2Book>( msg ) );
+            REQUIRE( std::get<sob::L2Book>( msg ) == sob::L2Book{ expected } );
+            break;
+        default:
+            REQUIRE( std::holds_alternative<sob::Order>( msg ) );
+            REQUIRE( std::get<sob::Order>( msg ).to_simple_string() == expected );
+    }
+}
+
+} // namespace
+
+
+TEST_CASE( "test_ColumnarFormat_roundtrip", "1" )
+{
+    for ( const size_t block_msgs : { size_t{ 1 }, size_t{ 3 }, sob::col::DefaultBlockMsgs } ) {
+        std::string buf;
+        {
+            sob::col::Writer writer{ buf, sob::bin::DefaultPxScale, block_msgs };
+            for ( const auto& msg: Msgs ) {
+                write( writer, msg );
+            }
+        }
+        REQUIRE( sob::col::isArchive( buf ) );
+        REQUIRE_FALSE( sob::bin::isBinaryStream( buf ) );
+
+        sob::col::Reader reader{ buf };
+        sob::Message msg;
+        for ( const auto& expected: Msgs ) {
+            REQUIRE( reader.next( msg ) );
+            requireMessage( msg, expected );
+        }
+        REQUIRE_FALSE( reader.next( msg ) );
+    }
+}
+
+TEST_CASE( "test_ColumnarFormat_skip", "1" )
+{
+    std::string buf;
+    sob::col::Writer writer{ buf, sob::bin::DefaultPxScale, 3 };
+    for ( int i = 0; i < 10; i++ ) {
+        writer.write( sob::Order{ "N " + std::to_string( i ) + " 0 10 1." + std::to_string( i ) } );
+    }
+    writer.flush();
+
+    for ( uint64_t start = 0; start <= 11; start++ ) {
+        sob::col::Reader reader{ buf };
+        REQUIRE( reader.skip( start ) == std::min<uint64_t>( start, 10 ) );
+        sob::Message msg;
+        for ( uint64_t i = start; i < 10; i++ ) {
+            REQUIRE( reader.next( msg ) );
+            REQUIRE( std::get<sob::Order>( msg ).orderId == static_cast<int>( i ) );
+        }
+        REQUIRE_FALSE( reader.next( msg ) );
+    }
+}
+
+TEST_CASE( "test_ColumnarFormat_compact", "1" )
+{
+    std::string text;
+    std::string buf;
+    {
+        sob::col::Writer writer{ buf };
+        for ( int i = 0; i < 10000; i++ ) {
+            const auto line = "N " + std::to_string( 100000 + i ) + " " + std::to_string( i % 2 ) + " "
+                            + std::to_string( 100 + i % 7 * 50 ) + " 1." + std::to_string( 2300 + i % 11 );
+            text += line + '\n';
+            writer.write( sob::Order{ line } );
+        }
+    }
+    REQUIRE( buf.size() * 4 < text.size() );
+}
+
+TEST_CASE( "test_ColumnarFormat_corrupt", "1" )
+{
+    std::string buf;
+    {
+        sob::col::Writer writer{ buf };
+        for ( const auto& msg: Msgs ) {
+            write( writer, msg );
+        }
+    }
+
+    // a truncated last block ends the archive
+    auto truncated = buf;
+    truncated.pop_back();
+    sob::col::Reader truncated_reader{ truncated };
+    sob::Message msg;
+    REQUIRE_FALSE( truncated_reader.next( msg ) );
+
+    // an unknown tag is reported
+    const size_t block_pos = sizeof( sob::col::FileHeader );
+    auto bad_tag = buf;
+    bad_tag[block_pos + sizeof( sob::col::BlockHeader )] = 'X';
+    sob::col::Reader bad_tag_reader{ bad_tag };
+    REQUIRE_THROWS( bad_tag_reader.next( msg ) );
+
+    // so is a column shorter than its messages need
+    auto bad_cnt = buf;
+    auto header = sob::bin::load<sob::col::BlockHeader>( bad_cnt.data() + block_pos );
+    header.msgCnt++;
+    std::memcpy( bad_cnt.data() + block_pos, &header, sizeof( header ) );
+    sob::col::Reader bad_cnt_reader{ bad_cnt };
+    for ( size_t i = 0; i < Msgs.size(); i++ ) {
+        REQUIRE( bad_cnt_reader.next( msg ) );
+    }
+    REQUIRE_THROWS( bad_cnt_reader.next( msg ) );
+
+    // and a trade without a level
+    std::string empty_buf;
+    {
+        sob::Trade empty;
+        empty.isSell = false;
+        sob::col::Writer writer{ empty_buf };
+        writer.write( empty );
+    }
+    sob::col::Reader empty_reader{ empty_buf };
+    REQUIRE_THROWS( empty_reader.next( msg ) );
+
+    REQUIRE_FALSE( sob::col::isArchive( "N 0 1 100 1.5" ) );
+    REQUIRE_THROWS( sob::col::Reader{ "N 0 1 100 1.5\nN 1 1 100 1.4" } );
+}
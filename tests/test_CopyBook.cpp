@@ -6,6 +6,8 @@
 #include <OrderBook.h>
 #include <L3OrderBook.h>
 #include <vector>
+#include <list>
+#include <random>
 
 TEST_CASE("test_CopyBook", "1")
 {
@@ -112,3 +114,122 @@ TEST_CASE("test_CopyBook_assignment", "1")
     std::cout << ob.toString() << std::endl;
     spdlog::set_level( spdlog::level::info );
 }
+
+namespace {
+
+std::string randomOrder( std::mt19937& gen, int& id )
+{
+    std::uniform_int_distribution<int> op{ 0, 9 };
+    std::uniform_int_distribution<int> tick{ 0, 6 };
+    if ( op( gen ) < 4 && id > 0 ) {
+        const int old_id = std::uniform_int_distribution<int>{ 0, id - 1 }( gen );
+        return fmt::format( "C {} 0 0 0 {} 0 0", id++, old_id );
+    }
+    const bool is_sell = op( gen ) < 5;
+    // now and then one crossing the spread
+    const int t = op( gen ) == 0 ? -tick( gen ) : tick( gen );
+    const double px = is_sell ? 1.0 + 0.01 * t : 0.99 - 0.01 * t;
+    return fmt::format( "N {} {} {} {}", id++, is_sell ? 1 : 0, 1 + op( gen ) * 10, px );
+}
+
+template <typename Book>
+void requireSameBook( const Book& book, const Book& ref, const int max_id )
+{
+    REQUIRE( book.toString() == ref.toString() );
+    REQUIRE( book.agg() == ref.agg() );
+    for ( int id = 0; id < max_id; id++ ) {
+        const auto found = book.queryOrderId( id );
+        const auto ref_found = ref.queryOrderId( id );
+        REQUIRE( bool( found ) == bool( ref_found ) );
+        if ( found ) {
+            REQUIRE( ( *found )->orderId == id );
+            REQUIRE( ( *found )->size == ( *ref_found )->size );
+        }
+    }
+}
+
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType>
+void requireSyncedLikeCopies()
+{
+    using Book = sob::L3Book<BuffType, SideType>;
+    std::mt19937 gen{ 3 };
+    Book truth;
+    Book trade;
+    Book snapshot;
+    int id = 0;
+    int guess_id = 100000;
+    for ( int round = 0; round < 300; round++ ) {
+        for ( int i = 0; i < 5; i++ ) {
+            sob::Order order{ randomOrder( gen, id ) };
+            truth.applyOrder( order );
+        }
+        // the shadow books take guesses of their own in between
+        if ( round % 3 == 0 ) {
+            sob::Order guess{ randomOrder( gen, guess_id ) };
+            trade.applyOrder( guess );
+        }
+        if ( round % 7 == 0 ) {
+            sob::Order guess{ fmt::format( "C {} 0 0 0 {} 0 0", guess_id++, id / 2 ) };
+            snapshot.applyOrder( guess );
+        }
+        if ( round % 11 == 5 ) {
+            // trade misses a round, it gets a full copy the next time
+            truth.syncTo( snapshot );
+        } else {
+            truth.syncTo( trade, snapshot );
+        }
+        if ( round % 11 != 5 ) {
+            requireSameBook( trade, truth, id );
+        }
+        requireSameBook( snapshot, truth, id );
+    }
+
+    // the copies are the synced books' own, canceling there leaves the source alone
+    for ( int old_id = 0; old_id < id; old_id++ ) {
+        if ( const auto found = trade.queryOrderId( old_id ) ) {
+            REQUIRE( &**found != &**truth.queryOrderId( old_id ) );
+            sob::Order cancel{ fmt::format( "C {} 0 0 0 {} 0 0", guess_id++, old_id ) };
+            REQUIRE( trade.applyOrder( cancel ).second );
+            REQUIRE( truth.queryOrderId( old_id ) );
+            break;
+        }
+    }
+}
+
+template <template <typename T, typename AllocT=std::allocator<T> > class BuffType, typename SideType>
+void requireDoubleBufferSynced()
+{
+    using Book = sob::L3Book<BuffType, SideType>;
+    std::mt19937 gen{ 5 };
+    Book truth;
+    Book buffers[2];
+    int id = 0;
+    for ( int round = 0; round < 300; round++ ) {
+        for ( int i = 0; i < 4; i++ ) {
+            sob::Order order{ randomOrder( gen, id ) };
+            truth.applyOrder( order );
+        }
+        // synced in turns, each one a round behind when its turn comes
+        auto& back = buffers[round % 2];
+        truth.syncTo( back );
+        requireSameBook( back, truth, id );
+    }
+}
+
+} // namespace
+
+TEST_CASE("test_CopyBook_syncTo_double_buffer", "1")
+{
+    requireDoubleBufferSynced<boost::circular_buffer, sob::MapSide>();
+    requireDoubleBufferSynced<std::list, sob::MapSide>();
+    requireDoubleBufferSynced<sob::OrderQueue, sob::HybridSide>();
+}
+
+TEST_CASE("test_CopyBook_syncTo", "1")
+{
+    requireSyncedLikeCopies<boost::circular_buffer, sob::MapSide>();
+    requireSyncedLikeCopies<std::list, sob::MapSide>();
+    requireSyncedLikeCopies<sob::OrderQueue, sob::MapSide>();
+    requireSyncedLikeCopies<boost::circular_buffer, sob::LadderSide>();
+    requireSyncedLikeCopies<boost::circular_buffer, sob::HybridSide>();
+}
@@ -0,0 +1,157 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <FlatHashMap.h>
+#include <L3OrderBook.h>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+// every key has the same home, a single run the probing and the back shifting have to get right
+struct SameHome
+{
+    size_t operator()( const int ) const
+    {
+        return 0;
+    }
+}; // struct SameHome
+
+template <typename Map>
+void requireSameEntries( const Map& map, const std::unordered_map<int, int>& ref )
+{
+    REQUIRE( map.size() == ref.size() );
+    size_t seen = 0;
+    for ( const auto& [key, val]: map ) {
+        const auto found = ref.find( key );
+        REQUIRE( found != ref.end() );
+        REQUIRE( found->second == val );
+        seen++;
+    }
+    REQUIRE( seen == ref.size() );
+}
+
+template <typename Map>
+void randomOps( const unsigned seed, const int keys )
+{
+    std::mt19937 gen{ seed };
+    std::uniform_int_distribution<int> key{ 0, keys };
+    std::uniform_int_distribution<int> op{ 0, 9 };
+
+    Map map;
+    std::unordered_map<int, int> ref;
+    for ( int i = 0; i < 20000; i++ ) {
+        const int k = key( gen );
+        const int roll = op( gen );
+        if ( roll < 4 ) {
+            // mostly cancels, as in the streams
+            REQUIRE( map.erase( k ) == ref.erase( k ) );
+        } else if ( roll < 8 ) {
+            map[k] = i;
+            ref[k] = i;
+        } else {
+            const auto [it, inserted] = map.emplace( k, i );
+            const auto [ref_it, ref_inserted] = ref.emplace( k, i );
+            REQUIRE( inserted == ref_inserted );
+            REQUIRE( it->second == ref_it->second );
+        }
+        const auto found = map.find( k );
+        REQUIRE( ( found == map.end() ) == ( ref.find( k ) == ref.end() ) );
+        if ( found != map.end() ) {
+            REQUIRE( found->second == ref[k] );
+        }
+        if ( i % 1000 == 0 ) {
+            requireSameEntries( map, ref );
+        }
+    }
+    requireSameEntries( map, ref );
+    for ( int k = 0; k <= keys; k++ ) {
+        REQUIRE( map.count( k ) == ref.count( k ) );
+    }
+}
+
+const std::vector<std::string> Orders {
+    "N 0 1 100 1.5",
+    "N 1 1 100 1.4",
+    "N 2 1 200 1.4",
+    "N 3 0 50 1.3",
+    "N 4 0 100 1.3",
+    "N 5 0 100 1.2",
+    "C 12 0 0 0 4 0 0",
+    "R 6 1 50 1.45 2 1.4 200",
+    "N 7 0 120 1.4",
+    "C 13 0 0 0 7 0 0",
+    "N 8 0 100 1.45",
+};
+
+} // namespace
+
+
+TEST_CASE( "test_FlatHashMap_random", "1" )
+{
+    randomOps<sob::FlatHashMap<int, int>>( 1, 5000 );
+    randomOps<sob::FlatHashMap<int, int>>( 2, 50 );
+    randomOps<sob::FlatHashMap<int, int, SameHome>>( 3, 40 );
+}
+
+TEST_CASE( "test_FlatHashMap_reserve", "1" )
+{
+    sob::FlatHashMap<int, int> map;
+    REQUIRE( map.find( 1 ) == map.end() );
+    REQUIRE( map.erase( 1 ) == 0 );
+
+    map.reserve( 10000 );
+    const size_t capacity = map.capacity();
+    REQUIRE( capacity * sob::FlatHashMap<int, int>::MaxLoadNum >= 10000 * sob::FlatHashMap<int, int>::MaxLoadDen );
+    for ( int k = 0; k < 10000; k++ ) {
+        map[k * 7919] = k;
+    }
+    REQUIRE( map.capacity() == capacity );
+    REQUIRE( map.size() == 10000 );
+
+    // erasing leaves no tombstones, the slots freed are reused as they are
+    for ( int round = 0; round < 10; round++ ) {
+        for ( int k = 0; k < 10000; k += 2 ) {
+            REQUIRE( map.erase( k * 7919 ) == 1 );
+        }
+        for ( int k = 0; k < 10000; k += 2 ) {
+            REQUIRE( map.emplace( k * 7919, k ).second );
+        }
+    }
+    REQUIRE( map.capacity() == capacity );
+    REQUIRE( map[7919 * 42] == 42 );
+
+    auto copy = map;
+    map.clear();
+    REQUIRE( map.empty() );
+    REQUIRE( map.begin() == map.end() );
+    REQUIRE( map.capacity() == capacity );
+    REQUIRE( copy.size() == 10000 );
+
+    auto moved = std::move( copy );
+    REQUIRE( copy.empty() );
+    REQUIRE( copy.find( 0 ) == copy.end() );
+    REQUIRE( moved.find( 7919 * 9999 )->second == 9999 );
+}
+
+TEST_CASE( "test_FlatHashMap_L3Book", "1" )
+{
+    sob::L3Book<boost::circular_buffer> book;
+    book.reserveOrders( 1000 );
+    sob::L3Book<std::list> list_book;
+    for ( const auto& str: Orders ) {
+        sob::Order order{ str };
+        sob::Order list_order{ str };
+        REQUIRE( book.applyOrder( order ) == list_book.applyOrder( list_order ) );
+        REQUIRE( book.toString() == list_book.toString() );
+    }
+    REQUIRE( !book.queryOrderId( 4 ) );
+    REQUIRE( !book.queryOrderId( 7 ) );
+    REQUIRE( ( *book.queryOrderId( 0 ) )->size == 100 );
+
+    auto copy = book;
+    REQUIRE( copy.toString() == book.toString() );
+    REQUIRE( ( *copy.queryOrderId( 0 ) )->size == 100 );
+}
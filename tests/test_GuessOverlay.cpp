@@ -0,0 +1,281 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <spdlog/spdlog.h>
+#include <Order.h>
+#include <OrderBook.h>
+#include <L3OrderBook.h>
+#include <GuessOverlay.h>
+#include <SmartOrderBook.h>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <random>
+
+namespace {
+
+// asks 1.5: 100, 1.4: 300, bids 1.3: 150, 1.2: 100
+sob::L3Book<> makeBook()
+{
+    std::vector<sob::Order> orders{ sob::Order{ "N 0 1 100 1.5" }, sob::Order{ "N 1 1 100 1.4" },
+                                    sob::Order{ "N 2 1 200 1.4" }, sob::Order{ "N 3 0 50 1.3" },
+                                    sob::Order{ "N 4 0 100 1.3" }, sob::Order{ "N 5 0 100 1.2" } };
+    return sob::L3Book<>{ orders };
+}
+
+} // namespace
+
+
+TEST_CASE("test_GuessOverlay_empty", "1")
+{
+    const auto book = makeBook();
+    sob::GuessOverlay<sob::L3Book<>> guess{ book };
+
+    REQUIRE( guess.empty() );
+    REQUIRE( guess.toString() == book.toString() );
+    REQUIRE( guess.agg() == book.agg() );
+    REQUIRE( guess.getBestBid() == book.getBestBid() );
+    REQUIRE( guess.getBestAsk() == book.getBestAsk() );
+    REQUIRE( guess.getBidSideSize() == book.getBidSideSize() );
+    REQUIRE( guess.getAskQuantity( sob::Price{ 1.4 } ) == 300 );
+}
+
+TEST_CASE("test_GuessOverlay_guessOrder", "1")
+{
+    auto book = makeBook();
+    sob::GuessOverlay<sob::L3Book<>> guess{ book };
+
+    // rests
+    guess.guessOrder( false, 40, sob::Price{ 1.35 } );
+    REQUIRE( guess.getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.35 }, 40 } );
+    REQUIRE( guess.getBidSideSize() == book.getBidSideSize() + 40 );
+
+    // takes the whole of 1.4 and part of 1.5, nothing left to rest
+    guess.guessOrder( false, 350, sob::Price{ 1.5 } );
+    REQUIRE( guess.getAskQuantity( sob::Price{ 1.4 } ) == 0 );
+    REQUIRE( guess.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.5 }, 50 } );
+    REQUIRE( guess.agg().getAskSideDepth() == 1 );
+    REQUIRE( guess.numGuessedLevels() == 3 );
+
+    // the book itself is untouched, and what it is updated with shows through
+    REQUIRE( book.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 300 } );
+    sob::Order order{ "N 6 0 20 1.3" };
+    book.applyOrder( order );
+    REQUIRE( guess.getBidQuantity( sob::Price{ 1.3 } ) == 170 );
+
+    // crosses through the guessed bid and rests the rest on the ask side
+    guess.guessOrder( true, 60, sob::Price{ 1.35 } );
+    REQUIRE( guess.getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.3 }, 170 } );
+    REQUIRE( guess.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.35 }, 20 } );
+
+    guess.clear();
+    REQUIRE( guess.empty() );
+    REQUIRE( guess.toString() == book.toString() );
+    REQUIRE( guess.agg() == book.agg() );
+}
+
+TEST_CASE("test_GuessOverlay_snapshot", "1")
+{
+    const auto book = makeBook();
+    sob::GuessOverlay<sob::L3Book<>> guess{ book };
+
+    // 1.35 has come and 1.3 has gone, the levels deeper than the snapshot goes are left as they are
+    sob::L2Book snapshot{ "S 2 1 1.35 80 1.2 100 1.4 250" };
+    guess.applySnapShot( snapshot );
+    REQUIRE( guess.getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.35 }, 80 } );
+    REQUIRE( guess.getBidQuantity( sob::Price{ 1.3 } ) == 0 );
+    REQUIRE( guess.getBidQuantity( sob::Price{ 1.2 } ) == 100 );
+    REQUIRE( guess.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 250 } );
+    REQUIRE( guess.getAskQuantity( sob::Price{ 1.5 } ) == 100 );
+    REQUIRE( guess.getBidSideSize() == 180 );
+
+    // the next snapshot replaces what the one before implied
+    sob::L2Book next{ "S 1 1 1.3 150 1.4 300" };
+    guess.applySnapShot( next );
+    REQUIRE( guess.empty() );
+    REQUIRE( guess.toString() == book.toString() );
+}
+
+TEST_CASE("test_GuessOverlay_rollbackGuesses", "1")
+{
+    auto book = makeBook();
+    sob::GuessOverlay<sob::L3Book<>> guess{ book };
+
+    // takes the whole of 1.4 and 50 of 1.5
+    guess.guessOrder( false, 350, sob::Price{ 1.5 } );
+    REQUIRE( guess.numGuessSteps() == 2 );
+
+    // 1.3 goes and 1.35 comes, 1.4 is brought to 250 and 1.5, beyond the snapshot, back to the book's
+    sob::L2Book snapshot{ "S 2 1 1.35 80 1.2 100 1.4 250" };
+    guess.applySnapShot( snapshot );
+    REQUIRE( guess.numGuessSteps() == 6 );
+    REQUIRE( guess.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 250 } );
+    REQUIRE( guess.getAskQuantity( sob::Price{ 1.5 } ) == 100 );
+
+    // the same snapshot again changes nothing
+    guess.applySnapShot( snapshot );
+    REQUIRE( guess.numGuessSteps() == 6 );
+
+    // the order the snapshot showed at 1.35 arrives
+    sob::Order order{ "N 6 0 80 1.35" };
+    guess.mark();
+    book.applyOrder( order );
+    guess.reconcile();
+    REQUIRE( guess.getBidQuantity( sob::Price{ 1.35 } ) == 80 );
+    REQUIRE( guess.numGuessedLevels() == 2 );
+    REQUIRE( guess.numGuessSteps() == 7 );
+
+    guess.rollbackGuesses();
+    REQUIRE( guess.empty() );
+    REQUIRE( guess.numGuessSteps() == 0 );
+    REQUIRE( guess.toString() == book.toString() );
+    REQUIRE( guess.agg() == book.agg() );
+}
+
+TEST_CASE("test_GuessOverlay_rollbackGuesses_random", "1")
+{
+    auto book = makeBook();
+    sob::GuessOverlay<sob::L3Book<>> guess{ book };
+    std::mt19937 rng{ 7 };
+    const auto px = [&rng]() { return sob::Price{ 1.0 + 0.05 * static_cast<int>( rng() % 12 ) }; };
+    const auto size = [&rng]() { return 1 + static_cast<int>( rng() % 300 ); };
+
+    int id = 100;
+    for ( int round = 0; round < 20; round++ ) {
+        for ( int i = 0; i < 50; i++ ) {
+            switch ( rng() % 3 ) {
+                case 0:
+                    guess.guessOrder( rng() % 2 == 0, size(), px() );
+                    break;
+                case 1: {
+                    sob::OneSideBook<sob::L2PriceLevel, sob::BidComparator> bids;
+                    sob::OneSideBook<sob::L2PriceLevel, sob::AskComparator> asks;
+                    for ( int lvl = static_cast<int>( rng() % 4 ); lvl > 0; lvl-- ) {
+                        const auto bid = px();
+                        bids[bid] = sob::L2PriceLevel{ bid, size() };
+                        const auto ask = px();
+                        asks[ask] = sob::L2PriceLevel{ ask, size() };
+                    }
+                    sob::L2Book snapshot{ bids, asks };
+                    guess.applySnapShot( snapshot );
+                    break;
+                }
+                default: {
+                    sob::Order order( id++, rng() % 2 == 0, size(), px() );
+                    guess.mark();
+                    book.applyOrder( order );
+                    guess.reconcile();
+                }
+            }
+        }
+        // no level is guessed below nothing, the side sizes add up
+        auto guessed = guess.agg();
+        size_t bid_size = 0;
+        for ( const auto& [bid, lvl]: guessed.getBidSide() ) {
+            bid_size += lvl.quantity;
+        }
+        REQUIRE( guess.getBidSideSize() == bid_size );
+
+        guess.rollbackGuesses();
+        REQUIRE( guess.empty() );
+        REQUIRE( guess.numGuessSteps() == 0 );
+        REQUIRE( guess.getBidSideSize() == book.getBidSideSize() );
+        REQUIRE( guess.getAskSideSize() == book.getAskSideSize() );
+        REQUIRE( guess.agg() == book.agg() );
+    }
+}
+
+TEST_CASE("test_GuessOverlay_L3Book", "1")
+{
+    // the book applies to itself what the overlay keeps apart
+    const auto book = makeBook();
+    sob::GuessOverlay<sob::L3Book<>> guess{ book };
+    auto guessed = makeBook();
+
+    for ( const auto* msg: { "T 0 1.4 50", "T 0 1.4 300", "T 1 1.3 20", "T 0 1.4 200 1.5 50" } ) {
+        sob::Trade trade{ std::string{ msg } };
+        guess.applyTrade( trade );
+        guessed.applyTrade( trade );
+        REQUIRE( guessed.agg() == guess.agg() );
+    }
+    // its orders are of its own making
+    REQUIRE( guessed.bestBidView().front().orderId < 0 );
+
+    sob::GuessOverlay<sob::L3Book<>> snap_guess{ book };
+    auto snapped = makeBook();
+    sob::L2Book snapshot{ "S 2 1 1.35 80 1.2 100 1.4 250" };
+    snap_guess.applySnapShot( snapshot );
+    snapped.applySnapShot( snapshot );
+    REQUIRE( snapped.agg() == snap_guess.agg() );
+    REQUIRE( snapped.bestBidView().front().orderId < 0 );
+}
+
+TEST_CASE("test_GuessOverlay_SmartOrderBook", "1")
+{
+    sob::SmartOrderBook sob;
+    for ( const std::string_view msg: { "N 0 1 100 1.5", "S 0 1 1.5 100", "N 1 1 100 1.4", "S 0 2 1.4 100 1.5 100",
+                             "N 2 1 200 1.4", "S 0 2 1.4 300 1.5 100", "N 3 0 50 1.3", "S 1 2 1.3 50 1.4 300 1.5 100",
+                             "N 4 0 100 1.3", "S 1 2 1.3 150 1.4 300 1.5 100",
+                             "N 5 0 100 1.2", "S 2 2 1.2 100 1.3 150 1.4 300 1.5 100" } ) {
+        sob.applyMessage( msg );
+    }
+    REQUIRE( sob.getLeaderView().empty() );
+    REQUIRE( sob.getLeaderBook() == sob.getGroundTruth() );
+
+    // the trades lead, the last one through two levels
+    sob.applyMessage( std::string_view{ "T 0 1.4 50" } );
+    sob.applyMessage( std::string_view{ "T 0 1.4 50" } );
+    sob.applyMessage( std::string_view{ "T 0 1.4 200 1.5 50" } );
+
+    const auto& leader = sob.getLeaderView();
+    REQUIRE( leader.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.5 }, 50 } );
+    REQUIRE( leader.getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 500 } );
+    REQUIRE( sob.getGroundTruth()->getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 300 } );
+
+    // the same, as an L3Book
+    const auto copy = sob.getLeaderBook();
+    REQUIRE( copy != sob.getGroundTruth() );
+    REQUIRE( copy->agg() == leader.agg() );
+
+    // the orders catch up, the guess goes
+    for ( const std::string_view msg: { "N 6 0 50 1.4", "S 2 2 1.2 100 1.3 150 1.4 250 1.5 100" } ) {
+        sob.applyMessage( msg );
+    }
+    REQUIRE( sob.getLeaderView().empty() );
+    REQUIRE( sob.getLeaderBook()->toString() == sob.getGroundTruth()->toString() );
+}
+
+TEST_CASE("test_GuessOverlay_SmartOrderBook_lead", "1")
+{
+    sob::SmartOrderBook sob;
+    for ( const std::string_view msg: { "N 0 1 100 1.5", "S 0 1 1.5 100", "N 1 1 300 1.4", "S 0 2 1.4 300 1.5 100",
+                                        "N 2 0 100 1.2", "S 1 2 1.2 100 1.4 300 1.5 100" } ) {
+        sob.applyMessage( msg );
+    }
+    REQUIRE( sob.getLeaderView().empty() );
+
+    // two snapshots ahead of the orders: 100 more at 1.4, then 50 bid at 1.3
+    sob.applyMessage( std::string_view{ "S 1 2 1.2 100 1.4 400 1.5 100" } );
+    sob.applyMessage( std::string_view{ "S 2 2 1.2 100 1.3 50 1.4 400 1.5 100" } );
+    REQUIRE( sob.getLeaderView().getAskQuantity( sob::Price{ 1.4 } ) == 400 );
+    REQUIRE( sob.getLeaderView().getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.3 }, 50 } );
+
+    // the first of the orders they show arrives, the second is still to come: 1.4 is not counted twice
+    sob.applyMessage( std::string_view{ "N 3 1 100 1.4" } );
+    const auto& leader = sob.getLeaderView();
+    REQUIRE( !leader.empty() );
+    REQUIRE( sob.getGroundTruth()->getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 400 } );
+    REQUIRE( leader.getBestAsk() == sob::L2PriceLevel{ sob::Price{ 1.4 }, 400 } );
+    REQUIRE( leader.getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.3 }, 50 } );
+    REQUIRE( leader.getAskSideSize() == 500 );
+    REQUIRE( leader.numGuessedLevels() == 1 );
+    const auto copy = sob.getLeaderBook();
+    REQUIRE( copy->agg() == leader.agg() );
+    REQUIRE( copy->getBestBid() == sob::L2PriceLevel{ sob::Price{ 1.3 }, 50 } );
+    REQUIRE( copy->getAskSideSize() == 500 );
+
+    // and the second, the orders have caught up
+    sob.applyMessage( std::string_view{ "N 4 0 50 1.3" } );
+    REQUIRE( sob.getLeaderView().empty() );
+    REQUIRE( sob.getLeaderBook() == sob.getGroundTruth() );
+    REQUIRE( sob.getGroundTruth()->agg() == copy->agg() );
+}
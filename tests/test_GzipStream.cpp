@@ -0,0 +1,118 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <GzipStream.h>
+#include <MappedFile.h>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+
+namespace {
+
+std::string writeGzFile( const std::string& name, const std::string& content )
+{
+    const std::string path = "/tmp/sob_test_" + name;
+    std::ofstream file{ path, std::ios::binary };
+    boost::iostreams::filtering_ostream out;
+    out.push( boost::iostreams::gzip_compressor{} );
+    out.push( file );
+    out << content;
+    return path;
+}
+
+template <typename Reader>
+std::vector<std::vector<std::string>> readAllFields( Reader& reader )
+{
+    std::vector<std::vector<std::string>> res;
+    sob::TokenBatch batch;
+    while ( reader.next( batch ) ) {
+        for ( size_t i = 0; i < batch.lines(); i++ ) {
+            auto cur = batch.cursor( i );
+            auto& fields = res.emplace_back();
+            while ( !cur.atEnd() ) {
+                fields.emplace_back( cur.next() );
+            }
+        }
+    }
+    return res;
+}
+
+} // namespace
+
+
+TEST_CASE( "test_GzipTokenReader", "1" )
+{
+    std::string content;
+    for ( int i = 0; i < 2000; i++ ) {
+        content += "N " + std::to_string( i ) + " 1 100 1.5\n";
+        if ( i % 100 == 0 ) {
+            content += "T 0";                       // lines much longer than the blocks
+            for ( int j = 0; j < 20; j++ ) {
+                content += " 1.5 " + std::to_string( j );
+            }
+            content += "\r\n\n";
+        }
+    }
+    content += "S 0 1 1.5 100";                     // no trailing newline
+
+    const std::string plain_path = "/tmp/sob_test_plain.stream";
+    std::ofstream{ plain_path, std::ios::binary } << content;
+    sob::MappedFile plain{ plain_path };
+    sob::TokenReader plain_reader{ plain };
+    const auto expected = readAllFields( plain_reader );
+    REQUIRE( expected.size() == 2000 + 20 * 2 + 1 );
+
+    const auto gz_path = writeGzFile( "gz.stream.gz", content );
+    REQUIRE( sob::isGzipStream( sob::MappedFile{ gz_path }.view() ) );
+    REQUIRE_FALSE( sob::isGzipStream( plain.view() ) );
+
+    for ( const size_t block_size : { size_t{ 16 }, size_t{ 1000 }, sob::GzipTokenReader::DefaultBlockSize } ) {
+        sob::GzipTokenReader reader{ gz_path, 7, sob::BestSimdLevel, block_size, 2 };
+        REQUIRE( readAllFields( reader ) == expected );
+    }
+
+    std::remove( plain_path.c_str() );
+    std::remove( gz_path.c_str() );
+}
+
+TEST_CASE( "test_GzipTokenReader_errors", "1" )
+{
+    REQUIRE_THROWS( sob::GzipTokenReader{ "/tmp/sob_test_does_not_exist.stream.gz" } );
+
+    // truncated in the middle of the deflate stream
+    std::string content;
+    for ( int i = 0; i < 5000; i++ ) {
+        content += "N " + std::to_string( i ) + " 0 " + std::to_string( i * 7 ) + " 1.25\n";
+    }
+    const auto path = writeGzFile( "corrupt.stream.gz", content );
+    std::string gz;
+    {
+        sob::MappedFile file{ path };
+        gz = std::string( file.view().substr( 0, file.size() / 2 ) );
+    }
+    std::ofstream{ path, std::ios::binary | std::ios::trunc } << gz;
+
+    sob::GzipTokenReader reader{ path, 1024, sob::BestSimdLevel, 64, 2 };
+    REQUIRE_THROWS( readAllFields( reader ) );
+    std::remove( path.c_str() );
+}
+
+TEST_CASE( "test_GzipTokenReader_early_exit", "1" )
+{
+    std::string content;
+    for ( int i = 0; i < 5000; i++ ) {
+        content += "N " + std::to_string( i ) + " 0 100 1.5\n";
+    }
+    const auto path = writeGzFile( "early.stream.gz", content );
+    {
+        // the inflater is blocked on the full ring when the reader goes away
+        sob::GzipTokenReader reader{ path, 1, sob::BestSimdLevel, 16, 1 };
+        sob::TokenBatch batch;
+        REQUIRE( reader.next( batch ) );
+        REQUIRE( batch.line( 0 ) == "N 0 0 100 1.5" );
+    }
+    std::remove( path.c_str() );
+}
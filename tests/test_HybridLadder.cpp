@@ -0,0 +1,171 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <HybridLadder.h>
+#include <L3OrderBook.h>
+#include <map>
+#include <random>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+template <typename Comparator>
+using Hybrid = sob::HybridLadder<int, Comparator>;
+
+template <typename Comparator>
+void requireSameLevels( const Hybrid<Comparator>& ladder, const std::map<sob::Price, int, Comparator>& ref )
+{
+    REQUIRE( ladder.size() == ref.size() );
+    auto it = ladder.begin();
+    for ( const auto& [px, lvl]: ref ) {
+        REQUIRE( it != ladder.end() );
+        REQUIRE( it->first == px );
+        REQUIRE( it->second == lvl );
+        ++it;
+    }
+    REQUIRE( it == ladder.end() );
+
+    auto rit = ladder.rbegin();
+    for ( auto ref_rit = ref.rbegin(); ref_rit != ref.rend(); ++ref_rit, ++rit ) {
+        REQUIRE( rit->first == ref_rit->first );
+    }
+    REQUIRE( rit == ladder.rend() );
+}
+
+// a walking mid with most levels close to it and some far away, behind the touch
+template <typename Comparator>
+void randomOps( const unsigned seed, const int64_t behind )
+{
+    std::mt19937 gen{ seed };
+    std::uniform_int_distribution<int64_t> drift{ -3, 3 };
+    std::uniform_int_distribution<int64_t> near{ -40, 40 };
+    std::uniform_int_distribution<int64_t> far{ 2000, 20000 };
+    std::uniform_int_distribution<int> op{ 0, 19 };
+
+    Hybrid<Comparator> ladder;
+    std::map<sob::Price, int, Comparator> ref;
+    int64_t mid = 0;
+    for ( int i = 0; i < 20000; i++ ) {
+        mid += drift( gen );
+        const int roll = op( gen );
+        const auto px = sob::Price::fromTicks( mid + ( roll == 8 ? behind * far( gen ) : near( gen ) ) );
+        if ( roll < 6 ) {
+            REQUIRE( ladder.erase( px ) == ref.erase( px ) );
+        } else if ( roll < 8 && !ref.empty() ) {
+            // the best level goes, as when a level is consumed
+            const auto next = ladder.erase( ladder.begin() );
+            const auto ref_next = ref.erase( ref.begin() );
+            REQUIRE( ( next == ladder.end() ) == ( ref_next == ref.end() ) );
+            if ( ref_next != ref.end() ) {
+                REQUIRE( next->first == ref_next->first );
+            }
+        } else {
+            ladder[px] += i;
+            ref[px] += i;
+        }
+        REQUIRE( ( ladder.find( px ) == ladder.end() ) == ( ref.find( px ) == ref.end() ) );
+        if ( !ref.empty() ) {
+            REQUIRE( ladder.begin()->first == ref.begin()->first );
+        }
+        if ( i % 1000 == 0 ) {
+            requireSameLevels( ladder, ref );
+        }
+    }
+    requireSameLevels( ladder, ref );
+    REQUIRE( ladder.tailSize() > 0 );
+    REQUIRE( ladder.windowTicks() < Hybrid<Comparator>::MaxWindowTicks );
+}
+
+const std::vector<std::string> Orders {
+    "N 0 1 100 1.5",
+    "N 1 1 100 1.4",
+    "N 2 1 200 1.4",
+    "N 3 0 50 1.3",
+    "N 4 0 100 1.3",
+    "N 5 0 100 1.2",
+    "N 6 0 50 1.4",
+    "C 12 0 0 0 2 0 0",
+    "R 7 1 50 1.45 1 1.4 50",
+    "N 8 1 300 1.25",
+    "N 9 0 20 0.01",
+    "N 10 1 30 250.0",
+    "C 13 0 0 0 9 0 0",
+    "N 11 0 400 1.6",
+};
+
+} // namespace
+
+
+TEST_CASE( "test_HybridLadder_order", "1" )
+{
+    randomOps<sob::AskComparator>( 1, 1 );
+    randomOps<sob::BidComparator>( 2, -1 );
+}
+
+TEST_CASE( "test_HybridLadder_migrate", "1" )
+{
+    Hybrid<sob::BidComparator> bids;
+    for ( int64_t tick = 1000; tick < 1010; tick++ ) {
+        bids[sob::Price::fromTicks( tick )] = static_cast<int>( tick );
+    }
+    int& far = bids[sob::Price::fromTicks( 100 )];
+    far = 100;
+    REQUIRE( bids.tailSize() == 1 );
+    REQUIRE( bids.begin()->first == sob::Price::fromTicks( 1009 ) );
+
+    // the market sells off, the touch walks down to the far level which comes into the window
+    for ( int64_t tick = 1009; tick >= 1000; tick-- ) {
+        bids.erase( bids.begin() );
+    }
+    REQUIRE( bids.size() == 1 );
+    REQUIRE( bids.tailSize() == 0 );
+    REQUIRE( &far == &bids.at( sob::Price::fromTicks( 100 ) ) );
+
+    // a rally, the old level drops into the tail and is still the same level
+    bids[sob::Price::fromTicks( 5000 )] = 5000;
+    REQUIRE( bids.tailSize() == 1 );
+    REQUIRE( &far == &bids.at( sob::Price::fromTicks( 100 ) ) );
+    REQUIRE( std::prev( bids.end() )->second == 100 );
+
+    auto copy = bids;
+    bids.clear();
+    REQUIRE( bids.empty() );
+    REQUIRE( bids.begin() == bids.end() );
+    REQUIRE( copy.size() == 2 );
+    REQUIRE( copy.at( sob::Price::fromTicks( 100 ) ) == 100 );
+    REQUIRE_THROWS_AS( copy.at( sob::Price::fromTicks( 101 ) ), std::out_of_range );
+}
+
+TEST_CASE( "test_HybridLadder_adapt", "1" )
+{
+    // levels spread over ~1000 ticks widen the window so that most of them sit in the array
+    Hybrid<sob::AskComparator> asks;
+    std::mt19937 gen{ 3 };
+    std::uniform_int_distribution<int64_t> spread{ 0, 1000 };
+    for ( int i = 0; i < 4096; i++ ) {
+        asks[sob::Price::fromTicks( 10000 + spread( gen ) )]++;
+    }
+    REQUIRE( asks.windowTicks() >= 1024 );
+    REQUIRE( asks.tailSize() * 10 < asks.size() );
+
+    // a tight book keeps it narrow
+    Hybrid<sob::AskComparator> tight;
+    for ( int i = 0; i < 4096; i++ ) {
+        tight[sob::Price::fromTicks( 10000 + i % 8 )]++;
+    }
+    REQUIRE( tight.windowTicks() == Hybrid<sob::AskComparator>::MinWindowTicks );
+}
+
+TEST_CASE( "test_HybridLadder_L3Book", "1" )
+{
+    sob::L3Book<boost::circular_buffer> map_book;
+    sob::L3Book<boost::circular_buffer, sob::HybridSide> hybrid_book;
+    for ( const auto& str: Orders ) {
+        sob::Order map_order{ str };
+        sob::Order hybrid_order{ str };
+        REQUIRE( map_book.applyOrder( map_order ) == hybrid_book.applyOrder( hybrid_order ) );
+        REQUIRE( hybrid_book.toString() == map_book.toString() );
+        REQUIRE( hybrid_book.agg() == map_book.agg() );
+    }
+}
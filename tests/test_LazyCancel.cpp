@@ -0,0 +1,135 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <L3OrderBook.h>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+std::string newOrder( const int id, const bool is_sell, const int size, const int tick )
+{
+    return "N " + std::to_string( id ) + ( is_sell ? " 1 " : " 0 " ) + std::to_string( size )
+         + " " + std::to_string( 1.0 + 0.01 * tick );
+}
+
+std::string cancelOrder( const int id, const int old_id )
+{
+    return "C " + std::to_string( id ) + " 0 0 0 " + std::to_string( old_id ) + " 0 0";
+}
+
+template <typename Book, typename ListBook>
+void apply( Book& book, ListBook& list_book, const std::string& str )
+{
+    sob::Order order{ str };
+    sob::Order list_order{ str };
+    REQUIRE( book.applyOrder( order ) == list_book.applyOrder( list_order ) );
+}
+
+} // namespace
+
+
+TEST_CASE( "test_LazyCancel_random", "1" )
+{
+    // cancels anywhere in the queues, a circular_buffer book has to stay the same as a list book
+    std::mt19937 gen{ 11 };
+    std::uniform_int_distribution<int> op{ 0, 9 };
+    std::uniform_int_distribution<int> tick{ -5, 5 };
+    std::uniform_int_distribution<int> size{ 1, 40 };
+
+    sob::L3Book<boost::circular_buffer> book;
+    sob::L3Book<std::list> list_book;
+    int id = 0;
+    for ( int i = 0; i < 5000; i++ ) {
+        if ( op( gen ) < 5 || id == 0 ) {
+            const int t = tick( gen );
+            // mostly resting, bids below 1.0 and asks above, now and then one crossing
+            const bool is_sell = op( gen ) < 5;
+            const int px = is_sell ? std::abs( t ) + ( op( gen ) == 0 ? -3 : 0 ) : -std::abs( t ) + ( op( gen ) == 0 ? 3 : 0 );
+            apply( book, list_book, newOrder( id, is_sell, size( gen ), px ) );
+        } else {
+            const int old_id = std::uniform_int_distribution<int>{ 0, id - 1 }( gen );
+            apply( book, list_book, cancelOrder( id, old_id ) );
+        }
+        id++;
+        if ( i % 50 == 0 ) {
+            REQUIRE( book.toString() == list_book.toString() );
+            REQUIRE( book.agg() == list_book.agg() );
+        }
+    }
+    REQUIRE( book.toString() == list_book.toString() );
+    for ( int old_id = 0; old_id < id; old_id++ ) {
+        const auto found = book.queryOrderId( old_id );
+        const auto list_found = list_book.queryOrderId( old_id );
+        REQUIRE( bool( found ) == bool( list_found ) );
+        if ( found ) {
+            REQUIRE( ( *found )->orderId == old_id );
+            REQUIRE( ( *found )->size == ( *list_found )->size );
+        }
+    }
+
+    auto copy = book;
+    REQUIRE( copy.toString() == book.toString() );
+    book.compact();
+    REQUIRE( book.toString() == copy.toString() );
+    for ( int old_id = 0; old_id < id; old_id++ ) {
+        if ( const auto found = book.queryOrderId( old_id ) ) {
+            REQUIRE( ( *found )->orderId == old_id );
+        }
+    }
+}
+
+TEST_CASE( "test_LazyCancel_compaction", "1" )
+{
+    sob::L3Book<boost::circular_buffer> book;
+    sob::L3Book<std::list> list_book;
+    for ( int id = 0; id < 10; id++ ) {
+        apply( book, list_book, newOrder( id, true, 10, 5 ) );
+    }
+    const auto& level = book.getAskSide().begin()->second;
+
+    // in the middle: marked dead, the quantity drops at once
+    apply( book, list_book, cancelOrder( 100, 3 ) );
+    apply( book, list_book, cancelOrder( 101, 5 ) );
+    REQUIRE( level.numDead == 2 );
+    REQUIRE( level.numOrders == 8 );
+    REQUIRE( level.quantity == 80 );
+    REQUIRE( level.orders.size() == 10 );
+    REQUIRE( book.toString() == list_book.toString() );
+
+    // the front goes, and the dead orders reaching it with it
+    apply( book, list_book, cancelOrder( 102, 4 ) );
+    apply( book, list_book, cancelOrder( 103, 0 ) );
+    apply( book, list_book, cancelOrder( 104, 1 ) );
+    apply( book, list_book, cancelOrder( 105, 2 ) );
+    REQUIRE( level.numDead == 0 );
+    REQUIRE( level.orders.size() == 4 );
+    REQUIRE( level.orders.front().orderId == 6 );
+
+    // a match fills from the first live order
+    for ( int id = 10; id < 14; id++ ) {
+        apply( book, list_book, newOrder( id, true, 10, 5 ) );
+    }
+    apply( book, list_book, cancelOrder( 106, 6 ) );
+    apply( book, list_book, cancelOrder( 107, 8 ) );
+    apply( book, list_book, cancelOrder( 108, 10 ) );
+    REQUIRE( level.numDead == 2 );
+    apply( book, list_book, newOrder( 20, false, 15, 5 ) );
+    REQUIRE( book.toString() == list_book.toString() );
+    REQUIRE( !book.queryOrderId( 7 ) );
+    REQUIRE( ( *book.queryOrderId( 9 ) )->size == 5 );
+
+    // past half of the orders held dead, the level compacts itself
+    apply( book, list_book, cancelOrder( 109, 11 ) );
+    apply( book, list_book, cancelOrder( 110, 12 ) );
+    REQUIRE( level.numDead == 0 );
+    REQUIRE( level.orders.size() == static_cast<size_t>( level.numOrders ) );
+    REQUIRE( book.toString() == list_book.toString() );
+    REQUIRE( ( *book.queryOrderId( 13 ) )->orderId == 13 );
+    apply( book, list_book, cancelOrder( 111, 13 ) );
+    apply( book, list_book, cancelOrder( 112, 9 ) );
+    REQUIRE( level.numOrders == 0 );
+    REQUIRE( book.toString() == list_book.toString() );
+}
@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <OrderQueue.h>
+#include <L3OrderBook.h>
+#include <list>
+#include <random>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+const std::vector<std::string> Orders {
+    "N 0 1 100 1.5",
+    "N 1 1 100 1.4",
+    "N 2 1 200 1.4",
+    "N 3 1 150 1.4",
+    "N 4 1 250 1.4",
+    "N 5 1 50 1.4",
+    "N 6 0 50 1.3",
+    "N 7 0 100 1.3",
+    "N 8 0 100 1.2",
+    "C 20 0 0 0 1 0 0",         // the front of a level goes
+    "R 9 1 60 1.45 3 1.4 150",  // then one further in, the handles left have to hold
+    "C 21 0 0 0 7 0 0",
+    "N 10 0 120 1.4",           // eats into the level from the front
+    "N 11 1 30 1.4",
+    "C 22 0 0 0 5 0 0",
+    "N 12 0 400 1.6",
+};
+
+} // namespace
+
+
+TEST_CASE( "test_OrderQueue_handles", "1" )
+{
+    std::mt19937 gen{ 5 };
+    std::uniform_int_distribution<int> op{ 0, 3 };
+
+    sob::OrderQueue<int> queue;
+    std::list<int> ref;
+    std::vector<sob::OrderQueue<int>::iterator> handles;
+    std::vector<std::list<int>::iterator> ref_handles;
+    for ( int i = 0; i < 5000; i++ ) {
+        const int roll = op( gen );
+        if ( roll == 0 && !handles.empty() ) {
+            // anywhere in the queue
+            const size_t idx = gen() % handles.size();
+            queue.erase( handles[idx] );
+            ref.erase( ref_handles[idx] );
+            handles[idx] = handles.back();
+            ref_handles[idx] = ref_handles.back();
+            handles.pop_back();
+            ref_handles.pop_back();
+        } else if ( roll == 1 && !ref.empty() ) {
+            const int front = ref.front();
+            REQUIRE( queue.front() == front );
+            queue.pop_front();
+            ref.pop_front();
+            for ( size_t idx = 0; idx < handles.size(); idx++ ) {
+                if ( *ref_handles[idx] == front ) {
+                    handles[idx] = handles.back();
+                    ref_handles[idx] = ref_handles.back();
+                    handles.pop_back();
+                    ref_handles.pop_back();
+                    break;
+                }
+            }
+        } else {
+            handles.push_back( queue.emplace_back( i ) );
+            ref_handles.push_back( ref.insert( ref.end(), i ) );
+        }
+
+        REQUIRE( queue.size() == ref.size() );
+        for ( size_t idx = 0; idx < handles.size(); idx++ ) {
+            REQUIRE( *handles[idx] == *ref_handles[idx] );
+        }
+    }
+    REQUIRE( std::equal( queue.begin(), queue.end(), ref.begin(), ref.end() ) );
+    REQUIRE( std::equal( std::make_reverse_iterator( queue.end() ), std::make_reverse_iterator( queue.begin() ),
+                         ref.rbegin(), ref.rend() ) );
+
+    // moving hands the nodes over, the handles follow
+    const auto front = queue.begin();
+    auto moved = std::move( queue );
+    REQUIRE( queue.empty() );
+    REQUIRE( moved.begin() == front );
+
+    // erased nodes are reused before any new slab
+    const size_t capacity = moved.capacity();
+    const size_t size = moved.size();
+    moved.clear();
+    for ( size_t i = 0; i < size; i++ ) {
+        moved.push_front( static_cast<int>( i ) );
+    }
+    REQUIRE( moved.capacity() == capacity );
+    REQUIRE( moved.front() == static_cast<int>( size ) - 1 );
+
+    auto copy = moved;
+    REQUIRE( std::equal( copy.begin(), copy.end(), moved.begin(), moved.end() ) );
+}
+
+TEST_CASE( "test_OrderQueue_L3Book", "1" )
+{
+    sob::L3Book<std::list> list_book;
+    sob::L3Book<sob::OrderQueue> queue_book;
+    for ( const auto& str: Orders ) {
+        sob::Order list_order{ str };
+        sob::Order queue_order{ str };
+        REQUIRE( list_book.applyOrder( list_order ) == queue_book.applyOrder( queue_order ) );
+        REQUIRE( queue_book.toString() == list_book.toString() );
+        REQUIRE( queue_book.agg() == list_book.agg() );
+    }
+    REQUIRE( !queue_book.queryOrderId( 4 ) );
+    REQUIRE( queue_book.queryOrderId( 0 ) );
+    REQUIRE( ( *queue_book.queryOrderId( 0 ) )->size == 100 );
+
+    // the copy's handles point at its own orders
+    sob::L3Book<sob::OrderQueue> copy;
+    copy = queue_book;
+    sob::Order cancel{ "C 23 0 0 0 0 0 0" };
+    REQUIRE( copy.applyOrder( cancel ).second );
+    REQUIRE( copy.getAskSideSize() + 100 == queue_book.getAskSideSize() );
+    REQUIRE( queue_book.toString() == list_book.toString() );
+    REQUIRE( ( *queue_book.queryOrderId( 0 ) )->size == 100 );
+    REQUIRE( !copy.queryOrderId( 0 ) );
+}
@@ -0,0 +1,158 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <SegmentedRing.h>
+#include <L3OrderBook.h>
+#include <deque>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+template <typename Ring>
+void requireSame( const Ring& ring, const std::deque<int>& ref )
+{
+    REQUIRE( ring.size() == ref.size() );
+    REQUIRE( std::equal( ring.begin(), ring.end(), ref.begin(), ref.end() ) );
+    if ( !ref.empty() ) {
+        REQUIRE( ring.front() == ref.front() );
+        REQUIRE( ring.back() == ref.back() );
+    }
+}
+
+template <typename Ring>
+void requireLikeDeque()
+{
+    std::mt19937 gen{ 7 };
+    std::uniform_int_distribution<int> op{ 0, 9 };
+
+    Ring ring;
+    std::deque<int> ref;
+    for ( int i = 0; i < 20000; i++ ) {
+        const int roll = op( gen );
+        if ( roll < 3 ) {
+            ring.push_back( i );
+            ref.push_back( i );
+        } else if ( roll < 5 ) {
+            ring.push_front( i );
+            ref.push_front( i );
+        } else if ( ref.empty() ) {
+            continue;
+        } else if ( roll < 7 ) {
+            ring.pop_front();
+            ref.pop_front();
+        } else if ( roll < 8 ) {
+            ring.pop_back();
+            ref.pop_back();
+        } else {
+            const auto pos = std::uniform_int_distribution<size_t>{ 0, ref.size() - 1 }( gen );
+            ring.erase( std::next( ring.cbegin(), pos ) );
+            ref.erase( ref.begin() + pos );
+        }
+        if ( i % 500 == 0 ) {
+            requireSame( ring, ref );
+        }
+    }
+    requireSame( ring, ref );
+
+    auto copy = ring;
+    requireSame( copy, ref );
+    ring.clear();
+    REQUIRE( ring.empty() );
+    REQUIRE( ring.begin() == ring.end() );
+    auto moved = std::move( copy );
+    REQUIRE( copy.empty() );
+    requireSame( moved, ref );
+}
+
+} // namespace
+
+
+TEST_CASE( "test_SegmentedRing_random", "1" )
+{
+    // the table of segments wraps and grows every which way with small ones
+    requireLikeDeque<sob::SegmentedRing<int, std::allocator<int>, 2>>();
+    requireLikeDeque<sob::SegmentedRing<int>>();
+}
+
+TEST_CASE( "test_SegmentedRing_stable", "1" )
+{
+    sob::SegmentedRing<int> ring;
+    std::vector<sob::SegmentedRing<int>::iterator> handles;
+    for ( int i = 0; i < 10; i++ ) {
+        ring.push_back( i );
+        handles.push_back( std::prev( ring.end() ) );
+    }
+    const int* addr = &*handles[5];
+
+    // growing at both ends moves nothing, the handles and the addresses stay put
+    for ( int i = 0; i < 1000; i++ ) {
+        ring.push_back( 100 + i );
+        ring.push_front( -1 - i );
+    }
+    for ( int i = 0; i < 10; i++ ) {
+        REQUIRE( *handles[i] == i );
+    }
+    REQUIRE( &*handles[5] == addr );
+
+    // so does popping the ends, and erasing at them
+    for ( int i = 0; i < 1000; i++ ) {
+        ring.pop_front();
+        ring.erase( std::prev( ring.end() ) );
+    }
+    ring.erase( handles[0] );
+    REQUIRE( *handles[1] == 1 );
+    REQUIRE( *handles[9] == 9 );
+    REQUIRE( ring.size() == 9 );
+}
+
+TEST_CASE( "test_SegmentedRing_reuse", "1" )
+{
+    // a FIFO sliding through the ring keeps recycling the segments it has, and so does a LIFO at the front
+    using Ring = sob::SegmentedRing<int>;
+    const int depth = 3 * Ring::SegSize;
+    Ring ring{ 4 * Ring::SegSize };
+    REQUIRE( ring.capacity() == static_cast<size_t>( 4 * Ring::SegSize ) );
+    for ( int i = 0; i < depth; i++ ) {
+        ring.push_back( i );
+    }
+    for ( int i = depth; i < 100 * depth; i++ ) {
+        ring.push_back( i );
+        REQUIRE( ring.front() == i - depth );
+        ring.pop_front();
+    }
+    for ( int i = 0; i < 10 * depth; i++ ) {
+        ring.pop_front();
+        ring.push_front( i );
+        REQUIRE( ring.front() == i );
+    }
+    REQUIRE( ring.capacity() == static_cast<size_t>( 4 * Ring::SegSize ) );
+    REQUIRE( ring.size() == static_cast<size_t>( depth ) );
+}
+
+TEST_CASE( "test_SegmentedRing_L3Book", "1" )
+{
+    // one deep level well past a segment, canceled at both ends of the queue, matched against a list book
+    sob::L3Book<boost::circular_buffer> book;
+    sob::L3Book<std::list> list_book;
+    std::vector<std::string> orders;
+    for ( int id = 0; id < 100; id++ ) {
+        orders.push_back( "N " + std::to_string( id ) + " 1 10 1.5" );
+    }
+    for ( int id = 0; id < 20; id++ ) {
+        orders.push_back( "C " + std::to_string( 1000 + id ) + " 0 0 0 " + std::to_string( id ) + " 0 0" );
+        orders.push_back( "C " + std::to_string( 2000 + id ) + " 0 0 0 " + std::to_string( 99 - id ) + " 0 0" );
+    }
+    orders.push_back( "N 100 0 35 1.5" );
+    for ( const auto& str: orders ) {
+        sob::Order order{ str };
+        sob::Order list_order{ str };
+        REQUIRE( book.applyOrder( order ) == list_book.applyOrder( list_order ) );
+        REQUIRE( book.toString() == list_book.toString() );
+    }
+    REQUIRE( !book.queryOrderId( 22 ) );
+    REQUIRE( ( *book.queryOrderId( 23 ) )->size == 5 );
+    REQUIRE( ( *book.queryOrderId( 79 ) )->orderId == 79 );
+}
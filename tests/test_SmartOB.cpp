@@ -6,8 +6,25 @@
 #include <OrderBook.h>
 #include <L3OrderBook.h>
 #include <SmartOrderBook.h>
+#include <L3OrderBookListener.h>
 #include <vector>
 
+namespace {
+
+struct CountingListener : sob::L3OrderBookListener<boost::circular_buffer, sob::MapSide, std::allocator<sob::RestingOrder>>
+{
+    using Book = sob::L3Book<boost::circular_buffer>;
+    int updates{ 0 };
+    int trades{ 0 };
+    int snapshots{ 0 };
+
+    void onBookUpdate( Book*, const sob::Order& ) override { updates++; }
+    void onTradeMsg( Book*, const sob::Trade& ) override { trades++; }
+    void onSnapShotMsg( Book*, sob::L2Book& ) override { snapshots++; }
+}; // struct CountingListener
+
+} // namespace
+
 /**
  *  sync means the streams are in the order of tuple ( order, snapshot, [trade] )
  *      the trade is possible because there might not be a trade
@@ -706,3 +723,99 @@ TEST_CASE( "test_SmartOrderBook_async_3(order in the lead)", "1" )
 
     spdlog::set_level(spdlog::level::info);
 }
+
+TEST_CASE( "test_SmartOrderBook_pipelined", "1" )
+{
+    const std::vector<std::string> msgs {
+        "N 0 1 100 1.5",    "S 0 1 1.5 100",
+        "N 1 1 100 1.4",    "S 0 2 1.4 100 1.5 100",
+        "N 2 1 200 1.4",    "S 0 2 1.4 300 1.5 100",
+        "N 3 0 50 1.3",     "S 1 2 1.3 50 1.4 300 1.5 100",
+        "N 4 0 100 1.3",    "S 1 2 1.3 150 1.4 300 1.5 100",
+        "N 5 0 100 1.2",    "S 2 2 1.2 100 1.3 150 1.4 300 1.5 100",
+        "N 6 1 100 1.35",   "S 2 3 1.2 100 1.3 150 1.35 100 1.4 100 1.5 100",
+        "S 2 3 1.2 100 1.3 150 1.35 50 1.4 50 1.5 100",
+        "S 3 2 1.2 100 1.3 150 1.4 50 1.3 250 1.5 100",
+        "N 7 0 50 1.35",    "T 0 1.35 50",
+        "N 8 0 50 1.35",    "T 0 1.35 50",
+        "N 9 0 10 1.4",     "T 0 1.4 10",
+        "N 10 0 200 1.35",  "S 3 2 1.2 100 1.3 150 1.35 200 1.4 40 1.5 100",
+    };
+
+    sob::SmartOrderBook serial;
+    for ( const auto& msg : msgs ) {
+        serial.applyMessage( msg );
+    }
+
+    // a tiny ring so that both sides have to wait on each other
+    sob::SmartOrderBook pipelined;
+    size_t next{ 0 };
+    pipelined.applyMessagesPipelined( [&msgs, &next]( sob::Message& msg ) {
+        if ( next == msgs.size() ) {
+            return false;
+        }
+        REQUIRE( sob::decodeMessage( msgs[next++], msg ) == sob::ParseError::Ok );
+        return true;
+    }, 2 );
+
+    REQUIRE( pipelined.getLeaderBook()->toString() == serial.getLeaderBook()->toString() );
+
+    sob::SmartOrderBook failing;
+    size_t cnt{ 0 };
+    REQUIRE_THROWS_AS( failing.applyMessagesPipelined( [&cnt]( sob::Message& msg ) -> bool {
+        if ( cnt++ == 3 ) {
+            throw std::runtime_error( "decoder failed" );
+        }
+        msg = sob::Order{ "N " + std::to_string( cnt ) + " 1 100 1.5" };
+        return true;
+    } ), std::runtime_error );
+}
+
+TEST_CASE( "test_SmartOrderBook_typed_messages", "1" )
+{
+    const std::vector<std::string> strs {
+        "N 0 1 100 1.5",    "S 0 1 1.5 100",
+        "N 1 1 100 1.4",    "N 2 0 50 1.3",
+        "T 1 1.3 20",       "S 1 2 1.3 30 1.4 100 1.5 100",
+        "N 3 0 150 1.4",    // aggressive, the book trades it down to 50
+        "C 4 0 30 1.3 2",
+    };
+
+    sob::SmartOrderBook from_strings;
+    from_strings.applyMessages( strs );
+
+    std::vector<sob::Message> msgs( strs.size() );
+    for ( size_t i = 0; i < strs.size(); i++ ) {
+        REQUIRE( sob::decodeMessage( strs[i], msgs[i] ) == sob::ParseError::Ok );
+    }
+    const auto& const_msgs = msgs;
+
+    sob::SmartOrderBook from_messages;
+    from_messages.applyMessages( const_msgs );
+    REQUIRE( from_messages.getLeaderBook()->toString() == from_strings.getLeaderBook()->toString() );
+
+    // the batch is left untouched, the aggressive order still carries its original size
+    REQUIRE( std::get<sob::Order>( msgs[6] ).size == 150 );
+
+    // and can be replayed into another book with the same result
+    sob::SmartOrderBook replayed;
+    replayed.applyMessages( const_msgs.data(), const_msgs.size() );
+    REQUIRE( replayed.getLeaderBook()->toString() == from_strings.getLeaderBook()->toString() );
+}
+
+TEST_CASE( "test_SmartOrderBook_cancelSubscription", "1" )
+{
+    sob::SmartOrderBook book;
+    CountingListener listener;
+    book.acceptSubscription( &listener );
+    book.applyMessages( std::vector<std::string>{ "N 0 1 100 1.5", "S 0 1 1.5 100", "T 1 1.5 20" } );
+    REQUIRE( listener.updates == 1 );
+    REQUIRE( listener.snapshots == 1 );
+    REQUIRE( listener.trades == 1 );
+
+    // a listener gone before the book is never called again
+    book.cancelSubscription( &listener );
+    book.applyMessages( std::vector<std::string>{ "N 1 1 100 1.4", "S 0 2 1.4 100 1.5 80" } );
+    REQUIRE( listener.updates == 1 );
+    REQUIRE( listener.snapshots == 1 );
+}
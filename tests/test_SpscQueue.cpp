@@ -0,0 +1,67 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <SpscQueue.h>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE( "test_SpscQueue_bounded", "1" )
+{
+    sob::SpscQueue<int> q{ 3 };
+    REQUIRE( q.capacity() == 4 );
+    REQUIRE( q.front() == nullptr );
+
+    for ( int i = 0; i < 4; i++ ) {
+        int* slot = q.acquire();
+        REQUIRE( slot != nullptr );
+        *slot = i;
+        q.publish();
+    }
+    REQUIRE( q.acquire() == nullptr );          // full
+
+    REQUIRE( *q.front() == 0 );
+    q.pop();
+    REQUIRE( q.acquire() != nullptr );          // one slot freed
+
+    q.close();
+    REQUIRE_FALSE( q.drained() );
+    for ( int i = 1; i < 4; i++ ) {
+        REQUIRE( *q.front() == i );
+        q.pop();
+    }
+    REQUIRE( q.drained() );
+}
+
+TEST_CASE( "test_SpscQueue_threads", "1" )
+{
+    constexpr int N = 200000;
+    sob::SpscQueue<std::vector<int>> q{ 16 };
+
+    std::thread producer{ [&q]() {
+        for ( int i = 0; i < N; i++ ) {
+            std::vector<int>* slot;
+            while ( ( slot = q.acquire() ) == nullptr ) {
+                std::this_thread::yield();
+            }
+            slot->assign( 3, i );
+            q.publish();
+        }
+        q.close();
+    } };
+
+    int expected{ 0 };
+    while ( !q.drained() ) {
+        std::vector<int>* slot = q.front();
+        if ( slot == nullptr ) {
+            std::this_thread::yield();
+            continue;
+        }
+        REQUIRE( slot->size() == 3 );
+        REQUIRE( slot->back() == expected );
+        expected++;
+        q.pop();
+    }
+    producer.join();
+
+    REQUIRE( expected == N );
+}
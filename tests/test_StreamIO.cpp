@@ -0,0 +1,52 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <MappedFile.h>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+
+namespace {
+
+std::string writeTmpFile( const std::string& name, const std::string& content )
+{
+    const std::string path = "/tmp/sob_test_" + name;
+    std::ofstream ofs{ path, std::ios::binary };
+    ofs << content;
+    return path;
+}
+
+std::vector<std::string> readAllLines( const std::string& path )
+{
+    sob::MappedFile file{ path };
+    sob::LineReader reader{ file };
+    std::vector<std::string> lines;
+    std::string_view line;
+    while ( reader.next( line ) ) {
+        lines.emplace_back( line );
+    }
+    return lines;
+}
+
+} // namespace
+
+
+TEST_CASE( "test_LineReader", "1" )
+{
+    const auto path = writeTmpFile( "lines.stream", "N 0 1 100 1.5\nS 0 1 1.5 100\r\n\nT 0 1.5 10" );
+    REQUIRE( readAllLines( path ) == std::vector<std::string>{ "N 0 1 100 1.5", "S 0 1 1.5 100", "", "T 0 1.5 10" } );
+    std::remove( path.c_str() );
+}
+
+TEST_CASE( "test_LineReader_empty_file", "1" )
+{
+    const auto path = writeTmpFile( "empty.stream", "" );
+    REQUIRE( readAllLines( path ).empty() );
+    std::remove( path.c_str() );
+}
+
+TEST_CASE( "test_MappedFile_missing", "1" )
+{
+    REQUIRE_THROWS( sob::MappedFile{ "/tmp/sob_test_does_not_exist.stream" } );
+}
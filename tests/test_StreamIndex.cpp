@@ -0,0 +1,146 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <StreamIndex.h>
+#include <ChunkedDecoder.h>
+#include <BinaryFormat.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+
+namespace {
+
+// an exact decimal, so that the binary ticks decode back to the same price
+std::string px( const int whole, const int i )
+{
+    return fmt::format( "{}.{:02}", whole + i / 100, i % 100 );
+}
+
+// 1000 messages, a snapshot every 10th line, an empty and a malformed line in the middle
+std::string makeStream()
+{
+    std::string res;
+    for ( int i = 0; i < 1000; i++ ) {
+        if ( i == 500 ) {
+            res += "\n";
+        } else if ( i == 700 ) {
+            res += "N x 1 100 1.5\n";
+        } else if ( i % 10 == 0 ) {
+            res += fmt::format( "S 1 1 {} 100 {} 100\n", px( 1, i ), px( 12, i ) );
+        } else {
+            res += fmt::format( "N {} {} {} {}\n", i, i % 2, 100 + i, px( 1, i ) );
+        }
+    }
+    return res;
+}
+
+std::string toString( const sob::Message& msg )
+{
+    if ( const auto* order = std::get_if<sob::Order>( &msg ) ) {
+        return order->to_simple_string();
+    } else if ( const auto* trade = std::get_if<sob::Trade>( &msg ) ) {
+        return trade->toString();
+    }
+    return std::get<sob::L2Book>( msg ).to_simple_string();
+}
+
+std::vector<std::string> decodeChunked( std::string_view data, const sob::StreamIndex& index,
+                                        const size_t threads, const uint64_t start_msg )
+{
+    std::vector<std::string> res;
+    sob::ChunkedDecoder decoder{ data, index, threads, 2 };
+    decoder.run( [&res]( sob::Message* msgs, const size_t cnt ) {
+        for ( size_t i = 0; i < cnt; i++ ) {
+            res.push_back( toString( msgs[i] ) );
+        }
+    }, start_msg );
+    return res;
+}
+
+} // namespace
+
+
+TEST_CASE( "test_StreamIndex_text", "1" )
+{
+    const auto data = makeStream();
+    const auto index = sob::StreamIndex::build( data, 64 );
+
+    REQUIRE( index.messageCount() == 1000 );
+    REQUIRE( index.entries() == 16 );
+    for ( size_t e = 0; e < index.entries(); e++ ) {
+        const auto off = index.offset( e );
+        REQUIRE( ( off == 0 || data[off - 1] == '\n' ) );
+    }
+    REQUIRE( index.offset( index.entries() ) == data.size() );
+
+    REQUIRE( index.offsetOf( data, 0 ) == 0 );
+    REQUIRE( data.substr( index.offsetOf( data, 3 ), 6 ) == "N 3 1 " );
+    REQUIRE( data.substr( index.offsetOf( data, 130 ), 2 ) == "S " );
+    REQUIRE( index.offsetOf( data, 1000 ) == data.size() );
+    REQUIRE( index.offsetOf( data, 5000 ) == data.size() );
+}
+
+TEST_CASE( "test_StreamIndex_sidecar", "1" )
+{
+    const auto data = makeStream();
+    const auto index = sob::StreamIndex::build( data, 64 );
+    const std::string path = "/tmp/sob_test_index.stream.idx";
+    index.save( path );
+
+    const auto loaded = sob::StreamIndex::load( path, data.size() );
+    REQUIRE( loaded.has_value() );
+    REQUIRE( loaded->stride() == 64 );
+    REQUIRE( loaded->messageCount() == index.messageCount() );
+    REQUIRE( loaded->entries() == index.entries() );
+    for ( size_t e = 0; e <= index.entries(); e++ ) {
+        REQUIRE( loaded->offset( e ) == index.offset( e ) );
+    }
+
+    // built for another file size, hence stale
+    REQUIRE_FALSE( sob::StreamIndex::load( path, data.size() + 1 ).has_value() );
+    REQUIRE_FALSE( sob::StreamIndex::load( "/tmp/sob_test_does_not_exist.idx", data.size() ).has_value() );
+    std::remove( path.c_str() );
+}
+
+TEST_CASE( "test_ChunkedDecoder_matches_serial", "1" )
+{
+    const auto text = makeStream();
+
+    std::string binary;
+    sob::bin::Writer writer{ binary, sob::bin::DefaultPxScale };
+    std::vector<std::string> serial;
+    std::vector<size_t> line_of;        // the message number of every decoded message
+    sob::Message msg;
+    size_t line_no{ 0 }, pos{ 0 };
+    while ( pos < text.size() ) {
+        const auto eol = text.find( '\n', pos );
+        const auto line = std::string_view( text ).substr( pos, eol - pos );
+        pos = eol + 1;
+        if ( sob::decodeMessage( line, msg ) == sob::ParseError::Ok ) {
+            serial.push_back( toString( msg ) );
+            line_of.push_back( line_no );
+            std::visit( [&writer]( auto& m ) { writer.write( m ); }, msg );
+        }
+        line_no++;
+    }
+    REQUIRE( serial.size() == 998 );
+
+    const auto text_index = sob::StreamIndex::build( text, 32 );
+    const auto bin_index = sob::StreamIndex::build( binary, 32 );
+    REQUIRE( bin_index.messageCount() == serial.size() );
+
+    for ( const size_t threads : { size_t{ 1 }, size_t{ 3 }, size_t{ 8 } } ) {
+        REQUIRE( decodeChunked( text, text_index, threads, 0 ) == serial );
+        REQUIRE( decodeChunked( binary, bin_index, threads, 0 ) == serial );
+    }
+
+    // starting in the middle of a chunk, the binary stream has no empty nor malformed records to skip
+    const uint64_t start = 613;
+    const auto first = std::lower_bound( line_of.begin(), line_of.end(), start ) - line_of.begin();
+    REQUIRE( decodeChunked( text, text_index, 3, start )
+             == std::vector<std::string>( serial.begin() + first, serial.end() ) );
+    REQUIRE( decodeChunked( binary, bin_index, 3, start )
+             == std::vector<std::string>( serial.begin() + start, serial.end() ) );
+}
@@ -0,0 +1,214 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <TickLadder.h>
+#include <L3OrderBook.h>
+#include <map>
+#include <random>
+#include <vector>
+#include <string>
+
+
+namespace {
+
+template <typename Comparator>
+void requireSameLevels( const sob::TickLadder<int, Comparator>& ladder, const std::map<sob::Price, int, Comparator>& ref )
+{
+    REQUIRE( ladder.size() == ref.size() );
+    auto it = ladder.begin();
+    for ( const auto& [px, lvl]: ref ) {
+        REQUIRE( it != ladder.end() );
+        REQUIRE( it->first == px );
+        REQUIRE( it->second == lvl );
+        ++it;
+    }
+    REQUIRE( it == ladder.end() );
+
+    auto rit = ladder.rbegin();
+    for ( auto ref_rit = ref.rbegin(); ref_rit != ref.rend(); ++ref_rit, ++rit ) {
+        REQUIRE( rit->first == ref_rit->first );
+    }
+    REQUIRE( rit == ladder.rend() );
+}
+
+template <typename Comparator>
+void randomOps( const unsigned seed )
+{
+    std::mt19937 gen{ seed };
+    std::uniform_int_distribution<int64_t> drift{ -3, 3 };
+    std::uniform_int_distribution<int64_t> offset{ -200, 200 };
+    std::uniform_int_distribution<int> op{ 0, 2 };
+
+    sob::TickLadder<int, Comparator> ladder;
+    std::map<sob::Price, int, Comparator> ref;
+    int64_t mid = 0;
+    for ( int i = 0; i < 20000; i++ ) {
+        mid += drift( gen );
+        const auto px = sob::Price::fromTicks( mid + offset( gen ) );
+        if ( op( gen ) == 0 ) {
+            REQUIRE( ladder.erase( px ) == ref.erase( px ) );
+        } else {
+            ladder[px] += i;
+            ref[px] += i;
+        }
+        REQUIRE( ( ladder.find( px ) == ladder.end() ) == ( ref.find( px ) == ref.end() ) );
+        if ( !ref.empty() ) {
+            REQUIRE( ladder.begin()->first == ref.begin()->first );
+        }
+        if ( i % 1000 == 0 ) {
+            requireSameLevels( ladder, ref );
+        }
+    }
+    requireSameLevels( ladder, ref );
+}
+
+const std::vector<std::string> Orders {
+    "N 0 1 100 1.5",
+    "N 1 1 100 1.4",
+    "N 2 1 200 1.4",
+    "N 3 0 50 1.3",
+    "N 4 0 100 1.3",
+    "N 5 0 100 1.2",
+    "N 6 0 50 1.4",
+    "C 12 0 0 0 2 0 0",
+    "R 7 1 50 1.45 1 1.4 50",
+    "N 8 1 300 1.25",
+    "N 9 0 20 0.01",
+    "N 10 1 30 250.0",
+    "C 13 0 0 0 9 0 0",
+    "N 11 0 400 1.6",
+};
+
+// levels scattered over several windows, the touch jumping between them
+template <typename Comparator>
+void randomFarOps( const unsigned seed )
+{
+    using Ladder = sob::TickLadder<int, Comparator>;
+    std::mt19937 gen{ seed };
+    std::uniform_int_distribution<int64_t> window{ -3, 3 };
+    std::uniform_int_distribution<int64_t> offset{ -300, 300 };
+    std::uniform_int_distribution<int> op{ 0, 3 };
+
+    Ladder ladder;
+    std::map<sob::Price, int, Comparator> ref;
+    for ( int i = 0; i < 20000; i++ ) {
+        const auto px = sob::Price::fromTicks( window( gen ) * Ladder::MaxWindowTicks / 2 + offset( gen ) );
+        if ( op( gen ) == 0 ) {
+            REQUIRE( ladder.erase( px ) == ref.erase( px ) );
+        } else {
+            ladder[px] += i;
+            ref[px] += i;
+        }
+        REQUIRE( ladder.windowTicks() <= Ladder::MaxWindowTicks );
+        if ( !ref.empty() ) {
+            REQUIRE( ladder.begin()->first == ref.begin()->first );
+            REQUIRE( std::prev( ladder.end() )->first == std::prev( ref.end() )->first );
+        }
+        if ( i % 1000 == 0 ) {
+            requireSameLevels( ladder, ref );
+            requireSameLevels( Ladder{ ladder }, ref );
+        }
+    }
+    requireSameLevels( ladder, ref );
+}
+
+} // namespace
+
+
+TEST_CASE( "test_TickLadder_order", "1" )
+{
+    randomOps<sob::AskComparator>( 1 );
+    randomOps<sob::BidComparator>( 2 );
+}
+
+TEST_CASE( "test_TickLadder_far", "1" )
+{
+    randomFarOps<sob::AskComparator>( 3 );
+    randomFarOps<sob::BidComparator>( 4 );
+}
+
+TEST_CASE( "test_TickLadder_recenter", "1" )
+{
+    sob::TickLadder<int, sob::AskComparator> ladder;
+    ladder[sob::Price::fromTicks( 1000 )] = 1;
+    int& anchored = ladder[sob::Price::fromTicks( 1001 )];
+    anchored = 2;
+    const auto anchored_it = ladder.find( sob::Price::fromTicks( 1001 ) );
+
+    // the price walks away, below zero, and the window follows it
+    for ( int64_t tick = 999; tick > -5000; tick-- ) {
+        ladder[sob::Price::fromTicks( tick )] = static_cast<int>( tick );
+        if ( tick < 900 ) {
+            ladder.erase( sob::Price::fromTicks( tick + 100 ) );
+        }
+    }
+    REQUIRE( ladder.size() == 102 );
+    REQUIRE( ladder.begin()->first == sob::Price::fromTicks( -4999 ) );
+
+    // levels never move, so what pointed at them still does
+    REQUIRE( &anchored == &ladder.at( sob::Price::fromTicks( 1001 ) ) );
+    REQUIRE( anchored_it->second == 2 );
+    REQUIRE( std::prev( ladder.end() ) == anchored_it );
+
+    // once the far levels go, the window shrinks back around the others
+    ladder.erase( sob::Price::fromTicks( 1000 ) );
+    REQUIRE( ladder.erase( anchored_it ) == ladder.end() );
+    REQUIRE( ladder.size() == 100 );
+    REQUIRE( ladder.windowTicks() <= 3 * sob::TickLadder<int, sob::AskComparator>::PageTicks );
+
+    // further than the window can stretch: held aside, the window stays where it is
+    const auto far = sob::Price::fromTicks( sob::TickLadder<int, sob::AskComparator>::MaxWindowTicks );
+    ladder[far] = 7;
+    REQUIRE( ladder.size() == 101 );
+    REQUIRE( ladder.windowTicks() <= 3 * sob::TickLadder<int, sob::AskComparator>::PageTicks );
+    REQUIRE( std::prev( ladder.end() )->first == far );
+    REQUIRE( ladder.at( far ) == 7 );
+    REQUIRE_THROWS_AS( ladder.at( sob::Price::fromTicks( 5000 ) ), std::out_of_range );
+
+    auto copy = ladder;
+    ladder.clear();
+    REQUIRE( ladder.empty() );
+    REQUIRE( ladder.begin() == ladder.end() );
+    REQUIRE( copy.size() == 101 );
+    REQUIRE( copy.at( sob::Price::fromTicks( -4900 ) ) == -4900 );
+    REQUIRE( copy.at( far ) == 7 );
+}
+
+TEST_CASE( "test_TickLadder_L3Book", "1" )
+{
+    sob::L3Book<boost::circular_buffer> map_book;
+    sob::L3Book<boost::circular_buffer, sob::LadderSide> ladder_book;
+    for ( const auto& str: Orders ) {
+        sob::Order map_order{ str };
+        sob::Order ladder_order{ str };
+        REQUIRE( map_book.applyOrder( map_order ) == ladder_book.applyOrder( ladder_order ) );
+        REQUIRE( ladder_book.toString() == map_book.toString() );
+        REQUIRE( ladder_book.agg() == map_book.agg() );
+    }
+    REQUIRE( ladder_book.getBidSide().begin()->second.toL2PriceLevel() == sob::L2PriceLevel( 1.6, 100 ) );
+
+    // a copy keeps working on its own levels
+    auto copy = ladder_book;
+    sob::Order cancel{ "C 14 0 0 0 10 0 0" };
+    REQUIRE( copy.applyOrder( cancel ).second );
+    REQUIRE( copy.getAskSideSize() + 30 == ladder_book.getAskSideSize() );
+    REQUIRE( ladder_book.toString() == map_book.toString() );
+}
+
+TEST_CASE( "test_TickLadder_L3Book_far", "1" )
+{
+    using Ladder = sob::TickLadder<int, sob::AskComparator>;
+    const double far = static_cast<double>( 2 * Ladder::MaxWindowTicks ) / sob::TickSize::get();
+    sob::L3Book<boost::circular_buffer> map_book;
+    sob::L3Book<boost::circular_buffer, sob::LadderSide> ladder_book;
+    for ( const auto& str: { std::string{ "N 0 1 100 1.5" }, std::string{ "N 1 0 100 1.4" },
+                             fmt::format( "N 2 1 30 {}", far ), fmt::format( "N 3 1 40 {}", 2 * far ),
+                             std::string{ "N 4 1 20 1.45" }, std::string{ "C 5 0 0 0 2 0 0" } } ) {
+        sob::Order map_order{ str };
+        sob::Order ladder_order{ str };
+        REQUIRE( map_book.applyOrder( map_order ) == ladder_book.applyOrder( ladder_order ) );
+        REQUIRE( ladder_book.toString() == map_book.toString() );
+        REQUIRE( ladder_book.agg() == map_book.agg() );
+    }
+    REQUIRE( ladder_book.getAskSideSize() == 160 );
+    REQUIRE( ladder_book.getBestAsk() == sob::L2PriceLevel( 1.45, 20 ) );
+}
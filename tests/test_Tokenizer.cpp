@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+#include <Tokenizer.h>
+#include <Message.h>
+#include <MappedFile.h>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+
+namespace {
+
+// every line and field of data, tokenised batch by batch
+std::pair<std::vector<std::string>, std::vector<std::vector<std::string>>>
+tokenizeAll( std::string_view data, const size_t batch_lines, const sob::SimdLevel level )
+{
+    std::vector<std::string> lines;
+    std::vector<std::vector<std::string>> fields;
+    sob::TokenBatch batch;
+    size_t pos{ 0 };
+    while ( pos < data.size() ) {
+        pos += sob::Tokenizer::tokenize( data.substr( pos ), batch_lines, batch, level );
+        for ( size_t i = 0; i < batch.lines(); i++ ) {
+            lines.emplace_back( batch.line( i ) );
+            auto cur = batch.cursor( i );
+            auto& line_fields = fields.emplace_back();
+            while ( !cur.atEnd() ) {
+                line_fields.emplace_back( cur.next() );
+            }
+        }
+    }
+    return { lines, fields };
+}
+
+} // namespace
+
+
+TEST_CASE( "test_Tokenizer_fields", "1" )
+{
+    const std::string data = "N 0 1 100 1.5\n  S 0\t1 1.5 100 \r\n\n   \nT 0 1.5 10";
+    const auto [ lines, fields ] = tokenizeAll( data, 1024, sob::SimdLevel::Scalar );
+
+    REQUIRE( lines == std::vector<std::string>{ "N 0 1 100 1.5", "  S 0\t1 1.5 100 ", "", "   ", "T 0 1.5 10" } );
+    REQUIRE( fields.size() == 5 );
+    REQUIRE( fields[0] == std::vector<std::string>{ "N", "0", "1", "100", "1.5" } );
+    REQUIRE( fields[1] == std::vector<std::string>{ "S", "0", "1", "1.5", "100" } );
+    REQUIRE( fields[2].empty() );
+    REQUIRE( fields[3].empty() );
+    REQUIRE( fields[4] == std::vector<std::string>{ "T", "0", "1.5", "10" } );
+}
+
+TEST_CASE( "test_Tokenizer_simd_matches_scalar", "1" )
+{
+    // lines straddling the 32-byte blocks in every possible way
+    std::mt19937 rng{ 42 };
+    const char alphabet[] = { 'N', '1', '.', '5', ' ', ' ', '\t', '\r', '\n' };
+    std::string data;
+    for ( int i = 0; i < 20000; i++ ) {
+        data += alphabet[ rng() % sizeof( alphabet ) ];
+    }
+
+    const auto scalar_all = tokenizeAll( data, 1024, sob::SimdLevel::Scalar );
+    for ( const auto level : { sob::SimdLevel::Sse2, sob::SimdLevel::Avx2 } ) {
+        if ( !sob::isSupported( level ) ) {
+            continue;
+        }
+        for ( const size_t batch_lines : { size_t{ 1 }, size_t{ 7 }, size_t{ 1024 } } ) {
+            REQUIRE( tokenizeAll( data, batch_lines, level ) == scalar_all );
+        }
+
+        // the raw offset tables, not only the strings they point to
+        sob::TokenBatch scalar, simd;
+        REQUIRE( sob::Tokenizer::tokenize( data, 1 << 20, scalar, sob::SimdLevel::Scalar ) == data.size() );
+        REQUIRE( sob::Tokenizer::tokenize( data, 1 << 20, simd, level ) == data.size() );
+        REQUIRE( simd.lineSpans() == scalar.lineSpans() );
+        REQUIRE( simd.fieldSpans() == scalar.fieldSpans() );
+    }
+}
+
+TEST_CASE( "test_Tokenizer_decode", "1" )
+{
+    const std::string data = "N 0 1 100 1.5\nS 1 1 1.4 200 1.5 100\nT 0 1.5 10 1.6 5\nR 2 0 50 1.2 1 1.3 60\nN 1 x 100 1.5\n";
+    sob::TokenBatch batch;
+    REQUIRE( sob::Tokenizer::tokenize( data, 16, batch ) == data.size() );
+    REQUIRE( batch.lines() == 5 );
+
+    for ( size_t i = 0; i < batch.lines(); i++ ) {
+        sob::Message from_tokens, from_text;
+        const auto err = sob::decodeMessage( batch, i, from_tokens );
+        REQUIRE( err == sob::decodeMessage( batch.line( i ), from_text ) );
+        if ( err != sob::ParseError::Ok ) {
+            REQUIRE( i == 4 );
+            continue;
+        }
+        REQUIRE( from_tokens.index() == from_text.index() );
+        if ( const auto* order = std::get_if<sob::Order>( &from_tokens ) ) {
+            REQUIRE( order->to_simple_string() == std::get<sob::Order>( from_text ).to_simple_string() );
+        } else if ( const auto* trade = std::get_if<sob::Trade>( &from_tokens ) ) {
+            REQUIRE( trade->toString() == std::get<sob::Trade>( from_text ).toString() );
+        } else {
+            REQUIRE( std::get<sob::L2Book>( from_tokens ).to_simple_string()
+                     == std::get<sob::L2Book>( from_text ).to_simple_string() );
+        }
+    }
+}
+
+TEST_CASE( "test_TokenReader", "1" )
+{
+    const std::string path = "/tmp/sob_test_tokens.stream";
+    {
+        std::ofstream ofs{ path, std::ios::binary };
+        for ( int i = 0; i < 100; i++ ) {
+            ofs << "N " << i << " 1 100 1.5\n";
+        }
+    }
+
+    sob::MappedFile file{ path };
+    sob::TokenReader reader{ file, 8 };
+    sob::TokenBatch batch;
+    size_t lines{ 0 };
+    while ( reader.next( batch ) ) {
+        REQUIRE( batch.lines() <= 8 );
+        lines += batch.lines();
+    }
+    REQUIRE( lines == 100 );
+    std::remove( path.c_str() );
+}
@@ -10,7 +10,7 @@ TEST_CASE("test_messages_trade", "1")
     spdlog::set_level( spdlog::level::debug );
     sob::Trade trade{ "T 1 0.9 10 1.1 5 1.2 30" };
     REQUIRE( trade.getLvlCnt() == 3 );
-    REQUIRE( trade.price == std::vector<double>{ 0.9, 1.1, 1.2 } );
+    REQUIRE( trade.price == std::vector<sob::Price>{ 0.9, 1.1, 1.2 } );
     REQUIRE( trade.volume == std::vector<int>{ 10, 5, 30 } );
     REQUIRE( trade.isSell == true );
 
@@ -18,7 +18,7 @@ TEST_CASE("test_messages_trade", "1")
 
     sob::Trade new_trade{ trade.toString() };
     REQUIRE( new_trade.getLvlCnt() == 3 );
-    REQUIRE( new_trade.price == std::vector<double>{ 0.9, 1.1, 1.2 } );
+    REQUIRE( new_trade.price == std::vector<sob::Price>{ 0.9, 1.1, 1.2 } );
     REQUIRE( new_trade.volume == std::vector<int>{ 10, 5, 30 } );
     REQUIRE( new_trade.isSell == true );
 
@@ -47,7 +47,7 @@ TEST_CASE("test_messages_snapshot", "1")
 TEST_CASE("test_messages_snapshot_2", "1")
 {
     spdlog::set_level( spdlog::level::debug );
-    sob::L2Book ob{"S 2 3 1.2 100 1.3 150 1.35 50 1.4 50 1.3 250 1.5 100"};
+    sob::L2Book ob{"S 2 4 1.2 100 1.3 150 1.35 50 1.4 50 1.3 250 1.5 100"};
     spdlog::debug( "[test_messages_snapshot] Got snapshot: \n{}", ob.toString() );
 
     spdlog::debug( "[test_messages_snapshot] Got snapshot simple: {}", ob.to_simple_string() );
@@ -59,3 +59,134 @@ TEST_CASE("test_messages_snapshot_2", "1")
 
 
 
+TEST_CASE("test_messages_price", "1")
+{
+    REQUIRE( sob::TickSize::get() == 10000 );
+    REQUIRE( sob::Price{ 1.35 }.ticks() == 13500 );
+    REQUIRE( sob::Price{ 0.1 + 0.2 } == sob::Price{ 0.3 } );
+    REQUIRE( sob::Price{ 1.35 }.toDouble() == 1.35 );
+    REQUIRE( fmt::format( "{}", sob::Price{ 1.35 } ) == "1.35" );
+    REQUIRE( fmt::format( "{}", sob::Price{ 2.0 } ) == fmt::format( "{}", 2.0 ) );
+    REQUIRE( sob::Price{ 1.4 } < sob::Price{ 1.45 } );
+    REQUIRE( std::hash<sob::Price>{}( 1.4 ) == std::hash<sob::Price>{}( sob::Price::fromTicks( 14000 ) ) );
+
+    // binary formats written with the same scale convert exactly, any other scale through the decimal price
+    REQUIRE( sob::Price::fromScaled( 13500, 10000 ) == 1.35 );
+    REQUIRE( sob::Price::fromScaled( 135, 100 ) == 1.35 );
+    REQUIRE( sob::Price{ 1.35 }.toScaled( 100 ) == 135 );
+
+    sob::Price px;
+    REQUIRE( sob::decodeField( "1.23456", px ) == sob::ParseError::Ok );
+    REQUIRE( px.ticks() == 12346 );
+    REQUIRE( sob::decodeField( "1.2x", px ) == sob::ParseError::BadField );
+
+    sob::TickSize::set( 20 );
+    REQUIRE( sob::Price{ 1.35 }.ticks() == 27 );
+    REQUIRE( fmt::format( "{}", sob::Price{ 1.35 } ) == "1.35" );
+    sob::TickSize::set( 10000 );
+    REQUIRE_THROWS( sob::TickSize::set( 0 ) );
+}
+
+TEST_CASE("test_messages_parse_order", "1")
+{
+    sob::Order order;
+    REQUIRE( sob::Order::parse( "N 3 0 50 1.3", order ) == sob::ParseError::Ok );
+    REQUIRE( order.getType() == sob::OrderType::Normal );
+    REQUIRE( order.orderId == 3 );
+    REQUIRE( order.isSell == false );
+    REQUIRE( order.size == 50 );
+    REQUIRE( order.price == 1.3 );
+
+    REQUIRE( sob::Order::parse( "C 6 0 0 0 1 0 0", order ) == sob::ParseError::Ok );
+    REQUIRE( order.getType() == sob::OrderType::Cancel );
+    REQUIRE( *order.oldId == 1 );
+
+    REQUIRE( sob::Order::parse( "R 6 1 250 1.5 2 1.4 250", order ) == sob::ParseError::Ok );
+    REQUIRE( order.getType() == sob::OrderType::Reprice );
+    REQUIRE( order.price == 1.5 );
+    REQUIRE( *order.oldId == 2 );
+    REQUIRE( *order.oldPx == 1.4 );
+    REQUIRE( *order.oldSz == 250 );
+
+    // the same order can be reused, no state leaks from the previous message
+    REQUIRE( sob::Order::parse( "N 7 1 20 1.45", order ) == sob::ParseError::Ok );
+    REQUIRE( order.getType() == sob::OrderType::Normal );
+    REQUIRE( !order.oldId );
+
+    REQUIRE( sob::Order::parse( "", order ) == sob::ParseError::Empty );
+    REQUIRE( sob::Order::parse( "X 1 0 10 1.0", order ) == sob::ParseError::UnknownType );
+    REQUIRE( sob::Order::parse( "N 1 0 10", order ) == sob::ParseError::MissingField );
+    REQUIRE( sob::Order::parse( "N 1 0 1x0 1.0", order ) == sob::ParseError::BadField );
+    REQUIRE( sob::Order::parse( "N 1 2 10 1.0", order ) == sob::ParseError::BadField );
+    REQUIRE( sob::Order::parse( "N 1 0 10 1.0 5", order ) == sob::ParseError::TrailingData );
+
+    REQUIRE_THROWS( sob::Order{ "N 1 0 10" } );
+}
+
+TEST_CASE("test_messages_typed_order", "1")
+{
+    // what the book makes its guesses of, without a message to parse
+    const sob::Order order{ -3, true, 250, sob::Price{ 1.45 } };
+    const sob::Order parsed{ "N -3 1 250 1.45" };
+    REQUIRE( order.getType() == sob::OrderType::Normal );
+    REQUIRE( order.toString() == parsed.toString() );
+    REQUIRE( order.to_simple_string() == parsed.to_simple_string() );
+    REQUIRE( !order.oldId );
+    REQUIRE( sob::Order{ 7, false, -20, sob::Price{ 1.3 } }.to_simple_string() == "N 7 0 -20 1.3" );
+}
+
+TEST_CASE("test_messages_resting_order", "1")
+{
+    STATIC_REQUIRE( std::is_trivially_copyable_v<sob::RestingOrder> );
+
+    const sob::Order order{ "N 3 1 50 1.3" };
+    const sob::RestingOrder resting{ order };
+    REQUIRE( resting.orderId == 3 );
+    REQUIRE( resting.isSell );
+    REQUIRE( resting.size == 50 );
+    REQUIRE( resting.price == 1.3 );
+    REQUIRE( resting.toString() == order.toString() );
+
+    // what rests of a reprice is the new order
+    const sob::Order reprice{ "R 6 0 250 1.5 2 1.4 250" };
+    REQUIRE( sob::RestingOrder{ reprice }.toString() == sob::Order{ "N 6 0 250 1.5" }.toString() );
+}
+
+TEST_CASE("test_messages_parse_trade", "1")
+{
+    sob::Trade trade;
+    REQUIRE( sob::Trade::parse( "T 1 0.9 10 1.1 5 1.2 30", trade ) == sob::ParseError::Ok );
+    REQUIRE( trade == sob::Trade{ "T 1 0.9 10 1.1 5 1.2 30" } );
+
+    // decoding into the same trade must not leave levels of the previous one behind
+    REQUIRE( sob::Trade::parse( "T 0 1.4 50 ", trade ) == sob::ParseError::Ok );
+    REQUIRE( trade.price == std::vector<sob::Price>{ 1.4 } );
+    REQUIRE( trade.volume == std::vector<int>{ 50 } );
+    REQUIRE( trade.isSell == false );
+
+    REQUIRE( sob::Trade::parse( "T 0 1.35 ", trade ) == sob::ParseError::MissingField );
+    // no level at all
+    REQUIRE( sob::Trade::parse( "T 1", trade ) == sob::ParseError::MissingField );
+    REQUIRE( sob::Trade::parse( "T 1  ", trade ) == sob::ParseError::MissingField );
+    REQUIRE_THROWS( sob::Trade{ "T 1" } );
+    REQUIRE( sob::Trade::parse( "S 0 1.35 5", trade ) == sob::ParseError::UnknownType );
+}
+
+TEST_CASE("test_messages_parse_snapshot", "1")
+{
+    sob::L2Book ob;
+    REQUIRE( sob::L2Book::parse( "S 3 3 1.0 5 1.1 2 1.2 10 1.3 20 1.4 5 1.5 6", ob ) == sob::ParseError::Ok );
+    REQUIRE( ob == sob::L2Book{ "S 3 3 1.0 5 1.1 2 1.2 10 1.3 20 1.4 5 1.5 6" } );
+
+    // fewer levels than the previous snapshot held
+    REQUIRE( sob::L2Book::parse( "S 2 1 1.2 100 1.3 150 1.4 50", ob ) == sob::ParseError::Ok );
+    REQUIRE( ob == sob::L2Book{ "S 2 1 1.2 100 1.3 150 1.4 50" } );
+    REQUIRE( ob.getBidSide().begin()->second == sob::L2PriceLevel( 1.3, 150 ) );
+    REQUIRE( ob.getAskSide().begin()->second == sob::L2PriceLevel( 1.4, 50 ) );
+
+    REQUIRE( sob::L2Book::parse( "S 2 1 1.2 100 1.3", ob ) == sob::ParseError::MissingField );
+    REQUIRE( sob::L2Book::parse( "S 1 0 1.2 100 7", ob ) == sob::ParseError::TrailingData );
+    REQUIRE( sob::L2Book::parse( "S 1 0 1.2 100 ", ob ) == sob::ParseError::Ok );
+    REQUIRE( ob.getBidSideDepth() == 1 );
+    REQUIRE( ob.getAskSideDepth() == 0 );
+}